@@ -0,0 +1,277 @@
+/*
+ * Channelizer.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "Channelizer.h"
+#include "DemodEngine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <new>
+#include <type_traits>
+
+namespace {
+
+//Kernel samples at either end carrying less than this fraction of its total magnitude are dropped
+const double TRIM_FRACTION = 1e-7;
+
+void dot_scalar(const float * samples, const float * kernelReal, const float * kernelImag, const size_t & length,
+		double & sumReal, double & sumImag) {
+	for (size_t n = 0; n < length; n++) {
+		sumReal += samples[n] * kernelReal[n];
+		sumImag += samples[n] * kernelImag[n];
+	}
+}
+
+#ifdef KERNELS_X86
+KERNELS_AVX2 inline double horizontal_sum(const __m256 & sum) {
+	float lanes[8];
+	_mm256_storeu_ps(lanes, sum);
+	double total = 0;
+	for (int lane = 0; lane < 8; lane++) {
+		total += lanes[lane];
+	}
+	return total;
+}
+
+//Each load of samples feeds both the real and imaginary sums
+KERNELS_AVX2 void dot_avx2(const float * samples, const float * kernelReal, const float * kernelImag, const size_t & length,
+		double & sumReal, double & sumImag) {
+	__m256 real0 = _mm256_setzero_ps(), real1 = _mm256_setzero_ps();
+	__m256 imag0 = _mm256_setzero_ps(), imag1 = _mm256_setzero_ps();
+	size_t n = 0;
+	for (; n + 16 <= length; n += 16) {
+		__m256 x0 = _mm256_loadu_ps(samples + n);
+		__m256 x1 = _mm256_loadu_ps(samples + n + 8);
+		real0 = _mm256_fmadd_ps(x0, _mm256_loadu_ps(kernelReal + n), real0);
+		real1 = _mm256_fmadd_ps(x1, _mm256_loadu_ps(kernelReal + n + 8), real1);
+		imag0 = _mm256_fmadd_ps(x0, _mm256_loadu_ps(kernelImag + n), imag0);
+		imag1 = _mm256_fmadd_ps(x1, _mm256_loadu_ps(kernelImag + n + 8), imag1);
+	}
+	for (; n + 8 <= length; n += 8) {
+		__m256 x0 = _mm256_loadu_ps(samples + n);
+		real0 = _mm256_fmadd_ps(x0, _mm256_loadu_ps(kernelReal + n), real0);
+		imag0 = _mm256_fmadd_ps(x0, _mm256_loadu_ps(kernelImag + n), imag0);
+	}
+	sumReal = horizontal_sum(_mm256_add_ps(real0, real1));
+	sumImag = horizontal_sum(_mm256_add_ps(imag0, imag1));
+	dot_scalar(samples + n, kernelReal + n, kernelImag + n, length - n, sumReal, sumImag);
+}
+#endif
+
+#ifdef KERNELS_NEON
+inline double horizontal_sum(const float32x4_t & sum) {
+	float lanes[4];
+	vst1q_f32(lanes, sum);
+	return static_cast<double>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+}
+
+void dot_neon(const float * samples, const float * kernelReal, const float * kernelImag, const size_t & length,
+		double & sumReal, double & sumImag) {
+	float32x4_t real0 = vdupq_n_f32(0), real1 = vdupq_n_f32(0);
+	float32x4_t imag0 = vdupq_n_f32(0), imag1 = vdupq_n_f32(0);
+	size_t n = 0;
+	for (; n + 8 <= length; n += 8) {
+		float32x4_t x0 = vld1q_f32(samples + n);
+		float32x4_t x1 = vld1q_f32(samples + n + 4);
+#ifdef __aarch64__
+		real0 = vfmaq_f32(real0, x0, vld1q_f32(kernelReal + n));
+		real1 = vfmaq_f32(real1, x1, vld1q_f32(kernelReal + n + 4));
+		imag0 = vfmaq_f32(imag0, x0, vld1q_f32(kernelImag + n));
+		imag1 = vfmaq_f32(imag1, x1, vld1q_f32(kernelImag + n + 4));
+#else
+		real0 = vmlaq_f32(real0, x0, vld1q_f32(kernelReal + n));
+		real1 = vmlaq_f32(real1, x1, vld1q_f32(kernelReal + n + 4));
+		imag0 = vmlaq_f32(imag0, x0, vld1q_f32(kernelImag + n));
+		imag1 = vmlaq_f32(imag1, x1, vld1q_f32(kernelImag + n + 4));
+#endif
+	}
+	sumReal = horizontal_sum(vaddq_f32(real0, real1));
+	sumImag = horizontal_sum(vaddq_f32(imag0, imag1));
+	dot_scalar(samples + n, kernelReal + n, kernelImag + n, length - n, sumReal, sumImag);
+}
+#endif
+
+void dot(const float * samples, const float * kernelReal, const float * kernelImag, const size_t & length,
+		double & sumReal, double & sumImag) {
+	sumReal = 0;
+	sumImag = 0;
+#if defined(KERNELS_X86)
+	if (KernelSupport::has_avx2()) {
+		dot_avx2(samples, kernelReal, kernelImag, length, sumReal, sumImag);
+		return;
+	}
+#elif defined(KERNELS_NEON)
+	dot_neon(samples, kernelReal, kernelImag, length, sumReal, sumImag);
+	return;
+#endif
+	dot_scalar(samples, kernelReal, kernelImag, length, sumReal, sumImag);
+}
+
+}
+
+Channelizer::Channelizer() : recordLength_(0), begin_(0), end_(0) {};
+
+int Channelizer::init(const vector<ChannelParams> & channels, const double & samplingRate, const size_t & recordLength) {
+	if (channels.empty()) {
+		return DEMOD_INVALID_PARAMS;
+	}
+	recordLength_ = recordLength;
+	begin_ = recordLength;
+	end_ = 0;
+	kernels_.clear();
+	scratch_.clear();
+
+	for (const ChannelParams & channel : channels) {
+		DemodEngine engine;
+		DemodParams params = {channel.IFfreq, channel.bandwidth, samplingRate};
+		int status = engine.init(params, recordLength);
+		if (status != DEMOD_OK) {
+			return status;
+		}
+
+		//DigitalHomodyne keeps rows max(1,floor(boxCarStart/decimFactor)):floor(boxCarStop/decimFactor)
+		double decimFactor = engine.decim_factor();
+		double firstRow = std::max(1.0, std::floor(channel.boxCarStart / decimFactor));
+		double lastRow = std::floor(channel.boxCarStop / decimFactor);
+		if (!(lastRow >= firstRow) || lastRow > engine.output_length()) {
+			return DEMOD_INVALID_PARAMS;
+		}
+		vector<std::complex<double> > weights(engine.output_length(), 0.0);
+		std::complex<double> weight = 2.0 * std::polar(1.0, channel.phase) / (lastRow - firstRow + 1);
+		for (size_t row = firstRow - 1; row < lastRow; row++) {
+			weights[row] = weight;
+		}
+		vector<std::complex<double> > kernel;
+		engine.integration_kernel(weights, kernel);
+
+		//The IIR filter leaves a decaying tail before the window; keep only what matters in single precision
+		double total = 0;
+		for (const std::complex<double> & value : kernel) {
+			total += std::abs(value);
+		}
+		double dropped = 0;
+		size_t start = 0;
+		while (start < recordLength && (dropped += std::abs(kernel[start])) <= 0.5 * TRIM_FRACTION * total) start++;
+		dropped = 0;
+		size_t stop = recordLength;
+		while (stop > start && (dropped += std::abs(kernel[stop-1])) <= 0.5 * TRIM_FRACTION * total) stop--;
+
+		Kernel trimmed;
+		trimmed.start = start;
+		trimmed.real.resize(stop - start);
+		trimmed.imag.resize(stop - start);
+		trimmed.sumReal = 0;
+		trimmed.sumImag = 0;
+		for (size_t n = start; n < stop; n++) {
+			trimmed.real[n - start] = kernel[n].real();
+			trimmed.imag[n - start] = kernel[n].imag();
+			trimmed.sumReal += trimmed.real[n - start];
+			trimmed.sumImag += trimmed.imag[n - start];
+		}
+		kernels_.push_back(std::move(trimmed));
+		begin_ = std::min(begin_, start);
+		end_ = std::max(end_, stop);
+	}
+	begin_ = std::min(begin_, end_);
+	return DEMOD_OK;
+}
+
+template <typename T>
+void Channelizer::execute(const T * records, const size_t & numRecords, float * outReal, float * outImag,
+		const float & scale, const float & offset) {
+	size_t workLength = end_ - begin_;
+	for (const Kernel & kernel : kernels_) {
+		workLength += kernel.real.size();
+	}
+	size_t numChunks = KernelSupport::num_chunks(numRecords, workLength);
+	while (scratch_.size() < numChunks) {
+		scratch_.emplace_back(end_ - begin_);
+	}
+	const size_t numChannels = kernels_.size();
+	KernelSupport::parallel_for_chunks(numRecords, numChunks, [&](size_t chunk, size_t begin, size_t end) {
+		for (size_t ct = begin; ct < end; ct++) {
+			//Load the part of the record any window needs once; scale and offset are applied to the sums
+			const T * record = records + ct*recordLength_ + begin_;
+			const float * samples;
+			if (std::is_same<T, float>::value) {
+				samples = reinterpret_cast<const float *>(record);
+			} else {
+				float * converted = scratch_[chunk].data();
+				for (size_t n = 0; n < end_ - begin_; n++) {
+					converted[n] = static_cast<float>(record[n]);
+				}
+				samples = converted;
+			}
+			for (size_t channel = 0; channel < numChannels; channel++) {
+				const Kernel & kernel = kernels_[channel];
+				double sumReal, sumImag;
+				dot(samples + kernel.start - begin_, kernel.real.data(), kernel.imag.data(), kernel.real.size(), sumReal, sumImag);
+				outReal[ct*numChannels + channel] = scale*sumReal + offset*kernel.sumReal;
+				outImag[ct*numChannels + channel] = scale*sumImag + offset*kernel.sumImag;
+			}
+		}
+	});
+}
+
+template void Channelizer::execute<float>(const float *, const size_t &, float *, float *, const float &, const float &);
+template void Channelizer::execute<double>(const double *, const size_t &, float *, float *, const float &, const float &);
+template void Channelizer::execute<uint8_t>(const uint8_t *, const size_t &, float *, float *, const float &, const float &);
+
+//C interface
+struct ChannelizerPlan {
+	Channelizer channelizer;
+};
+
+ChannelizerPlan * channelizer_plan_create(const ChannelParams * channels, size_t numChannels, double samplingRate,
+		size_t recordLength, int * status) {
+	int result = DEMOD_INVALID_PARAMS;
+	ChannelizerPlan * plan = nullptr;
+	if (channels != nullptr) {
+		try {
+			plan = new ChannelizerPlan;
+			result = plan->channelizer.init(vector<ChannelParams>(channels, channels + numChannels), samplingRate, recordLength);
+		} catch (std::bad_alloc &) {
+			result = DEMOD_UNKNOWN_ERROR;
+		}
+		if (result != DEMOD_OK) {
+			delete plan;
+			plan = nullptr;
+		}
+	}
+	if (status != nullptr) *status = result;
+	return plan;
+}
+
+void channelizer_plan_destroy(ChannelizerPlan * plan) {
+	delete plan;
+}
+
+namespace {
+
+template <typename T>
+int execute_plan(ChannelizerPlan * plan, const T * records, size_t numRecords, float scale, float offset, float * outReal, float * outImag) {
+	if (plan == nullptr || records == nullptr || outReal == nullptr || outImag == nullptr) {
+		return DEMOD_INVALID_PARAMS;
+	}
+	try {
+		plan->channelizer.execute(records, numRecords, outReal, outImag, scale, offset);
+	} catch (std::bad_alloc &) {
+		return DEMOD_UNKNOWN_ERROR;
+	}
+	return DEMOD_OK;
+}
+
+}
+
+int channelizer_plan_execute(ChannelizerPlan * plan, const float * records, size_t numRecords, float * outReal, float * outImag) {
+	return execute_plan(plan, records, numRecords, 1, 0, outReal, outImag);
+}
+
+int channelizer_plan_execute_u8(ChannelizerPlan * plan, const uint8_t * records, size_t numRecords, float scale, float offset,
+		float * outReal, float * outImag) {
+	return execute_plan(plan, records, numRecords, scale, offset, outReal, outImag);
+}
@@ -0,0 +1,62 @@
+/*
+ * Channelizer.h
+ *
+ * Integrated readout of several frequency multiplexed channels from the same records.
+ * Each channel gives the value DigitalHomodyne would: digitalDemod at the channel's IFfreq and bandwidth,
+ * averaged over its boxcar window, times 2*exp(1i*phase). All of those steps are linear in the record, so
+ * init() walks each channel's demodulation backwards (DemodEngine::integration_kernel) to a single complex
+ * kernel over the samples its window depends on. execute() then converts each record once into a per-thread
+ * buffer and every channel is a dot product with that buffer, costing two multiply-adds per sample of
+ * its window instead of a full demodulation of the record.
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef CHANNELIZER_H_
+#define CHANNELIZER_H_
+
+#include "demod.h"
+#include "../util/kernelSupport.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using std::vector;
+using KernelSupport::AlignedVector;
+
+class Channelizer {
+public:
+	Channelizer();
+
+	int init(const vector<ChannelParams> & channels, const double & samplingRate, const size_t & recordLength);
+
+	size_t num_channels() const {return kernels_.size();};
+	size_t record_length() const {return recordLength_;};
+
+	//Each input sample is scale*sample + offset; outputs hold num_channels() values per record with the channels together
+	template <typename T>
+	void execute(const T * records, const size_t & numRecords, float * outReal, float * outImag,
+			const float & scale = 1, const float & offset = 0);
+
+private:
+	struct Kernel {
+		//Samples [start, start + real.size()) of the record
+		size_t start;
+		AlignedVector real;
+		AlignedVector imag;
+		//What a constant offset on every sample adds
+		double sumReal;
+		double sumImag;
+	};
+
+	//Samples [begin_, end_) are covered by at least one kernel
+	size_t recordLength_;
+	size_t begin_;
+	size_t end_;
+	vector<Kernel> kernels_;
+	//One buffer of end_ - begin_ samples per thread execute() has used
+	vector<AlignedVector> scratch_;
+};
+
+#endif /* CHANNELIZER_H_ */
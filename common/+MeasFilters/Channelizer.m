@@ -0,0 +1,154 @@
+% Shares one pass over the raw records between the MultiplexedHomodyne
+% filters of qubits read out at different IF frequencies on the same
+% digitizer channel. Each filter adds its channel here; the first one to
+% ask for a new buffer integrates every channel at once with the native
+% channelizerPlan (or digitalDemod per channel when that isn't built) and
+% the others pick up their rows. MultiplexedHomodyne filters get the
+% shared channelizer for their digitizer channel and sampling rate, so
+% with M1 and M2 both on ch1 at 500 MS/s these share Channelizer.shared('ch1', 500e6):
+% q1 = MeasFilters.MultiplexedHomodyne(measSettings.M1);
+% q2 = MeasFilters.MultiplexedHomodyne(measSettings.M2);
+
+% Copyright 2013 Raytheon BBN Technologies
+%
+% Licensed under the Apache License, Version 2.0 (the "License");
+% you may not use this file except in compliance with the License.
+% You may obtain a copy of the License at
+%
+%     http://www.apache.org/licenses/LICENSE-2.0
+%
+% Unless required by applicable law or agreed to in writing, software
+% distributed under the License is distributed on an "AS IS" BASIS,
+% WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+% See the License for the specific language governing permissions and
+% limitations under the License.
+classdef Channelizer < handle
+
+    properties (SetAccess = private)
+        samplingRate
+        IFfreqs = []
+        bandwidths = []
+        boxCarStarts = []
+        boxCarStops = []
+        phases = []
+        plan = []
+        planRecordLength = 0
+        %Ids handed out by add_channel, one per row of values
+        channelIds = []
+        nextId = 1
+        values
+        %Tag of the buffer values were integrated from
+        lastBuffer = []
+    end
+
+    methods
+        function obj = Channelizer(samplingRate)
+            obj.samplingRate = samplingRate;
+        end
+
+        function delete(obj)
+            obj.destroy_plan();
+        end
+
+        function id = add_channel(obj, IFfreq, bandwidth, boxCarStart, boxCarStop, phase)
+            obj.IFfreqs(end+1) = IFfreq;
+            obj.bandwidths(end+1) = bandwidth;
+            obj.boxCarStarts(end+1) = boxCarStart;
+            obj.boxCarStops(end+1) = boxCarStop;
+            obj.phases(end+1) = phase;
+            id = obj.nextId;
+            obj.nextId = obj.nextId + 1;
+            obj.channelIds(end+1) = id;
+            obj.channels_changed();
+        end
+
+        function remove_channel(obj, id)
+            keep = (obj.channelIds ~= id);
+            obj.IFfreqs = obj.IFfreqs(keep);
+            obj.bandwidths = obj.bandwidths(keep);
+            obj.boxCarStarts = obj.boxCarStarts(keep);
+            obj.boxCarStops = obj.boxCarStops(keep);
+            obj.phases = obj.phases(keep);
+            obj.channelIds = obj.channelIds(keep);
+            obj.channels_changed();
+        end
+
+        function out = result(obj, id, data, bufferct)
+            %Every filter on the channel gets the same buffer, so integrate
+            %when a new one arrives and hand the rest their rows. Buffers
+            %are told apart by ExpManager's buffer count rather than by
+            %counting calls so a filter that skipped a buffer doesn't get
+            %stale values; without a count the size and a few samples of
+            %the records stand in for it.
+            if nargin < 4 || isempty(bufferct)
+                bufferTag = MeasFilters.Channelizer.fingerprint(data);
+            else
+                bufferTag = bufferct;
+            end
+            if isempty(obj.values) || ~isequal(bufferTag, obj.lastBuffer)
+                obj.values = obj.integrate(data);
+                obj.lastBuffer = bufferTag;
+            end
+            dims = size(obj.values);
+            out = reshape(obj.values(obj.channelIds == id,:), [1 dims(2:end)]);
+        end
+    end
+
+    methods (Static)
+        function chz = shared(channel, samplingRate)
+            %The channelizer for a digitizer channel ('ch1', 'ch2') and sampling rate
+            persistent registry
+            if isempty(registry)
+                registry = containers.Map();
+            end
+            key = sprintf('%s_%g', channel, samplingRate);
+            if ~isKey(registry, key) || ~isvalid(registry(key))
+                registry(key) = MeasFilters.Channelizer(samplingRate);
+            end
+            chz = registry(key);
+        end
+    end
+
+    methods (Static, Access = private)
+        function tag = fingerprint(data)
+            %Size plus a handful of samples spread over the buffer
+            idx = unique(round(linspace(1, numel(data), min(8, numel(data)))));
+            tag = {size(data), data(idx)};
+        end
+    end
+
+    methods (Access = private)
+        function values = integrate(obj, data)
+            if MeasFilters.mex_built('channelizerPlan')
+                if isempty(obj.plan) || obj.planRecordLength ~= size(data,1)
+                    obj.destroy_plan();
+                    obj.plan = MeasFilters.channelizerPlan('create', obj.IFfreqs, obj.bandwidths, ...
+                        obj.boxCarStarts, obj.boxCarStops, obj.phases, obj.samplingRate, size(data,1));
+                    obj.planRecordLength = size(data,1);
+                end
+                values = MeasFilters.channelizerPlan('execute', obj.plan, data);
+            else
+                dims = size(data);
+                values = complex(zeros([length(obj.IFfreqs) dims(2:end)], 'single'));
+                for ct = 1:length(obj.IFfreqs)
+                    [demodSignal, decimFactor] = MeasFilters.digitalDemod(data, obj.IFfreqs(ct), obj.bandwidths(ct), obj.samplingRate);
+                    demodSignal = demodSignal(max(1,floor(obj.boxCarStarts(ct)/decimFactor)):floor(obj.boxCarStops(ct)/decimFactor),:);
+                    values(ct,:) = exp(1j*obj.phases(ct)) * 2 * mean(demodSignal,1);
+                end
+            end
+        end
+
+        function channels_changed(obj)
+            obj.destroy_plan();
+            obj.values = [];
+            obj.lastBuffer = [];
+        end
+
+        function destroy_plan(obj)
+            if ~isempty(obj.plan)
+                MeasFilters.channelizerPlan('destroy', obj.plan);
+                obj.plan = [];
+            end
+        end
+    end
+end
@@ -0,0 +1,373 @@
+/*
+ * DemodEngine.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "DemodEngine.h"
+#include "butterTable.h"
+#include "../util/kernelSupport.h"
+
+#include <algorithm>
+#include <cmath>
+#include <new>
+#include <type_traits>
+
+namespace {
+
+//M_PI needs _USE_MATH_DEFINES on MSVC
+const double pi = 3.14159265358979323846;
+
+/*
+ * Low-pass with MATLAB's filter (direct form II transposed) and keep every FINAL_DECIM_FACTOR'th sample
+ * The state is kept in double since the narrowest designs have coefficients down at 1e-11
+ * source(n, re, im) gives complex input sample n
+ */
+template <int ORDER, typename Source>
+void iir_decimate(Source source, const size_t & length, const double * b, const double * a, float * outReal, float * outImag) {
+	double stateReal[ORDER] = {0};
+	double stateImag[ORDER] = {0};
+	for (size_t n = 0; n < length; n++) {
+		float inReal, inImag;
+		source(n, inReal, inImag);
+		double yReal = b[0]*inReal + stateReal[0];
+		double yImag = b[0]*inImag + stateImag[0];
+		for (int k = 0; k < ORDER-1; k++) {
+			stateReal[k] = b[k+1]*inReal + stateReal[k+1] - a[k+1]*yReal;
+			stateImag[k] = b[k+1]*inImag + stateImag[k+1] - a[k+1]*yImag;
+		}
+		stateReal[ORDER-1] = b[ORDER]*inReal - a[ORDER]*yReal;
+		stateImag[ORDER-1] = b[ORDER]*inImag - a[ORDER]*yImag;
+		if (n % DemodEngine::FINAL_DECIM_FACTOR == 0) {
+			outReal[n / DemodEngine::FINAL_DECIM_FACTOR] = yReal;
+			outImag[n / DemodEngine::FINAL_DECIM_FACTOR] = yImag;
+		}
+	}
+}
+
+template <typename Source>
+void iir_decimate(const int & order, Source source, const size_t & length, const double * b, const double * a, float * outReal, float * outImag) {
+	switch (order) {
+	case 1:
+		iir_decimate<1>(source, length, b, a, outReal, outImag);
+		break;
+	case 2:
+		iir_decimate<2>(source, length, b, a, outReal, outImag);
+		break;
+	case 3:
+		iir_decimate<3>(source, length, b, a, outReal, outImag);
+		break;
+	case 4:
+		iir_decimate<4>(source, length, b, a, outReal, outImag);
+		break;
+	default:
+		iir_decimate<5>(source, length, b, a, outReal, outImag);
+		break;
+	}
+}
+
+//filter() run backwards in time, the transpose of filtering a record from rest
+template <int ORDER>
+void iir_reversed(double * samples, const size_t & length, const double * b, const double * a) {
+	double state[ORDER] = {0};
+	for (size_t n = length; n-- > 0; ) {
+		double in = samples[n];
+		double y = b[0]*in + state[0];
+		for (int k = 0; k < ORDER-1; k++) {
+			state[k] = b[k+1]*in + state[k+1] - a[k+1]*y;
+		}
+		state[ORDER-1] = b[ORDER]*in - a[ORDER]*y;
+		samples[n] = y;
+	}
+}
+
+void iir_reversed(const int & order, double * samples, const size_t & length, const double * b, const double * a) {
+	switch (order) {
+	case 1:
+		iir_reversed<1>(samples, length, b, a);
+		break;
+	case 2:
+		iir_reversed<2>(samples, length, b, a);
+		break;
+	case 3:
+		iir_reversed<3>(samples, length, b, a);
+		break;
+	case 4:
+		iir_reversed<4>(samples, length, b, a);
+		break;
+	default:
+		iir_reversed<5>(samples, length, b, a);
+		break;
+	}
+}
+
+}
+
+const size_t DemodEngine::FINAL_DECIM_FACTOR;
+
+DemodEngine::DemodEngine() : recordLength_(0), decimFactor1_(1), decimFactor2_(1), length1_(0), length2_(0), outputLength_(0), IIROrder_(0), scratchLength_(0) {};
+
+int DemodEngine::init(const DemodParams & params, const size_t & recordLength) {
+	/*
+	 * Plan the stages the way digitalDemod.m does
+	 */
+	if (!(params.samplingRate > 0) || !(params.bandwidth > 0) || !(params.IFfreq >= 0)) {
+		return DEMOD_INVALID_PARAMS;
+	}
+	recordLength_ = recordLength;
+
+	//normalize frequencies to Nyquist
+	double nbandwidth = params.bandwidth / (params.samplingRate/2);
+	double nIFfreq = params.IFfreq / (params.samplingRate/2);
+
+	//Decimate first as long as the 2*omega signal won't alias when we mix down
+	decimFactor1_ = std::max(1.0, std::floor(0.45 / (2*nIFfreq + nbandwidth/2)));
+	nbandwidth *= decimFactor1_;
+	nIFfreq *= decimFactor1_;
+	length1_ = recordLength / decimFactor1_;
+
+	//The IIR filter is unstable below a normalized bandwidth of 0.05 so decimate again
+	decimFactor2_ = (nbandwidth < 0.05) ? std::ceil(0.05 / nbandwidth) : 1;
+	nbandwidth *= decimFactor2_;
+	length2_ = length1_ / decimFactor2_;
+
+	if (nbandwidth >= 1) {
+		return DEMOD_BANDWIDTH_TOO_WIDE;
+	}
+	if (length2_ == 0) {
+		return DEMOD_RECORD_TOO_SHORT;
+	}
+	outputLength_ = (length2_ + FINAL_DECIM_FACTOR - 1) / FINAL_DECIM_FACTOR;
+	scratch_.clear();
+
+	decimator1_.init(PolyDecimator::lowpass_taps(decimFactor1_), decimFactor1_, recordLength);
+	decimator2_.init(PolyDecimator::lowpass_taps(decimFactor2_), decimFactor2_, length1_);
+
+	refReal_.resize(length1_);
+	refImag_.resize(length1_);
+	for (size_t n = 0; n < length1_; n++) {
+		double phase = pi * nIFfreq * (n+1);
+		refReal_[n] = std::cos(phase);
+		refImag_[n] = -std::sin(phase);
+	}
+
+	//Same row as my_butter and rounded to single like it
+	int row = std::max(0, std::min(ButterTable::NUM_ROWS, static_cast<int>(std::floor(nbandwidth*100))) - 1);
+	IIROrder_ = ButterTable::rows[row].order;
+	for (int ct = 0; ct <= ButterTable::MAX_ORDER; ct++) {
+		IIRb_[ct] = static_cast<float>(ButterTable::rows[row].b[ct]);
+		IIRa_[ct] = static_cast<float>(ButterTable::rows[row].a[ct]);
+	}
+	scratchLength_ = 3*length1_ + 2*length2_ + std::max(decimator1_.scratch_length(), decimator2_.scratch_length());
+	return DEMOD_OK;
+}
+
+template <typename T>
+void DemodEngine::execute_record(const T * record, const float & scale, const float & offset, float * scratch,
+		float * outReal, float * outImag) const {
+	//Scratch is laid out as [first stage output | mixed real | mixed imag | second stage real | second stage imag | decimator scratch]
+	float * stage1 = scratch;
+	float * mixedReal = stage1 + length1_;
+	float * mixedImag = mixedReal + length1_;
+	float * stage2Real = mixedImag + length1_;
+	float * stage2Imag = stage2Real + length2_;
+	float * decimatorScratch = stage2Imag + length2_;
+
+	const float * samples;
+	if (decimFactor1_ > 1) {
+		decimator1_.decimate_record(record, stage1, decimatorScratch, scale, offset);
+		samples = stage1;
+	} else if (std::is_same<T, float>::value && scale == 1 && offset == 0) {
+		samples = reinterpret_cast<const float *>(record);
+	} else {
+		for (size_t n = 0; n < length1_; n++) {
+			stage1[n] = scale * static_cast<float>(record[n]) + offset;
+		}
+		samples = stage1;
+	}
+
+	const float * refReal = refReal_.data();
+	const float * refImag = refImag_.data();
+	if (decimFactor2_ > 1) {
+		for (size_t n = 0; n < length1_; n++) {
+			mixedReal[n] = samples[n] * refReal[n];
+			mixedImag[n] = samples[n] * refImag[n];
+		}
+		decimator2_.decimate_record(mixedReal, mixedImag, stage2Real, stage2Imag, decimatorScratch);
+		iir_decimate(IIROrder_, [=](size_t n, float & re, float & im) {re = stage2Real[n]; im = stage2Imag[n];},
+				length2_, IIRb_, IIRa_, outReal, outImag);
+	} else {
+		//Mix on the fly
+		iir_decimate(IIROrder_, [=](size_t n, float & re, float & im) {re = samples[n] * refReal[n]; im = samples[n] * refImag[n];},
+				length1_, IIRb_, IIRa_, outReal, outImag);
+	}
+}
+
+template <typename T>
+void DemodEngine::execute(const T * records, const size_t & numRecords, float * outReal, float * outImag,
+		const float & scale, const float & offset) {
+	size_t numChunks = KernelSupport::num_chunks(numRecords, recordLength_);
+	while (scratch_.size() < numChunks) {
+		scratch_.emplace_back(scratchLength_);
+	}
+	KernelSupport::parallel_for_chunks(numRecords, numChunks, [&](size_t chunk, size_t begin, size_t end) {
+		float * scratch = scratch_[chunk].data();
+		for (size_t ct = begin; ct < end; ct++) {
+			execute_record(records + ct*recordLength_, scale, offset, scratch, outReal + ct*outputLength_, outImag + ct*outputLength_);
+		}
+	});
+}
+
+void DemodEngine::integration_kernel(const vector<std::complex<double> > & weights, vector<std::complex<double> > & kernel) const {
+	//Walk the stages of execute_record backwards
+	vector<double> stageReal(length2_, 0.0), stageImag(length2_, 0.0);
+	for (size_t m = 0; m < outputLength_; m++) {
+		stageReal[m * FINAL_DECIM_FACTOR] = weights[m].real();
+		stageImag[m * FINAL_DECIM_FACTOR] = weights[m].imag();
+	}
+	iir_reversed(IIROrder_, stageReal.data(), length2_, IIRb_, IIRa_);
+	iir_reversed(IIROrder_, stageImag.data(), length2_, IIRb_, IIRa_);
+
+	if (decimFactor2_ > 1) {
+		vector<double> upReal(length1_), upImag(length1_);
+		decimator2_.transpose_record(stageReal.data(), upReal.data());
+		decimator2_.transpose_record(stageImag.data(), upImag.data());
+		stageReal.swap(upReal);
+		stageImag.swap(upImag);
+	}
+
+	//The record is real so mixing folds the reference into the kernel
+	for (size_t n = 0; n < length1_; n++) {
+		std::complex<double> mixed = std::complex<double>(stageReal[n], stageImag[n]) * std::complex<double>(refReal_[n], refImag_[n]);
+		stageReal[n] = mixed.real();
+		stageImag[n] = mixed.imag();
+	}
+
+	kernel.resize(recordLength_);
+	if (decimFactor1_ > 1) {
+		vector<double> upReal(recordLength_), upImag(recordLength_);
+		decimator1_.transpose_record(stageReal.data(), upReal.data());
+		decimator1_.transpose_record(stageImag.data(), upImag.data());
+		stageReal.swap(upReal);
+		stageImag.swap(upImag);
+	}
+	for (size_t n = 0; n < recordLength_; n++) {
+		kernel[n] = std::complex<double>(stageReal[n], stageImag[n]);
+	}
+}
+
+template void DemodEngine::execute<float>(const float *, const size_t &, float *, float *, const float &, const float &);
+template void DemodEngine::execute<double>(const double *, const size_t &, float *, float *, const float &, const float &);
+template void DemodEngine::execute<uint8_t>(const uint8_t *, const size_t &, float *, float *, const float &, const float &);
+
+//C interface
+namespace {
+
+template <typename T>
+int demod(const DemodParams * params, const T * records, size_t recordLength, size_t numRecords,
+		float scale, float offset, float * outReal, float * outImag) {
+	if (params == nullptr || records == nullptr || outReal == nullptr || outImag == nullptr) {
+		return DEMOD_INVALID_PARAMS;
+	}
+	try {
+		DemodEngine engine;
+		int status = engine.init(*params, recordLength);
+		if (status != DEMOD_OK) {
+			return status;
+		}
+		engine.execute(records, numRecords, outReal, outImag, scale, offset);
+	} catch (std::bad_alloc &) {
+		return DEMOD_UNKNOWN_ERROR;
+	}
+	return DEMOD_OK;
+}
+
+}
+
+int demod_output_length(const DemodParams * params, size_t recordLength, size_t * outputLength, size_t * decimFactor) {
+	if (params == nullptr) {
+		return DEMOD_INVALID_PARAMS;
+	}
+	DemodEngine engine;
+	int status = engine.init(*params, recordLength);
+	if (status != DEMOD_OK) {
+		return status;
+	}
+	if (outputLength != nullptr) *outputLength = engine.output_length();
+	if (decimFactor != nullptr) *decimFactor = engine.decim_factor();
+	return DEMOD_OK;
+}
+
+int demod_records(const DemodParams * params, const float * records, size_t recordLength, size_t numRecords, float * outReal, float * outImag) {
+	return demod(params, records, recordLength, numRecords, 1, 0, outReal, outImag);
+}
+
+int demod_records_u8(const DemodParams * params, const uint8_t * records, size_t recordLength, size_t numRecords,
+		float scale, float offset, float * outReal, float * outImag) {
+	return demod(params, records, recordLength, numRecords, scale, offset, outReal, outImag);
+}
+
+struct DemodPlan {
+	DemodEngine engine;
+};
+
+DemodPlan * demod_plan_create(const DemodParams * params, size_t recordLength, int * status) {
+	int result = DEMOD_INVALID_PARAMS;
+	DemodPlan * plan = nullptr;
+	if (params != nullptr) {
+		try {
+			plan = new DemodPlan;
+			result = plan->engine.init(*params, recordLength);
+		} catch (std::bad_alloc &) {
+			result = DEMOD_UNKNOWN_ERROR;
+		}
+		if (result != DEMOD_OK) {
+			delete plan;
+			plan = nullptr;
+		}
+	}
+	if (status != nullptr) *status = result;
+	return plan;
+}
+
+void demod_plan_destroy(DemodPlan * plan) {
+	delete plan;
+}
+
+size_t demod_plan_record_length(const DemodPlan * plan) {
+	return (plan == nullptr) ? 0 : plan->engine.record_length();
+}
+
+size_t demod_plan_output_length(const DemodPlan * plan) {
+	return (plan == nullptr) ? 0 : plan->engine.output_length();
+}
+
+size_t demod_plan_decim_factor(const DemodPlan * plan) {
+	return (plan == nullptr) ? 0 : plan->engine.decim_factor();
+}
+
+namespace {
+
+template <typename T>
+int execute_plan(DemodPlan * plan, const T * records, size_t numRecords, float scale, float offset, float * outReal, float * outImag) {
+	if (plan == nullptr || records == nullptr || outReal == nullptr || outImag == nullptr) {
+		return DEMOD_INVALID_PARAMS;
+	}
+	try {
+		plan->engine.execute(records, numRecords, outReal, outImag, scale, offset);
+	} catch (std::bad_alloc &) {
+		return DEMOD_UNKNOWN_ERROR;
+	}
+	return DEMOD_OK;
+}
+
+}
+
+int demod_plan_execute(DemodPlan * plan, const float * records, size_t numRecords, float * outReal, float * outImag) {
+	return execute_plan(plan, records, numRecords, 1, 0, outReal, outImag);
+}
+
+int demod_plan_execute_u8(DemodPlan * plan, const uint8_t * records, size_t numRecords, float scale, float offset,
+		float * outReal, float * outImag) {
+	return execute_plan(plan, records, numRecords, scale, offset, outReal, outImag);
+}
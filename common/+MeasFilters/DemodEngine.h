@@ -0,0 +1,77 @@
+/*
+ * DemodEngine.h
+ *
+ * Native version of digitalDemod.m. init() plans the stages once for a record length (decimation
+ * factors, the polyphase decimators, the mixing reference and the Butterworth coefficients) and execute()
+ * runs them on each record in one pass through per-thread scratch buffers that stay in cache.
+ * Records are spread across hardware threads.
+ * An initialized engine is the plan behind demod_plan_create() and demodPlan: the scratch is allocated by the
+ * first execute() and reused after that, so an instance runs one execute() at a time.
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef DEMODENGINE_H_
+#define DEMODENGINE_H_
+
+#include "demod.h"
+#include "PolyDecimator.h"
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using std::vector;
+
+class DemodEngine {
+public:
+	//digitalDemod.m keeps every 8th sample of the low-passed signal
+	static const size_t FINAL_DECIM_FACTOR = 8;
+
+	DemodEngine();
+
+	int init(const DemodParams &, const size_t & recordLength);
+
+	size_t record_length() const {return recordLength_;};
+	size_t output_length() const {return outputLength_;};
+	size_t decim_factor() const {return decimFactor1_ * decimFactor2_ * FINAL_DECIM_FACTOR;};
+
+	//Each input sample is scale*sample + offset; outputs hold numRecords*output_length() samples
+	template <typename T>
+	void execute(const T * records, const size_t & numRecords, float * outReal, float * outImag,
+			const float & scale = 1, const float & offset = 0);
+
+	//The transpose of execute() on one record: the kernel for which sum_n kernel[n]*record[n] equals
+	//sum_m weights[m]*demodSignal[m], so any weighted sum of the demodulated signal is one dot product with the record
+	void integration_kernel(const vector<std::complex<double> > & weights, vector<std::complex<double> > & kernel) const;
+
+private:
+	template <typename T>
+	void execute_record(const T * record, const float & scale, const float & offset, float * scratch,
+			float * outReal, float * outImag) const;
+
+	size_t recordLength_;
+	size_t decimFactor1_;
+	size_t decimFactor2_;
+	//Record lengths after each decimation stage
+	size_t length1_;
+	size_t length2_;
+	size_t outputLength_;
+
+	PolyDecimator decimator1_;
+	PolyDecimator decimator2_;
+	//Reference exp(-1i*pi*nIFfreq*n) at the first stage's rate
+	AlignedVector refReal_;
+	AlignedVector refImag_;
+
+	int IIROrder_;
+	double IIRb_[6];
+	double IIRa_[6];
+
+	//One buffer per thread execute() has used, laid out as described in execute_record()
+	size_t scratchLength_;
+	vector<AlignedVector> scratch_;
+};
+
+#endif /* DEMODENGINE_H_ */
@@ -0,0 +1,65 @@
+% Demodulation settings planned once for a record length. When the native
+% demodPlan MEX file is built the filter design, mixing reference and
+% scratch buffers are set up here once and every apply() only runs the
+% filters; otherwise apply() falls back to digitalDemod.
+
+% Copyright 2013 Raytheon BBN Technologies
+%
+% Licensed under the Apache License, Version 2.0 (the "License");
+% you may not use this file except in compliance with the License.
+% You may obtain a copy of the License at
+%
+%     http://www.apache.org/licenses/LICENSE-2.0
+%
+% Unless required by applicable law or agreed to in writing, software
+% distributed under the License is distributed on an "AS IS" BASIS,
+% WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+% See the License for the specific language governing permissions and
+% limitations under the License.
+classdef DigitalDemodPlan < handle
+
+    properties (SetAccess = private)
+        IFfreq
+        bandwidth
+        samplingRate
+        recordLength
+        handle = []
+    end
+
+    methods
+        function obj = DigitalDemodPlan(IFfreq, bandwidth, samplingRate, recordLength)
+            obj.IFfreq = IFfreq;
+            obj.bandwidth = bandwidth;
+            obj.samplingRate = samplingRate;
+            obj.recordLength = recordLength;
+            if MeasFilters.mex_built('demodPlan')
+                obj.handle = MeasFilters.demodPlan('create', IFfreq, bandwidth, samplingRate, recordLength);
+            end
+        end
+
+        function delete(obj)
+            if ~isempty(obj.handle)
+                MeasFilters.demodPlan('destroy', obj.handle);
+            end
+        end
+
+        function [demodSignal, decimFactor] = apply(obj, data)
+            if ~isempty(obj.handle)
+                [demodSignal, decimFactor] = MeasFilters.demodPlan('execute', obj.handle, data);
+            else
+                [demodSignal, decimFactor] = MeasFilters.digitalDemod(data, obj.IFfreq, obj.bandwidth, obj.samplingRate);
+            end
+        end
+    end
+
+    methods (Static)
+        function plan = for_data(plan, IFfreq, bandwidth, samplingRate, data)
+            %Keep plan while the settings and record length still match
+            %data, otherwise replace it
+            if isempty(plan) || plan.recordLength ~= size(data,1) || plan.IFfreq ~= IFfreq || ...
+                    plan.bandwidth ~= bandwidth || plan.samplingRate ~= samplingRate
+                plan = MeasFilters.DigitalDemodPlan(IFfreq, bandwidth, samplingRate, size(data,1));
+            end
+        end
+    end
+end
@@ -29,6 +29,7 @@ classdef DigitalHomodyne < MeasFilters.MeasFilter
         fileHandleImag
         saveRecords
         headerWritten = false;
+        demodPlan
     end
     
     methods
@@ -65,7 +66,9 @@ classdef DigitalHomodyne < MeasFilters.MeasFilter
             import MeasFilters.*
             data = apply@MeasFilters.MeasFilter(obj, data);
             
-            [demodSignal, decimFactor] = digitalDemod(data, obj.IFfreq, obj.bandwidth, obj.samplingRate);
+            %Plan once and reuse it for every buffer of the same shape
+            obj.demodPlan = DigitalDemodPlan.for_data(obj.demodPlan, obj.IFfreq, obj.bandwidth, obj.samplingRate, data);
+            [demodSignal, decimFactor] = obj.demodPlan.apply(data);
             
             %Box car the demodulated signal
             if ndims(demodSignal) == 2
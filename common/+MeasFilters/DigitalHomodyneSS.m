@@ -25,6 +25,7 @@ classdef DigitalHomodyneSS < MeasFilters.MeasFilter
         boxCarStop
         affine
         phase
+        demodPlan
     end
     
     methods
@@ -42,7 +43,9 @@ classdef DigitalHomodyneSS < MeasFilters.MeasFilter
             import MeasFilters.*
             data = apply@MeasFilters.MeasFilter(obj, data);
             
-            [demodSignal, decimFactor] = digitalDemod(data, obj.IFfreq, obj.bandwidth, obj.samplingRate);
+            %Plan once and reuse it for every buffer of the same shape
+            obj.demodPlan = DigitalDemodPlan.for_data(obj.demodPlan, obj.IFfreq, obj.bandwidth, obj.samplingRate, data);
+            [demodSignal, decimFactor] = obj.demodPlan.apply(data);
             
             %Box car the demodulated signal
             if ndims(demodSignal) == 2
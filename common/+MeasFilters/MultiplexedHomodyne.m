@@ -0,0 +1,71 @@
+% One qubit of a frequency multiplexed readout. Takes the same settings as
+% DigitalHomodyne and gives the same integrated values, but every qubit on
+% a digitizer channel and sampling rate shares a Channelizer (see
+% Channelizer.shared) that integrates all of them in one pass over the
+% records. Pre-defined integration filters and saving records need the
+% demodulated signal, so use DigitalHomodyne for those.
+
+% Copyright 2013 Raytheon BBN Technologies
+%
+% Licensed under the Apache License, Version 2.0 (the "License");
+% you may not use this file except in compliance with the License.
+% You may obtain a copy of the License at
+%
+%     http://www.apache.org/licenses/LICENSE-2.0
+%
+% Unless required by applicable law or agreed to in writing, software
+% distributed under the License is distributed on an "AS IS" BASIS,
+% WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+% See the License for the specific language governing permissions and
+% limitations under the License.
+classdef MultiplexedHomodyne < MeasFilters.MeasFilter
+
+    properties
+        IFfreq
+        bandwidth
+        samplingRate
+        boxCarStart
+        boxCarStop
+        phase
+        channelizer
+        channelId
+    end
+
+    methods
+        function obj = MultiplexedHomodyne(settings)
+            obj = obj@MeasFilters.MeasFilter(settings);
+            obj.IFfreq = settings.IFfreq;
+            obj.bandwidth = settings.bandwidth;
+            obj.samplingRate = settings.samplingRate;
+            obj.boxCarStart = settings.boxCarStart;
+            obj.boxCarStop = settings.boxCarStop;
+            obj.phase = settings.phase;
+
+            obj.channelizer = MeasFilters.Channelizer.shared(obj.channel, obj.samplingRate);
+            obj.channelId = obj.channelizer.add_channel(obj.IFfreq, obj.bandwidth, obj.boxCarStart, obj.boxCarStop, obj.phase);
+        end
+
+        function delete(obj)
+            if ~isempty(obj.channelId) && isvalid(obj.channelizer)
+                obj.channelizer.remove_channel(obj.channelId);
+            end
+        end
+
+        function out = apply(obj, data)
+            %ExpManager tags each buffer; without a tag the channelizer
+            %falls back to fingerprinting the records
+            bufferct = [];
+            if isfield(data, 'bufferct')
+                bufferct = data.bufferct;
+            end
+            data = apply@MeasFilters.MeasFilter(obj, data);
+
+            obj.latestData = obj.channelizer.result(obj.channelId, data, bufferct);
+
+            obj.accumulate();
+            out = obj.latestData;
+        end
+    end
+
+
+end
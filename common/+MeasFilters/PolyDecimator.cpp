@@ -0,0 +1,339 @@
+/*
+ * PolyDecimator.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "PolyDecimator.h"
+#include "demod.h"
+#include "../util/kernelSupport.h"
+
+#include <cmath>
+
+namespace {
+
+//M_PI needs _USE_MATH_DEFINES on MSVC
+const double pi = 3.14159265358979323846;
+
+//Where the phase streams are and what to run over them
+struct PhaseFilter {
+	const float * taps;
+	size_t numPhases;
+	size_t tapsPerPhase;
+	size_t streamLength;
+};
+
+//Output m of each phase's FIR reads its stream from here back over tapsPerPhase samples
+inline const float * stream_at(const PhaseFilter & filter, const float * streams, const size_t & phase, const size_t & tap, const size_t & m) {
+	return streams + phase * filter.streamLength + filter.tapsPerPhase - 1 - tap + m;
+}
+
+void filter_scalar(const PhaseFilter & filter, const float * streams, const size_t & begin, const size_t & end, float * output) {
+	for (size_t m = begin; m < end; m++) {
+		float sum = 0;
+		for (size_t phase = 0; phase < filter.numPhases; phase++) {
+			const float * taps = filter.taps + phase * filter.tapsPerPhase;
+			const float * samples = stream_at(filter, streams, phase, 0, m);
+			for (size_t tap = 0; tap < filter.tapsPerPhase; tap++) {
+				sum += taps[tap] * samples[-static_cast<ptrdiff_t>(tap)];
+			}
+		}
+		output[m] = sum;
+	}
+}
+
+#ifdef KERNELS_X86
+//Outputs [begin, begin + 8*NUM_VECTORS) held in registers while every tap of every phase is applied
+template <int NUM_VECTORS>
+KERNELS_AVX2 inline void filter_block_avx2(const PhaseFilter & filter, const float * streams, const size_t & begin, float * output) {
+	__m256 sums[NUM_VECTORS];
+	for (int vec = 0; vec < NUM_VECTORS; vec++) {
+		sums[vec] = _mm256_setzero_ps();
+	}
+	for (size_t phase = 0; phase < filter.numPhases; phase++) {
+		const float * taps = filter.taps + phase * filter.tapsPerPhase;
+		for (size_t tap = 0; tap < filter.tapsPerPhase; tap++) {
+			const __m256 coeff = _mm256_set1_ps(taps[tap]);
+			const float * samples = stream_at(filter, streams, phase, tap, begin);
+			for (int vec = 0; vec < NUM_VECTORS; vec++) {
+				sums[vec] = _mm256_fmadd_ps(coeff, _mm256_loadu_ps(samples + 8*vec), sums[vec]);
+			}
+		}
+	}
+	for (int vec = 0; vec < NUM_VECTORS; vec++) {
+		_mm256_storeu_ps(output + begin + 8*vec, sums[vec]);
+	}
+}
+
+KERNELS_AVX2 void filter_avx2(const PhaseFilter & filter, const float * streams, const size_t & length, float * output) {
+	size_t m = 0;
+	for (; m + 32 <= length; m += 32) {
+		filter_block_avx2<4>(filter, streams, m, output);
+	}
+	for (; m + 8 <= length; m += 8) {
+		filter_block_avx2<1>(filter, streams, m, output);
+	}
+	filter_scalar(filter, streams, m, length, output);
+}
+#endif
+
+#ifdef KERNELS_NEON
+template <int NUM_VECTORS>
+inline void filter_block_neon(const PhaseFilter & filter, const float * streams, const size_t & begin, float * output) {
+	float32x4_t sums[NUM_VECTORS];
+	for (int vec = 0; vec < NUM_VECTORS; vec++) {
+		sums[vec] = vdupq_n_f32(0);
+	}
+	for (size_t phase = 0; phase < filter.numPhases; phase++) {
+		const float * taps = filter.taps + phase * filter.tapsPerPhase;
+		for (size_t tap = 0; tap < filter.tapsPerPhase; tap++) {
+			const float32x4_t coeff = vdupq_n_f32(taps[tap]);
+			const float * samples = stream_at(filter, streams, phase, tap, begin);
+			for (int vec = 0; vec < NUM_VECTORS; vec++) {
+#ifdef __aarch64__
+				sums[vec] = vfmaq_f32(sums[vec], coeff, vld1q_f32(samples + 4*vec));
+#else
+				sums[vec] = vmlaq_f32(sums[vec], coeff, vld1q_f32(samples + 4*vec));
+#endif
+			}
+		}
+	}
+	for (int vec = 0; vec < NUM_VECTORS; vec++) {
+		vst1q_f32(output + begin + 4*vec, sums[vec]);
+	}
+}
+
+void filter_neon(const PhaseFilter & filter, const float * streams, const size_t & length, float * output) {
+	size_t m = 0;
+	for (; m + 16 <= length; m += 16) {
+		filter_block_neon<4>(filter, streams, m, output);
+	}
+	for (; m + 4 <= length; m += 4) {
+		filter_block_neon<1>(filter, streams, m, output);
+	}
+	filter_scalar(filter, streams, m, length, output);
+}
+#endif
+
+void filter(const PhaseFilter & filter, const float * streams, const size_t & length, float * output) {
+#if defined(KERNELS_X86)
+	if (KernelSupport::has_avx2()) {
+		filter_avx2(filter, streams, length, output);
+		return;
+	}
+#elif defined(KERNELS_NEON)
+	filter_neon(filter, streams, length, output);
+	return;
+#endif
+	filter_scalar(filter, streams, 0, length, output);
+}
+
+}
+
+const size_t PolyDecimator::DEFAULT_NUM_TAPS;
+
+PolyDecimator::PolyDecimator() : decimFactor_(1), recordLength_(0), outputLength_(0), tapsPerPhase_(0), streamLength_(0) {};
+
+int PolyDecimator::init(const vector<float> & taps, const size_t & decimFactor, const size_t & recordLength) {
+	if (taps.empty() || decimFactor == 0) {
+		return DEMOD_INVALID_PARAMS;
+	}
+	decimFactor_ = decimFactor;
+	recordLength_ = recordLength;
+	outputLength_ = recordLength / decimFactor;
+	scratch_.clear();
+	tapsPerPhase_ = (taps.size() + decimFactor - 1) / decimFactor;
+	streamLength_ = tapsPerPhase_ - 1 + outputLength_;
+
+	//Tap k of phase p is taps[k*decimFactor + p]
+	phaseTaps_.assign(decimFactor_ * tapsPerPhase_, 0.0f);
+	for (size_t ct = 0; ct < taps.size(); ct++) {
+		phaseTaps_[(ct % decimFactor_) * tapsPerPhase_ + ct / decimFactor_] = taps[ct];
+	}
+	return DEMOD_OK;
+}
+
+vector<float> PolyDecimator::lowpass_taps(const size_t & decimFactor, const size_t & numTaps) {
+	const double cutoff = 0.8 * 0.5 / decimFactor;
+	const double center = 0.5 * (numTaps - 1);
+	vector<double> taps(numTaps);
+	double sum = 0;
+	for (size_t n = 0; n < numTaps; n++) {
+		double offset = n - center;
+		double window = (numTaps == 1) ? 1 : 0.42 - 0.5*std::cos(2*pi*n / (numTaps-1)) + 0.08*std::cos(4*pi*n / (numTaps-1));
+		double ideal = (offset == 0) ? 2*cutoff : std::sin(2*pi*cutoff*offset) / (pi*offset);
+		taps[n] = window * ideal;
+		sum += taps[n];
+	}
+	vector<float> normalized(numTaps);
+	for (size_t n = 0; n < numTaps; n++) {
+		normalized[n] = taps[n] / sum;
+	}
+	return normalized;
+}
+
+template <typename T>
+void PolyDecimator::split_phases(const T * record, const size_t & step, float * streams, const float & scale, const float & offset) const {
+	for (size_t phase = 0; phase < decimFactor_; phase++) {
+		std::fill(streams + phase * streamLength_, streams + phase * streamLength_ + tapsPerPhase_ - 1, 0.0f);
+	}
+	//Read the record in order and deal each sample out to its phase
+	float * samples = streams + tapsPerPhase_ - 1;
+	for (size_t j = 0; j < outputLength_; j++) {
+		const T * block = record + (j * decimFactor_ + decimFactor_ - 1) * step;
+		for (size_t phase = 0; phase < decimFactor_; phase++) {
+			samples[phase * streamLength_ + j] = scale * static_cast<float>(block[-static_cast<ptrdiff_t>(phase * step)]) + offset;
+		}
+	}
+}
+
+void PolyDecimator::filter_phases(const float * streams, float * output) const {
+	PhaseFilter phaseFilter = {phaseTaps_.data(), decimFactor_, tapsPerPhase_, streamLength_};
+	filter(phaseFilter, streams, outputLength_, output);
+}
+
+void PolyDecimator::filter_phases(const float * streamsReal, const float * streamsImag, float * outReal, float * outImag) const {
+	filter_phases(streamsReal, outReal);
+	filter_phases(streamsImag, outImag);
+}
+
+template <typename T>
+void PolyDecimator::decimate_record(const T * record, float * output, float * scratch, const float & scale, const float & offset) const {
+	split_phases(record, 1, scratch, scale, offset);
+	filter_phases(scratch, output);
+}
+
+void PolyDecimator::decimate_record(const float * recordReal, const float * recordImag, float * outReal, float * outImag, float * scratch) const {
+	float * streamsImag = scratch + decimFactor_ * streamLength_;
+	split_phases(recordReal, 1, scratch, 1, 0);
+	split_phases(recordImag, 1, streamsImag, 1, 0);
+	filter_phases(scratch, streamsImag, outReal, outImag);
+}
+
+void PolyDecimator::decimate_record(const std::complex<float> * record, std::complex<float> * output, float * scratch) const {
+	const float * samples = reinterpret_cast<const float *>(record);
+	float * streamsImag = scratch + decimFactor_ * streamLength_;
+	float * outReal = streamsImag + decimFactor_ * streamLength_;
+	float * outImag = outReal + outputLength_;
+	split_phases(samples, 2, scratch, 1, 0);
+	split_phases(samples + 1, 2, streamsImag, 1, 0);
+	filter_phases(scratch, streamsImag, outReal, outImag);
+	for (size_t m = 0; m < outputLength_; m++) {
+		output[m] = std::complex<float>(outReal[m], outImag[m]);
+	}
+}
+
+void PolyDecimator::reserve_scratch(const size_t & numChunks) {
+	while (scratch_.size() < numChunks) {
+		scratch_.emplace_back(scratch_length());
+	}
+}
+
+void PolyDecimator::transpose_record(const double * input, double * output) const {
+	std::fill(output, output + recordLength_, 0.0);
+	//Tap k of phase p joined input sample (m-k)*decimFactor + decimFactor-1 - p to output m
+	for (size_t m = 0; m < outputLength_; m++) {
+		for (size_t k = 0; k < tapsPerPhase_ && k <= m; k++) {
+			double * block = output + (m - k) * decimFactor_ + decimFactor_ - 1;
+			for (size_t phase = 0; phase < decimFactor_; phase++) {
+				block[-static_cast<ptrdiff_t>(phase)] += phaseTaps_[phase * tapsPerPhase_ + k] * input[m];
+			}
+		}
+	}
+}
+
+template <typename T>
+void PolyDecimator::execute(const T * records, const size_t & numRecords, float * output, const float & scale, const float & offset) {
+	size_t numChunks = KernelSupport::num_chunks(numRecords, recordLength_);
+	reserve_scratch(numChunks);
+	KernelSupport::parallel_for_chunks(numRecords, numChunks, [&](size_t chunk, size_t begin, size_t end) {
+		for (size_t ct = begin; ct < end; ct++) {
+			decimate_record(records + ct*recordLength_, output + ct*outputLength_, scratch_[chunk].data(), scale, offset);
+		}
+	});
+}
+
+void PolyDecimator::execute(const float * recordsReal, const float * recordsImag, const size_t & numRecords, float * outReal, float * outImag) {
+	size_t numChunks = KernelSupport::num_chunks(numRecords, 2*recordLength_);
+	reserve_scratch(numChunks);
+	KernelSupport::parallel_for_chunks(numRecords, numChunks, [&](size_t chunk, size_t begin, size_t end) {
+		for (size_t ct = begin; ct < end; ct++) {
+			decimate_record(recordsReal + ct*recordLength_, recordsImag + ct*recordLength_,
+					outReal + ct*outputLength_, outImag + ct*outputLength_, scratch_[chunk].data());
+		}
+	});
+}
+
+void PolyDecimator::execute(const std::complex<float> * records, const size_t & numRecords, std::complex<float> * output) {
+	size_t numChunks = KernelSupport::num_chunks(numRecords, 2*recordLength_);
+	reserve_scratch(numChunks);
+	KernelSupport::parallel_for_chunks(numRecords, numChunks, [&](size_t chunk, size_t begin, size_t end) {
+		for (size_t ct = begin; ct < end; ct++) {
+			decimate_record(records + ct*recordLength_, output + ct*outputLength_, scratch_[chunk].data());
+		}
+	});
+}
+
+template void PolyDecimator::decimate_record<float>(const float *, float *, float *, const float &, const float &) const;
+template void PolyDecimator::decimate_record<double>(const double *, float *, float *, const float &, const float &) const;
+template void PolyDecimator::decimate_record<uint8_t>(const uint8_t *, float *, float *, const float &, const float &) const;
+template void PolyDecimator::execute<float>(const float *, const size_t &, float *, const float &, const float &);
+template void PolyDecimator::execute<double>(const double *, const size_t &, float *, const float &, const float &);
+template void PolyDecimator::execute<uint8_t>(const uint8_t *, const size_t &, float *, const float &, const float &);
+
+//C interface
+struct DecimPlan {
+	PolyDecimator decimator;
+};
+
+DecimPlan * decim_plan_create(size_t decimFactor, size_t numTaps, size_t recordLength, int * status) {
+	int result = DEMOD_INVALID_PARAMS;
+	DecimPlan * plan = nullptr;
+	if (decimFactor > 0 && numTaps > 0) {
+		try {
+			plan = new DecimPlan;
+			result = plan->decimator.init(PolyDecimator::lowpass_taps(decimFactor, numTaps), decimFactor, recordLength);
+		} catch (std::bad_alloc &) {
+			result = DEMOD_UNKNOWN_ERROR;
+		}
+		if (result != DEMOD_OK) {
+			delete plan;
+			plan = nullptr;
+		}
+	}
+	if (status != nullptr) *status = result;
+	return plan;
+}
+
+void decim_plan_destroy(DecimPlan * plan) {
+	delete plan;
+}
+
+size_t decim_plan_output_length(const DecimPlan * plan) {
+	return (plan == nullptr) ? 0 : plan->decimator.output_length();
+}
+
+int decim_plan_execute(DecimPlan * plan, const float * records, size_t numRecords, float * output) {
+	if (plan == nullptr || records == nullptr || output == nullptr) {
+		return DEMOD_INVALID_PARAMS;
+	}
+	try {
+		plan->decimator.execute(records, numRecords, output);
+	} catch (std::bad_alloc &) {
+		return DEMOD_UNKNOWN_ERROR;
+	}
+	return DEMOD_OK;
+}
+
+int decim_plan_execute_complex(DecimPlan * plan, const float * recordsReal, const float * recordsImag, size_t numRecords,
+		float * outReal, float * outImag) {
+	if (plan == nullptr || recordsReal == nullptr || recordsImag == nullptr || outReal == nullptr || outImag == nullptr) {
+		return DEMOD_INVALID_PARAMS;
+	}
+	try {
+		plan->decimator.execute(recordsReal, recordsImag, numRecords, outReal, outImag);
+	} catch (std::bad_alloc &) {
+		return DEMOD_UNKNOWN_ERROR;
+	}
+	return DEMOD_OK;
+}
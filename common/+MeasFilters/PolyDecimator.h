@@ -0,0 +1,87 @@
+/*
+ * PolyDecimator.h
+ *
+ * Polyphase FIR decimation of records without Intel IPP.
+ * Output m of a record is sum_t taps[t] * input[m*decimFactor + decimFactor-1 - t] with zeros before the
+ * start of the record, which is what polyDecimator did with ippsFIRMR and a zeroed delay line.
+ * Each record is first split into its decimFactor phases so every phase is an ordinary FIR over
+ * contiguous samples; the AVX2 and NEON kernels then compute 8 or 4 outputs per instruction.
+ * Real, split complex and interleaved complex records are supported and records are spread across threads.
+ * A decimator is a plan: the phase taps are laid out by init() and the per-thread scratch is allocated by the
+ * first execute() and kept, so repeated calls on the same record length allocate nothing. Because that scratch
+ * is shared, an instance runs one execute() at a time; use one per calling thread.
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef POLYDECIMATOR_H_
+#define POLYDECIMATOR_H_
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../util/kernelSupport.h"
+
+using std::vector;
+using KernelSupport::AlignedVector;
+
+class PolyDecimator {
+public:
+	//The filter polyDecimator has always used
+	static const size_t DEFAULT_NUM_TAPS = 16;
+
+	PolyDecimator();
+
+	int init(const vector<float> & taps, const size_t & decimFactor, const size_t & recordLength);
+
+	size_t decim_factor() const {return decimFactor_;};
+	size_t record_length() const {return recordLength_;};
+	size_t output_length() const {return outputLength_;};
+	//Floats of scratch one record needs
+	size_t scratch_length() const {return 2 * decimFactor_ * streamLength_ + 2 * outputLength_;};
+
+	//A record at a time with caller owned scratch; each input sample is scale*sample + offset
+	template <typename T>
+	void decimate_record(const T * record, float * output, float * scratch, const float & scale = 1, const float & offset = 0) const;
+	void decimate_record(const float * recordReal, const float * recordImag, float * outReal, float * outImag, float * scratch) const;
+	void decimate_record(const std::complex<float> * record, std::complex<float> * output, float * scratch) const;
+
+	//Many records one after another, spread across threads
+	template <typename T>
+	void execute(const T * records, const size_t & numRecords, float * output, const float & scale = 1, const float & offset = 0);
+	void execute(const float * recordsReal, const float * recordsImag, const size_t & numRecords, float * outReal, float * outImag);
+	void execute(const std::complex<float> * records, const size_t & numRecords, std::complex<float> * output);
+
+	//The transpose of decimate_record: spreads outputLength samples back over recordLength with the same taps
+	void transpose_record(const double * input, double * output) const;
+
+	/*
+	 * The design of ippsFIRGenLowpass_64f(0.8*0.5/decimFactor, taps, numTaps, ippWinBlackman, ippTrue):
+	 * a Blackman windowed ideal low-pass with a cutoff of 0.8 of the decimated Nyquist frequency
+	 * normalized to unity gain at DC
+	 */
+	static vector<float> lowpass_taps(const size_t & decimFactor, const size_t & numTaps = DEFAULT_NUM_TAPS);
+
+private:
+	//Split a record into its phase streams; stream p holds input[j*decimFactor + decimFactor-1 - p] after tapsPerPhase-1 zeros
+	template <typename T>
+	void split_phases(const T * record, const size_t & step, float * streams, const float & scale, const float & offset) const;
+	void filter_phases(const float * streams, float * output) const;
+	void filter_phases(const float * streamsReal, const float * streamsImag, float * outReal, float * outImag) const;
+	//Make sure there is scratch for numChunks threads
+	void reserve_scratch(const size_t & numChunks);
+
+	size_t decimFactor_;
+	size_t recordLength_;
+	size_t outputLength_;
+	size_t tapsPerPhase_;
+	size_t streamLength_;
+	//tapsPerPhase taps for each phase, zero padded
+	AlignedVector phaseTaps_;
+	//One scratch_length() buffer per thread execute() has used
+	vector<AlignedVector> scratch_;
+};
+
+#endif /* POLYDECIMATOR_H_ */
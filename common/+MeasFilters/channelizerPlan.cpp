@@ -0,0 +1,132 @@
+#include "mex.h"
+#include "Channelizer.h"
+#include "mexPlans.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+/*
+ plan = channelizerPlan('create', IFfreqs, bandwidths, boxCarStarts, boxCarStops, phases, samplingRate, recordLength)
+ values = channelizerPlan('execute', plan, data)
+ channelizerPlan('destroy', plan)
+ Integrates several IF channels of the same records in one pass (see Channelizer.h). The channel settings
+ are vectors of one entry per channel, or scalars shared by all of them, with the meaning they have for
+ DigitalHomodyne. data is real single or double with recordLength rows; values is complex single with one
+ row per channel and the trailing dimensions of data.
+ Plans are handled as in demodPlan; MeasFilters.Channelizer wraps one.
+ Build with: mex -largeArrayDims channelizerPlan.cpp Channelizer.cpp DemodEngine.cpp PolyDecimator.cpp
+*/
+
+static double channel_setting(const mxArray * setting, const size_t & channel) {
+	return mxGetPr(setting)[(mxGetNumberOfElements(setting) == 1) ? 0 : channel];
+}
+
+static void create(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
+	size_t numChannels = 1;
+	int status;
+
+	if (nrhs != 8) {
+		mexErrMsgIdAndTxt("MeasFilters:channelizerPlan:nrhs",
+				"create takes IFfreqs, bandwidths, boxCarStarts, boxCarStops, phases, samplingRate and recordLength.");
+	}
+	if (nlhs > 1) {
+		mexErrMsgIdAndTxt("MeasFilters:channelizerPlan:nlhs", "create returns only the plan.");
+	}
+	for (int ct = 1; ct < 6; ct++) {
+		if (!mxIsDouble(prhs[ct]) || mxIsComplex(prhs[ct]) || mxGetNumberOfElements(prhs[ct]) == 0) {
+			mexErrMsgIdAndTxt("MeasFilters:channelizerPlan:settings", "Channel settings must be real double.");
+		}
+		numChannels = std::max(numChannels, static_cast<size_t>(mxGetNumberOfElements(prhs[ct])));
+	}
+	for (int ct = 1; ct < 6; ct++) {
+		if (mxGetNumberOfElements(prhs[ct]) != 1 && mxGetNumberOfElements(prhs[ct]) != numChannels) {
+			mexErrMsgIdAndTxt("MeasFilters:channelizerPlan:settings", "Channel settings must be scalars or have one entry per channel.");
+		}
+	}
+	double recordLength = mxGetScalar(prhs[7]);
+	if (!(recordLength >= 1) || recordLength != static_cast<size_t>(recordLength)) {
+		mexErrMsgIdAndTxt("MeasFilters:channelizerPlan:recordLength", "recordLength must be a positive integer.");
+	}
+
+	vector<ChannelParams> channels(numChannels);
+	for (size_t channel = 0; channel < numChannels; channel++) {
+		channels[channel].IFfreq = channel_setting(prhs[1], channel);
+		channels[channel].bandwidth = channel_setting(prhs[2], channel);
+		channels[channel].boxCarStart = channel_setting(prhs[3], channel);
+		channels[channel].boxCarStop = channel_setting(prhs[4], channel);
+		channels[channel].phase = channel_setting(prhs[5], channel);
+	}
+
+	std::unique_ptr<Channelizer> plan(new Channelizer);
+	status = plan->init(channels, mxGetScalar(prhs[6]), static_cast<size_t>(recordLength));
+	if (status != DEMOD_OK) {
+		plan.reset();
+		if (status == DEMOD_BANDWIDTH_TOO_WIDE) {
+			mexErrMsgIdAndTxt("MeasFilters:channelizerPlan:bandwidth", "Oops! The normalized cutoff is not between 0.05 and 1");
+		}
+		mexErrMsgIdAndTxt("MeasFilters:channelizerPlan:params",
+				"Invalid channel settings, boxcar windows or record length (error %d).", status);
+	}
+
+	plhs[0] = MexPlans<Channelizer>::add(plan.release());
+}
+
+static void execute(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
+	if (nrhs != 3) {
+		mexErrMsgIdAndTxt("MeasFilters:channelizerPlan:nrhs", "execute takes a plan and data.");
+	}
+	if (nlhs > 1) {
+		mexErrMsgIdAndTxt("MeasFilters:channelizerPlan:nlhs", "execute returns only the values.");
+	}
+	Channelizer * plan = MexPlans<Channelizer>::get(prhs[1], "MeasFilters:channelizerPlan:handle");
+	const mxArray * data = prhs[2];
+	if ((!mxIsSingle(data) && !mxIsDouble(data)) || mxIsComplex(data)) {
+		mexErrMsgIdAndTxt("MeasFilters:channelizerPlan:data", "data must be real single or double.");
+	}
+	mwSize numDims = mxGetNumberOfDimensions(data);
+	const mwSize * inDims = mxGetDimensions(data);
+	if (inDims[0] != plan->record_length()) {
+		mexErrMsgIdAndTxt("MeasFilters:channelizerPlan:recordLength", "data has %d rows but the plan is for records of %d samples.",
+				static_cast<int>(inDims[0]), static_cast<int>(plan->record_length()));
+	}
+
+	//records along the first dimension become channels along the first dimension
+	mwSize numRecords = 1;
+	mwSize * outDims = (mwSize *)mxMalloc(numDims*sizeof(mwSize));
+	outDims[0] = plan->num_channels();
+	for (mwSize ct = 1; ct < numDims; ct++) {
+		outDims[ct] = inDims[ct];
+		numRecords *= inDims[ct];
+	}
+	plhs[0] = mxCreateNumericArray(numDims, outDims, mxSINGLE_CLASS, mxCOMPLEX);
+	mxFree(outDims);
+	float * outReal = (float *)mxGetData(plhs[0]);
+	float * outImag = (float *)mxGetImagData(plhs[0]);
+
+	if (mxIsSingle(data)) {
+		plan->execute((const float *)mxGetData(data), numRecords, outReal, outImag);
+	} else {
+		plan->execute((const double *)mxGetData(data), numRecords, outReal, outImag);
+	}
+}
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
+	char command[8];
+
+	if (nrhs < 1 || !mxIsChar(prhs[0]) || mxGetString(prhs[0], command, sizeof(command)) != 0) {
+		mexErrMsgIdAndTxt("MeasFilters:channelizerPlan:command", "The first input must be 'create', 'execute' or 'destroy'.");
+	}
+	if (strcmp(command, "create") == 0) {
+		create(nlhs, plhs, nrhs, prhs);
+	} else if (strcmp(command, "execute") == 0) {
+		execute(nlhs, plhs, nrhs, prhs);
+	} else if (strcmp(command, "destroy") == 0) {
+		if (nrhs != 2 || nlhs > 0) {
+			mexErrMsgIdAndTxt("MeasFilters:channelizerPlan:nrhs", "destroy takes a plan and has no outputs.");
+		}
+		MexPlans<Channelizer>::destroy(prhs[1], "MeasFilters:channelizerPlan:handle");
+	} else {
+		mexErrMsgIdAndTxt("MeasFilters:channelizerPlan:command", "Unknown command '%s'.", command);
+	}
+}
@@ -0,0 +1,11 @@
+function varargout = channelizerPlan(command, varargin)
+% Integrates several frequency multiplexed readout channels of the same
+% records in one pass; each channel gives what DigitalHomodyne would.
+%   plan = channelizerPlan('create', IFfreqs, bandwidths, boxCarStarts, boxCarStops, phases, samplingRate, recordLength)
+%   values = channelizerPlan('execute', plan, data)
+%   channelizerPlan('destroy', plan)
+% The channel settings have one entry per channel or are shared scalars.
+% values has one row per channel. Build with
+%   mex -largeArrayDims channelizerPlan.cpp Channelizer.cpp DemodEngine.cpp PolyDecimator.cpp
+% Channelizer wraps the handle and falls back to digitalDemod when this
+% isn't built.
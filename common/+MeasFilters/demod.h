@@ -0,0 +1,103 @@
+/*
+ * demod.h
+ *
+ * C interface to the native digital demodulation engine (DemodEngine.h).
+ * Demodulates records the same way as digitalDemod.m: an optional polyphase decimation, mixing down
+ * from IFfreq, an optional second decimation, a Butterworth low-pass and finally keeping every 8th sample.
+ * Outputs are complex with the real and imaginary parts in separate arrays, one record after another.
+ * The demod_records functions plan and tear down for each call; acquisition loops that see the same record
+ * length buffer after buffer should create a DemodPlan (or DecimPlan for decimation alone) once and execute it.
+ * A plan runs one execute at a time, so give each calling thread its own.
+ * A ChannelizerPlan integrates several IF channels of the same records at once (Channelizer.h).
+ * Build it into a shared library together with DemodEngine.cpp, PolyDecimator.cpp and Channelizer.cpp, e.g.
+ *     g++ -std=c++11 -O2 -shared -fPIC -o libdemod.so DemodEngine.cpp PolyDecimator.cpp Channelizer.cpp -pthread
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef DEMOD_H_
+#define DEMOD_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#define EXPORT __declspec(dllexport)
+#else
+#define EXPORT
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum DemodErrorCode {
+	DEMOD_OK,
+	DEMOD_UNKNOWN_ERROR = -1,
+	DEMOD_INVALID_PARAMS = -2,
+	DEMOD_BANDWIDTH_TOO_WIDE = -3,
+	DEMOD_RECORD_TOO_SHORT = -4
+};
+
+typedef struct {
+	double IFfreq;
+	double bandwidth;
+	double samplingRate;
+} DemodParams;
+
+/* Length of each demodulated record and the total decimation factor for records of recordLength samples */
+EXPORT int demod_output_length(const DemodParams *, size_t recordLength, size_t * outputLength, size_t * decimFactor);
+
+/* Demodulate numRecords records of recordLength samples into outReal/outImag of numRecords*outputLength samples */
+EXPORT int demod_records(const DemodParams *, const float * records, size_t recordLength, size_t numRecords, float * outReal, float * outImag);
+
+/* As demod_records but from raw digitizer codes; each sample is first scaled to scale*code + offset */
+EXPORT int demod_records_u8(const DemodParams *, const uint8_t * records, size_t recordLength, size_t numRecords,
+		float scale, float offset, float * outReal, float * outImag);
+
+/* Opaque plans holding the filter coefficients, mixing reference and aligned scratch for one record length */
+typedef struct DemodPlan DemodPlan;
+typedef struct DecimPlan DecimPlan;
+
+/* NULL on failure with the reason in status when it isn't NULL */
+EXPORT DemodPlan * demod_plan_create(const DemodParams *, size_t recordLength, int * status);
+EXPORT void demod_plan_destroy(DemodPlan *);
+EXPORT size_t demod_plan_record_length(const DemodPlan *);
+EXPORT size_t demod_plan_output_length(const DemodPlan *);
+EXPORT size_t demod_plan_decim_factor(const DemodPlan *);
+EXPORT int demod_plan_execute(DemodPlan *, const float * records, size_t numRecords, float * outReal, float * outImag);
+EXPORT int demod_plan_execute_u8(DemodPlan *, const uint8_t * records, size_t numRecords, float scale, float offset,
+		float * outReal, float * outImag);
+
+/* Polyphase decimation by decimFactor with polyDecimator's numTaps low-pass */
+EXPORT DecimPlan * decim_plan_create(size_t decimFactor, size_t numTaps, size_t recordLength, int * status);
+EXPORT void decim_plan_destroy(DecimPlan *);
+EXPORT size_t decim_plan_output_length(const DecimPlan *);
+EXPORT int decim_plan_execute(DecimPlan *, const float * records, size_t numRecords, float * output);
+EXPORT int decim_plan_execute_complex(DecimPlan *, const float * recordsReal, const float * recordsImag, size_t numRecords,
+		float * outReal, float * outImag);
+
+/* One readout channel; the boxcar window is in samples of the raw record like DigitalHomodyne's */
+typedef struct {
+	double IFfreq;
+	double bandwidth;
+	double boxCarStart;
+	double boxCarStop;
+	double phase;
+} ChannelParams;
+
+typedef struct ChannelizerPlan ChannelizerPlan;
+
+EXPORT ChannelizerPlan * channelizer_plan_create(const ChannelParams * channels, size_t numChannels, double samplingRate,
+		size_t recordLength, int * status);
+EXPORT void channelizer_plan_destroy(ChannelizerPlan *);
+/* out holds numChannels values per record, channel fastest */
+EXPORT int channelizer_plan_execute(ChannelizerPlan *, const float * records, size_t numRecords, float * outReal, float * outImag);
+EXPORT int channelizer_plan_execute_u8(ChannelizerPlan *, const uint8_t * records, size_t numRecords, float scale, float offset,
+		float * outReal, float * outImag);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DEMOD_H_ */
@@ -0,0 +1,45 @@
+/*
+ * demodMex.h
+ *
+ * Array handling shared by the digitalDemod and demodPlan MEX files.
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef DEMODMEX_H_
+#define DEMODMEX_H_
+
+#include "mex.h"
+#include "DemodEngine.h"
+
+//Demodulate real single or double data with records along the first dimension into a complex single array
+//with the same trailing dimensions; the engine must have been planned for size(data,1)
+inline mxArray * demodulate_array(DemodEngine & engine, const mxArray * data) {
+	//Expect recordLength x numSegments or recordLength x numWaveforms x numSegments X numRoundRobins
+	//Can treat all of these as recordLength x N
+	mwSize numDims = mxGetNumberOfDimensions(data);
+	const mwSize * inDims = mxGetDimensions(data);
+	mwSize numRecords = 1;
+	for (mwSize ct = 1; ct < numDims; ct++) {
+		numRecords *= inDims[ct];
+	}
+
+	// prepare the output buffer
+	mwSize * outDims = (mwSize *)mxMalloc(numDims*sizeof(mwSize));
+	for (mwSize ct = 0; ct < numDims; ++ct)
+		outDims[ct] = inDims[ct];
+	outDims[0] = engine.output_length();
+	mxArray * demodSignal = mxCreateNumericArray(numDims, outDims, mxSINGLE_CLASS, mxCOMPLEX);
+	mxFree(outDims);
+	float * outReal = (float *)mxGetData(demodSignal);
+	float * outImag = (float *)mxGetImagData(demodSignal);
+
+	if (mxIsSingle(data)) {
+		engine.execute((const float *)mxGetData(data), numRecords, outReal, outImag);
+	} else {
+		engine.execute((const double *)mxGetData(data), numRecords, outReal, outImag);
+	}
+	return demodSignal;
+}
+
+#endif /* DEMODMEX_H_ */
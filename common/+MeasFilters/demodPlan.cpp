@@ -0,0 +1,101 @@
+#include "mex.h"
+#include "DemodEngine.h"
+#include "demodMex.h"
+#include "mexPlans.h"
+
+#include <cstring>
+#include <memory>
+
+/*
+ plan = demodPlan('create', IFfreq, bandwidth, samplingRate, recordLength)
+ [demodSignal, decimFactor] = demodPlan('execute', plan, data)
+ demodPlan('destroy', plan)
+ digitalDemod split into planning and execution. 'create' designs the decimators, the mixing reference and the
+ Butterworth filter for records of recordLength samples once and returns a uint64 handle; 'execute' demodulates
+ data with that many rows without redoing any of it and reuses the scratch buffers of earlier calls.
+ The MEX file stays locked while any plan exists and outstanding plans are freed when MATLAB exits.
+ MeasFilters.DigitalDemodPlan wraps a handle so it is destroyed with its owner.
+ Build with: mex -largeArrayDims demodPlan.cpp DemodEngine.cpp PolyDecimator.cpp
+*/
+
+static void create(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
+	DemodParams params;
+	int status;
+
+	if (nrhs != 5) {
+		mexErrMsgIdAndTxt("MeasFilters:demodPlan:nrhs", "create takes IFfreq, bandwidth, samplingRate and recordLength.");
+	}
+	if (nlhs > 1) {
+		mexErrMsgIdAndTxt("MeasFilters:demodPlan:nlhs", "create returns only the plan.");
+	}
+	params.IFfreq = mxGetScalar(prhs[1]);
+	params.bandwidth = mxGetScalar(prhs[2]);
+	params.samplingRate = mxGetScalar(prhs[3]);
+	double recordLength = mxGetScalar(prhs[4]);
+	if (!(recordLength >= 1) || recordLength != static_cast<size_t>(recordLength)) {
+		mexErrMsgIdAndTxt("MeasFilters:demodPlan:recordLength", "recordLength must be a positive integer.");
+	}
+
+	std::unique_ptr<DemodEngine> plan(new DemodEngine);
+	status = plan->init(params, static_cast<size_t>(recordLength));
+	if (status != DEMOD_OK) {
+		plan.reset();
+		if (status == DEMOD_BANDWIDTH_TOO_WIDE) {
+			mexErrMsgIdAndTxt("MeasFilters:demodPlan:bandwidth", "Oops! The normalized cutoff is not between 0.05 and 1");
+		}
+		mexErrMsgIdAndTxt("MeasFilters:demodPlan:params", "Invalid demodulation parameters or record length (error %d).", status);
+	}
+
+	plhs[0] = MexPlans<DemodEngine>::add(plan.release());
+}
+
+static void execute(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
+	if (nrhs != 3) {
+		mexErrMsgIdAndTxt("MeasFilters:demodPlan:nrhs", "execute takes a plan and data.");
+	}
+	if (nlhs > 2) {
+		mexErrMsgIdAndTxt("MeasFilters:demodPlan:nlhs", "At most 2 outputs.");
+	}
+	DemodEngine * plan = MexPlans<DemodEngine>::get(prhs[1], "MeasFilters:demodPlan:handle");
+	const mxArray * data = prhs[2];
+	if ((!mxIsSingle(data) && !mxIsDouble(data)) || mxIsComplex(data)) {
+		mexErrMsgIdAndTxt("MeasFilters:demodPlan:data", "data must be real single or double.");
+	}
+	if (mxGetDimensions(data)[0] != plan->record_length()) {
+		mexErrMsgIdAndTxt("MeasFilters:demodPlan:recordLength", "data has %d rows but the plan is for records of %d samples.",
+				static_cast<int>(mxGetDimensions(data)[0]), static_cast<int>(plan->record_length()));
+	}
+
+	plhs[0] = demodulate_array(*plan, data);
+
+	if (nlhs > 1) {
+		plhs[1] = mxCreateDoubleScalar(plan->decim_factor());
+	}
+}
+
+static void destroy(int nlhs, int nrhs, const mxArray *prhs[]) {
+	if (nrhs != 2) {
+		mexErrMsgIdAndTxt("MeasFilters:demodPlan:nrhs", "destroy takes a plan.");
+	}
+	if (nlhs > 0) {
+		mexErrMsgIdAndTxt("MeasFilters:demodPlan:nlhs", "destroy has no outputs.");
+	}
+	MexPlans<DemodEngine>::destroy(prhs[1], "MeasFilters:demodPlan:handle");
+}
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
+	char command[8];
+
+	if (nrhs < 1 || !mxIsChar(prhs[0]) || mxGetString(prhs[0], command, sizeof(command)) != 0) {
+		mexErrMsgIdAndTxt("MeasFilters:demodPlan:command", "The first input must be 'create', 'execute' or 'destroy'.");
+	}
+	if (strcmp(command, "create") == 0) {
+		create(nlhs, plhs, nrhs, prhs);
+	} else if (strcmp(command, "execute") == 0) {
+		execute(nlhs, plhs, nrhs, prhs);
+	} else if (strcmp(command, "destroy") == 0) {
+		destroy(nlhs, nrhs, prhs);
+	} else {
+		mexErrMsgIdAndTxt("MeasFilters:demodPlan:command", "Unknown command '%s'.", command);
+	}
+}
@@ -0,0 +1,10 @@
+function varargout = demodPlan(command, varargin)
+% Native digitalDemod split into planning and execution so that the filter
+% design and buffer allocation are done once per record length.
+%   plan = demodPlan('create', IFfreq, bandwidth, samplingRate, recordLength)
+%   [demodSignal, decimFactor] = demodPlan('execute', plan, data)
+%   demodPlan('destroy', plan)
+% data is real single or double with recordLength rows. Build with
+%   mex -largeArrayDims demodPlan.cpp DemodEngine.cpp PolyDecimator.cpp
+% DigitalDemodPlan wraps the handle and falls back to digitalDemod when
+% this isn't built.
@@ -0,0 +1,43 @@
+#include "mex.h"
+#include "DemodEngine.h"
+#include "demodMex.h"
+
+/*
+ [demodSignal, decimFactor] = digitalDemod(data, IFfreq, bandwidth, samplingRate)
+ Native version of digitalDemod.m built on DemodEngine; once compiled it takes precedence over the .m file.
+ data is single or double with records along the first dimension.
+ This plans the filters on every call; see demodPlan for keeping a plan across buffers.
+ Build with: mex -largeArrayDims digitalDemod.cpp DemodEngine.cpp PolyDecimator.cpp
+*/
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
+	DemodParams params;
+	DemodEngine engine;
+	int status;
+
+	if (nrhs != 4) {
+		mexErrMsgIdAndTxt("MeasFilters:digitalDemod:nrhs", "4 inputs required.");
+	}
+	if (nlhs > 2) {
+		mexErrMsgIdAndTxt("MeasFilters:digitalDemod:nlhs", "At most 2 outputs.");
+	}
+	if ((!mxIsSingle(prhs[0]) && !mxIsDouble(prhs[0])) || mxIsComplex(prhs[0])) {
+		mexErrMsgIdAndTxt("MeasFilters:digitalDemod:data", "data must be real single or double.");
+	}
+
+	params.IFfreq = mxGetScalar(prhs[1]);
+	params.bandwidth = mxGetScalar(prhs[2]);
+	params.samplingRate = mxGetScalar(prhs[3]);
+	status = engine.init(params, mxGetDimensions(prhs[0])[0]);
+	if (status == DEMOD_BANDWIDTH_TOO_WIDE) {
+		mexErrMsgIdAndTxt("MeasFilters:digitalDemod:bandwidth", "Oops! The normalized cutoff is not between 0.05 and 1");
+	} else if (status != DEMOD_OK) {
+		mexErrMsgIdAndTxt("MeasFilters:digitalDemod:params", "Invalid demodulation parameters or record length (error %d).", status);
+	}
+
+	plhs[0] = demodulate_array(engine, prhs[0]);
+
+	if (nlhs > 1) {
+		plhs[1] = mxCreateDoubleScalar(engine.decim_factor());
+	}
+}
@@ -1,6 +1,10 @@
 function [demodSignal, decimFactor] = digitalDemod(data, IFfreq, bandwidth, samplingRate)
 %Digitally demodulates a signal at frequency IFfreq down to DC. Does this
 %by moving to the IFfreq rotating frame and low-passing the result.
+%digitalDemod.cpp does the same in one native pass per record (see
+%DemodEngine.h); once it is compiled with
+%   mex -largeArrayDims digitalDemod.cpp DemodEngine.cpp PolyDecimator.cpp
+%the MEX file takes precedence over this one.
 
 %normalize frequencies to Nyquist
 nbandwidth= bandwidth/(samplingRate/2);
@@ -27,6 +31,8 @@ prodSignal = bsxfun(@times, data, refSignal);
 % IIR filter will be unstable, so check if we need to decimate first.
 if nbandwidth < 0.05
     decimFactor2 = ceil(0.05/nbandwidth);
+    % split real and imaginary parts; an older polyDecimator MEX build only
+    % takes real input
     prodSignal = MeasFilters.polyDecimator(real(prodSignal), decimFactor2) + 1i*MeasFilters.polyDecimator(imag(prodSignal), decimFactor2);
     nbandwidth = nbandwidth * decimFactor2;
 else
@@ -0,0 +1,68 @@
+/*
+ * mexPlans.h
+ *
+ * uint64 handles to native plans that live between calls of a MEX file. Handles are checked against the
+ * live plans so a stale one is an error rather than a crash, the MEX file stays locked while any plan exists
+ * and whatever is left is freed when MATLAB exits. Every MEX file gets its own registry.
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef MEXPLANS_H_
+#define MEXPLANS_H_
+
+#include "mex.h"
+
+#include <cstdint>
+#include <set>
+
+template <typename T>
+class MexPlans {
+public:
+	//Takes ownership of plan and returns its handle
+	static mxArray * add(T * plan) {
+		if (live().empty()) {
+			mexLock();
+			mexAtExit(destroy_all);
+		}
+		live().insert(plan);
+		mxArray * handle = mxCreateNumericMatrix(1, 1, mxUINT64_CLASS, mxREAL);
+		*(uint64_t *)mxGetData(handle) = reinterpret_cast<uintptr_t>(plan);
+		return handle;
+	}
+
+	static T * get(const mxArray * handle, const char * errorId) {
+		if (!mxIsUint64(handle) || mxGetNumberOfElements(handle) != 1) {
+			mexErrMsgIdAndTxt(errorId, "plan must be a uint64 handle from 'create'.");
+		}
+		T * plan = reinterpret_cast<T *>(static_cast<uintptr_t>(*(const uint64_t *)mxGetData(handle)));
+		if (live().count(plan) == 0) {
+			mexErrMsgIdAndTxt(errorId, "plan has been destroyed or was never created.");
+		}
+		return plan;
+	}
+
+	static void destroy(const mxArray * handle, const char * errorId) {
+		T * plan = get(handle, errorId);
+		live().erase(plan);
+		delete plan;
+		if (live().empty()) {
+			mexUnlock();
+		}
+	}
+
+private:
+	static std::set<T *> & live() {
+		static std::set<T *> plans;
+		return plans;
+	}
+
+	static void destroy_all() {
+		for (T * plan : live()) {
+			delete plan;
+		}
+		live().clear();
+	}
+};
+
+#endif /* MEXPLANS_H_ */
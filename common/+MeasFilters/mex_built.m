@@ -0,0 +1,12 @@
+function built = mex_built(name)
+%Whether the MEX file MeasFilters.(name) has been compiled, remembered
+%per name so filters can ask on every buffer
+persistent cache
+if isempty(cache)
+    cache = containers.Map();
+end
+if ~isKey(cache, name)
+    [~, ~, ext] = fileparts(which(['MeasFilters.' name]));
+    cache(name) = strcmp(ext, ['.' mexext]);
+end
+built = cache(name);
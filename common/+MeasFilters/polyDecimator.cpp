@@ -0,0 +1,71 @@
+#include "mex.h"
+#include "PolyDecimator.h"
+
+/*
+ channelData = polyDecimator(measRecords, decimFactor)
+ channelData = polyDecimator(measRecords, decimFactor, numTaps)
+ Implements a polyphase FIR filter to efficiently decimate the input signal by decimFactor.
+ measRecords is single (real or complex) or real double. The filter is a numTaps (default 16) tap Blackman
+ windowed low-pass, the same as the earlier IPP version designed with ippsFIRGenLowpass_64f.
+ Build with: mex -largeArrayDims polyDecimator.cpp PolyDecimator.cpp
+*/
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
+
+	mwSize numDims, recordLength, numSegments, ct;
+	const mwSize *inDims;
+	mwSize *outDims;
+	size_t decimFactor, numTaps;
+	PolyDecimator decimator;
+	bool isComplex;
+
+	if (nrhs != 2 && nrhs != 3) {
+		mexErrMsgIdAndTxt("MeasFilters:polyDecimator:nrhs", "2 or 3 inputs required.");
+	}
+	if (nlhs > 1) {
+		mexErrMsgIdAndTxt("MeasFilters:polyDecimator:nlhs", "1 output required.");
+	}
+	isComplex = mxIsComplex(prhs[0]);
+	if (!mxIsSingle(prhs[0]) && !(mxIsDouble(prhs[0]) && !isComplex)) {
+		mexErrMsgIdAndTxt("MeasFilters:polyDecimator:measRecords", "measRecords must be single or real double.");
+	}
+
+	//Get the size of the input data
+	//Expect recordLength x numSegments or recordLength x numWaveforms x numSegments X numRoundRobins
+	//Can treat all of these as recordLength x N
+	numDims = mxGetNumberOfDimensions(prhs[0]);
+	inDims = mxGetDimensions(prhs[0]);
+	recordLength = inDims[0];
+	numSegments = 1;
+	for (ct=1; ct < numDims; ct++) {
+		numSegments *= inDims[ct];
+	}
+
+	if (mxGetScalar(prhs[1]) < 1) {
+		mexErrMsgIdAndTxt("MeasFilters:polyDecimator:decimFactor", "decimFactor must be at least 1.");
+	}
+	decimFactor = (size_t)mxGetScalar(prhs[1]);
+	numTaps = (nrhs > 2) ? (size_t)mxGetScalar(prhs[2]) : PolyDecimator::DEFAULT_NUM_TAPS;
+	if (numTaps < 1) {
+		mexErrMsgIdAndTxt("MeasFilters:polyDecimator:numTaps", "numTaps must be at least 1.");
+	}
+	decimator.init(PolyDecimator::lowpass_taps(decimFactor, numTaps), decimFactor, recordLength);
+
+	// prepare the output buffer
+	outDims = (mwSize *)mxMalloc(numDims*sizeof(mwSize));
+	for (ct = 0; ct < numDims; ++ct)
+		outDims[ct] = inDims[ct];
+	outDims[0] = decimator.output_length();
+	plhs[0] = mxCreateNumericArray(numDims, outDims, mxSINGLE_CLASS, isComplex ? mxCOMPLEX : mxREAL);
+	mxFree(outDims);
+
+	//Apply the filter to each record
+	if (isComplex) {
+		decimator.execute((const float *)mxGetData(prhs[0]), (const float *)mxGetImagData(prhs[0]), numSegments,
+				(float *)mxGetData(plhs[0]), (float *)mxGetImagData(plhs[0]));
+	} else if (mxIsSingle(prhs[0])) {
+		decimator.execute((const float *)mxGetData(prhs[0]), numSegments, (float *)mxGetData(plhs[0]));
+	} else {
+		decimator.execute((const double *)mxGetData(prhs[0]), numSegments, (float *)mxGetData(plhs[0]));
+	}
+}
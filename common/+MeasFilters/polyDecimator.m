@@ -1,2 +1,4 @@
-function output = polyDecimator(input, decimFactor)
-% Implements a polyphase FIR filter to efficiently decimate the input signal by decimFactor.
\ No newline at end of file
+function output = polyDecimator(input, decimFactor, numTaps)
+% Implements a polyphase FIR filter to efficiently decimate the input signal by decimFactor.
+% input is single (real or complex) or real double with records along the
+% first dimension. numTaps defaults to the 16 tap Blackman low-pass.
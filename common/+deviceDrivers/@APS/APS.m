@@ -191,12 +191,10 @@ classdef APS < hgsetget
  			% only have to load it once.
 
             channelStrs = {'chan_1','chan_2','chan_3','chan_4'};
-            for ct = 1:4
-                ch = channelStrs{ct};
-				obj.setAmplitude(ct, settings.(ch).amplitude);
-				obj.setOffset(ct, settings.(ch).offset);
-                obj.setEnabled(ct, settings.(ch).enabled);
-            end
+            amplitudes = cellfun(@(ch) settings.(ch).amplitude, channelStrs);
+            offsets = cellfun(@(ch) settings.(ch).offset, channelStrs);
+            enables = cellfun(@(ch) settings.(ch).enabled, channelStrs);
+            obj.setChannelParams(1:4, offsets, amplitudes, enables);
             settings = rmfield(settings, channelStrs);
             
 			% load AWG file before doing anything else
@@ -278,6 +276,26 @@ classdef APS < hgsetget
             obj.setEnabled(ch, 1);
         end
         
+        function loadWaveforms(obj, chs, waveforms)
+            %loadWaveforms - loads waveforms for several channels in one call
+            % APS.loadWaveforms(chs, waveforms)
+            %   chs - vector of channels (1-4)
+            %   waveforms - cell array of int16 or double waveforms, one per channel
+            assert(all(chs>0) && all(chs<5), 'Oops! The channel must be in the range 1 through 4');
+            assert(length(chs) == length(waveforms), 'Oops! Need one waveform per channel');
+            numPts = cellfun(@length, waveforms);
+            assert(all(numPts<=obj.MAX_WAVFORM_LENGTH), 'Oops! Your waveform must be less than %d points', obj.MAX_WAVFORM_LENGTH+1)
+            waveforms = cellfun(@(wf) wf(:), waveforms, 'UniformOutput', false);
+            if all(cellfun(@(wf) isa(wf, 'int16'), waveforms))
+                status = obj.libraryCall('set_waveforms_int', length(chs), int32(chs-1), vertcat(waveforms{:}), int32(numPts));
+            else
+                waveforms = cellfun(@double, waveforms, 'UniformOutput', false);
+                status = obj.libraryCall('set_waveforms_float', length(chs), int32(chs-1), single(vertcat(waveforms{:})), int32(numPts));
+            end
+            assert(status == 0, 'set_waveforms returned error code %d', status);
+            obj.setChannelParams(chs, [], [], ones(size(chs)));
+        end
+        
         function loadConfig(aps, filename)
             %loadConfig - Loads a complete, 4 channel configuration hdf5 sequence file
             % APS.loadConfig(filename) 
@@ -287,6 +305,82 @@ classdef APS < hgsetget
             assert(status == 0, 'load_sequence_file returned error code %d', status);
         end
         
+        function opID = loadConfigAsync(aps, filename)
+            %loadConfigAsync - Starts loading a sequence file in the background
+            % opID = APS.loadConfigAsync(filename)
+            %   filename - full path to hdf5 sequence file
+            %   opID - pass to waitOp to wait for the load to finish
+            opID = aps.libraryCall('load_sequence_file_async', [filename 0]);
+            assert(opID > 0, 'load_sequence_file_async returned error code %d', opID);
+        end
+        
+        function status = waitOp(aps, opID, timeout)
+            %waitOp - Waits for an async operation and returns its status
+            % status = APS.waitOp(opID, timeout)
+            %   timeout - seconds to wait (default forever); errors if the operation is still running
+            if ~exist('timeout', 'var')
+                timeout = -1;
+            end
+            finished = calllib(aps.library_name, 'op_wait', opID, round(1000*timeout));
+            assert(finished == 1, 'APS async operation %d did not finish in time', opID);
+            status = calllib(aps.library_name, 'op_result', opID);
+        end
+        
+        function loadCompiledConfig(aps, filename)
+            %loadCompiledConfig - Loads a sequence converted with compileConfig
+            % APS.loadCompiledConfig(filename)
+            %   filename - full path to compiled sequence file
+            status = aps.libraryCall('load_compiled_sequence', [filename 0]);
+            assert(status == 0, 'load_compiled_sequence returned error code %d', status);
+        end
+        
+        function compileConfig(aps, filename, compiledFile)
+            %compileConfig - Converts an hdf5 sequence file to the memory mappable compiled format
+            % APS.compileConfig(filename, compiledFile)
+            %   filename - full path to hdf5 sequence file
+            %   compiledFile - full path of the compiled file to write
+            status = calllib(aps.library_name, 'compile_sequence_file', [filename 0], [compiledFile 0]);
+            assert(status == 0, 'compile_sequence_file returned error code %d', status);
+        end
+        
+        function saveState(aps, filename)
+            %saveState - Snapshot waveforms, LLs and settings to an hdf5 file
+            % APS.saveState(filename)
+            %   filename - full path of the state file ('' for cache_<serial>.h5)
+            status = aps.libraryCall('save_state_file', [filename 0]);
+            assert(status == 0, 'save_state_file returned error code %d', status);
+        end
+        
+        function restoreState(aps, filename)
+            %restoreState - Put the APS back in the configuration saved with saveState
+            % APS.restoreState(filename)
+            %   filename - full path of the state file ('' for cache_<serial>.h5)
+            status = aps.libraryCall('restore_to_device', [filename 0]);
+            assert(status == 0, 'restore_to_device returned error code %d', status);
+        end
+        
+        function setDoubleBuffered(aps, enable)
+            %setDoubleBuffered - Split waveform memory in two so the next sequence can be staged while one plays
+            % APS.setDoubleBuffered(enable)
+            status = aps.libraryCall('set_double_buffered', enable);
+            assert(status == 0, 'set_double_buffered returned error code %d', status);
+        end
+        
+        function stageConfig(aps, filename)
+            %stageConfig - Loads the next hdf5 sequence file into the inactive half of memory while running
+            % APS.stageConfig(filename)
+            %   filename - full path to hdf5 sequence file
+            status = aps.libraryCall('stage_sequence_file', [filename 0]);
+            assert(status == 0, 'stage_sequence_file returned error code %d', status);
+        end
+        
+        function switchConfig(aps)
+            %switchConfig - Switches playback to the staged sequence at the next miniLL boundary
+            % APS.switchConfig()
+            status = aps.libraryCall('switch_sequence');
+            assert(status == 0, 'switch_sequence returned error code %d', status);
+        end
+        
         function loadLL(obj, ch, addr, count, trigger1, trigger2, repeat)
             %loadLL - Directly loads link list data into memory (if it fits)
             % APS.loadLL(ch, addr, count, trigger1, trigger2, repeat)
@@ -388,6 +482,23 @@ classdef APS < hgsetget
             value =  aps.readRegister(1, 9);
         end
         
+        function val = setChannelParams(aps, chs, offsets, amplitudes, enables)
+            %setChannelParams - Sets offset, amplitude and enabled for several channels in one call
+            % APS.setChannelParams(chs, offsets, amplitudes, enables)
+            %   chs - vector of channels (1-4)
+            %   offsets, amplitudes, enables - one value per channel or [] to leave unchanged
+            args = {offsets, amplitudes, enables};
+            types = {@single, @single, @int32};
+            for ct = 1:3
+                if isempty(args{ct})
+                    args{ct} = libpointer;
+                else
+                    args{ct} = types{ct}(args{ct});
+                end
+            end
+            val = aps.libraryCall('set_channel_params', length(chs), int32(chs-1), args{:});
+        end
+        
         function val = setOffset(aps, ch, offset)
             %setOffset - Sets the channel offset. 
             % APS.setOffset(ch, offset)
@@ -476,6 +587,28 @@ classdef APS < hgsetget
             calllib(aps.library_name, 'set_logging_level', level);
         end
         
+        function stats = getPerfStats(aps)
+            % per operation call counts, bytes, USB transfers and latency
+            % percentiles (ns) for all units, decoded from the library's JSON
+            len = calllib(aps.library_name, 'get_perf_stats', blanks(1), 1);
+            [~, statsStr] = calllib(aps.library_name, 'get_perf_stats', blanks(len+1), len+1);
+            stats = jsondecode(statsStr);
+        end
+        
+        function resetPerfStats(aps)
+            calllib(aps.library_name, 'reset_perf_stats');
+        end
+        
+        function enableTrace(aps, enable)
+            % record a timeline of init, sequence loading and streaming for all units
+            calllib(aps.library_name, 'enable_trace', enable);
+        end
+        
+        function val = exportTrace(aps, traceFile)
+            % write the recorded timeline as Chrome trace-event JSON (open in chrome://tracing)
+            val = calllib(aps.library_name, 'export_trace', traceFile);
+        end
+        
         function val = readRegister(aps, fpga, addr)
             val = aps.libraryCall('read_register', fpga, addr);
         end
@@ -488,6 +621,17 @@ classdef APS < hgsetget
             pllLock = bitget(regVal, 7);
         end
         
+        function unloadLibrary(obj)
+            %unloadLibrary - Stops the library's background threads and unloads it
+            % APS.unloadLibrary()
+            %   Disconnect every APS first. Unloading libaps any other way can hang MATLAB
+            %   if a streaming, async or logging thread is still running.
+            if libisloaded(obj.library_name)
+                calllib(obj.library_name, 'cleanup');
+                unloadlibrary(obj.library_name);
+            end
+        end
+        
     end %public methods
 
     %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
@@ -9,6 +9,8 @@ fcns=struct('name',ival,'calltype',ival,'LHS',ival,'RHS',ival,'alias',ival);
 ThunkLibName=[];
 %  int init (); 
 fcns.name{fcnNum}='init'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}=[];fcnNum=fcnNum+1;
+%  int cleanup (); 
+fcns.name{fcnNum}='cleanup'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}=[];fcnNum=fcnNum+1;
 %  int get_numDevices (); 
 fcns.name{fcnNum}='get_numDevices'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}=[];fcnNum=fcnNum+1;
 %  void get_deviceSerial ( int , char *); 
@@ -41,6 +43,8 @@ fcns.name{fcnNum}='set_channel_scale'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{f
 fcns.name{fcnNum}='get_channel_scale'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='single'; fcns.RHS{fcnNum}={'int32', 'int32'};fcnNum=fcnNum+1;
 %  int set_channel_enabled ( int , int , int ); 
 fcns.name{fcnNum}='set_channel_enabled'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32', 'int32', 'int32'};fcnNum=fcnNum+1;
+%  int set_channel_params ( int , int , int *, float *, float *, int *); 
+fcns.name{fcnNum}='set_channel_params'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32', 'int32', 'int32Ptr', 'singlePtr', 'singlePtr', 'int32Ptr'};fcnNum=fcnNum+1;
 %  int get_channel_enabled ( int , int ); 
 fcns.name{fcnNum}='get_channel_enabled'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32', 'int32'};fcnNum=fcnNum+1;
 %  int set_trigger_source ( int , int ); 
@@ -57,14 +61,52 @@ fcns.name{fcnNum}='set_miniLL_repeat'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{f
 fcns.name{fcnNum}='set_waveform_float'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32', 'int32', 'singlePtr', 'int32'};fcnNum=fcnNum+1;
 %  int set_waveform_int ( int , int , short *, int ); 
 fcns.name{fcnNum}='set_waveform_int'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32', 'int32', 'int16Ptr', 'int32'};fcnNum=fcnNum+1;
+%  int set_waveforms_float ( int , int , int *, float *, int *); 
+fcns.name{fcnNum}='set_waveforms_float'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32', 'int32', 'int32Ptr', 'singlePtr', 'int32Ptr'};fcnNum=fcnNum+1;
+%  int set_waveforms_int ( int , int , int *, short *, int *); 
+fcns.name{fcnNum}='set_waveforms_int'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32', 'int32', 'int32Ptr', 'int16Ptr', 'int32Ptr'};fcnNum=fcnNum+1;
 %  int set_LL_data_IQ ( int , int , int , unsigned short *, unsigned short *, unsigned short *, unsigned short *, unsigned short *); 
 fcns.name{fcnNum}='set_LL_data_IQ'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32', 'int32', 'int32', 'uint16Ptr', 'uint16Ptr', 'uint16Ptr', 'uint16Ptr', 'uint16Ptr'};fcnNum=fcnNum+1;
+%  int set_waveform_strided ( int , int , const void *, int , int , int ); 
+fcns.name{fcnNum}='set_waveform_strided'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32', 'int32', 'voidPtr', 'int32', 'int32', 'int32'};fcnNum=fcnNum+1;
+%  int set_LL_data_IQ_strided ( int , int , int , int , int , const void *, const void *, const void *, const void *, const void *); 
+fcns.name{fcnNum}='set_LL_data_IQ_strided'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32', 'int32', 'int32', 'int32', 'int32', 'voidPtr', 'voidPtr', 'voidPtr', 'voidPtr', 'voidPtr'};fcnNum=fcnNum+1;
 %  int set_run_mode ( int , int , int ); 
 fcns.name{fcnNum}='set_run_mode'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32', 'int32', 'int32'};fcnNum=fcnNum+1;
 %  int set_repeat_mode ( int , int , int ); 
 fcns.name{fcnNum}='set_repeat_mode'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32', 'int32', 'int32'};fcnNum=fcnNum+1;
 %  int load_sequence_file ( int , const char *); 
 fcns.name{fcnNum}='load_sequence_file'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32', 'cstring'};fcnNum=fcnNum+1;
+%  int compile_sequence_file ( const char * , const char *); 
+fcns.name{fcnNum}='compile_sequence_file'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'cstring', 'cstring'};fcnNum=fcnNum+1;
+%  int load_compiled_sequence ( int , const char *); 
+fcns.name{fcnNum}='load_compiled_sequence'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32', 'cstring'};fcnNum=fcnNum+1;
+%  int set_double_buffered ( int , int ); 
+fcns.name{fcnNum}='set_double_buffered'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32', 'int32'};fcnNum=fcnNum+1;
+%  int stage_sequence_file ( int , const char *); 
+fcns.name{fcnNum}='stage_sequence_file'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32', 'cstring'};fcnNum=fcnNum+1;
+%  int switch_sequence ( int ); 
+fcns.name{fcnNum}='switch_sequence'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32'};fcnNum=fcnNum+1;
+%  int init_async ( int , char *, int); 
+fcns.name{fcnNum}='init_async'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32', 'cstring', 'int32'};fcnNum=fcnNum+1;
+%  int load_sequence_file_async ( int , const char *); 
+fcns.name{fcnNum}='load_sequence_file_async'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32', 'cstring'};fcnNum=fcnNum+1;
+%  int load_compiled_sequence_async ( int , const char *); 
+fcns.name{fcnNum}='load_compiled_sequence_async'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32', 'cstring'};fcnNum=fcnNum+1;
+%  int restore_to_device_async ( int , const char *); 
+fcns.name{fcnNum}='restore_to_device_async'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32', 'cstring'};fcnNum=fcnNum+1;
+%  int set_waveform_float_async ( int , int , float *, int); 
+fcns.name{fcnNum}='set_waveform_float_async'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32', 'int32', 'singlePtr', 'int32'};fcnNum=fcnNum+1;
+%  int set_waveform_int_async ( int , int , short *, int); 
+fcns.name{fcnNum}='set_waveform_int_async'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32', 'int32', 'int16Ptr', 'int32'};fcnNum=fcnNum+1;
+%  int op_poll ( int); 
+fcns.name{fcnNum}='op_poll'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32'};fcnNum=fcnNum+1;
+%  int op_wait ( int , int); 
+fcns.name{fcnNum}='op_wait'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32', 'int32'};fcnNum=fcnNum+1;
+%  int op_result ( int); 
+fcns.name{fcnNum}='op_result'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32'};fcnNum=fcnNum+1;
+%  int op_discard ( int); 
+fcns.name{fcnNum}='op_discard'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32'};fcnNum=fcnNum+1;
 %  int clear_channel_data ( int ); 
 fcns.name{fcnNum}='clear_channel_data'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32'};fcnNum=fcnNum+1;
 %  int run ( int ); 
@@ -77,6 +119,14 @@ fcns.name{fcnNum}='get_running'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}
 fcns.name{fcnNum}='set_log'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'cstring'};fcnNum=fcnNum+1;
 %  int set_logging_level ( int ); 
 fcns.name{fcnNum}='set_logging_level'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32'};fcnNum=fcnNum+1;
+%  int get_perf_stats ( char *, int ); 
+fcns.name{fcnNum}='get_perf_stats'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'cstring', 'int32'};fcnNum=fcnNum+1;
+%  int reset_perf_stats (); 
+fcns.name{fcnNum}='reset_perf_stats'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}=[];fcnNum=fcnNum+1;
+%  int enable_trace ( int ); 
+fcns.name{fcnNum}='enable_trace'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32'};fcnNum=fcnNum+1;
+%  int export_trace ( const char *); 
+fcns.name{fcnNum}='export_trace'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'cstring'};fcnNum=fcnNum+1;
 %  int save_state_files (); 
 fcns.name{fcnNum}='save_state_files'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}=[];fcnNum=fcnNum+1;
 %  int read_state_files (); 
@@ -85,6 +135,10 @@ fcns.name{fcnNum}='read_state_files'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fc
 fcns.name{fcnNum}='save_bulk_state_file'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}=[];fcnNum=fcnNum+1;
 %  int read_bulk_state_file (); 
 fcns.name{fcnNum}='read_bulk_state_file'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}=[];fcnNum=fcnNum+1;
+%  int save_state_file ( int , const char *); 
+fcns.name{fcnNum}='save_state_file'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32', 'cstring'};fcnNum=fcnNum+1;
+%  int restore_to_device ( int , const char *); 
+fcns.name{fcnNum}='restore_to_device'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32', 'cstring'};fcnNum=fcnNum+1;
 %  int raw_write ( int , int , unsigned char *); 
 fcns.name{fcnNum}='raw_write'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32', 'int32', 'uint8Ptr'};fcnNum=fcnNum+1;
 %  int raw_read ( int , int ); 
@@ -95,5 +149,5 @@ fcns.name{fcnNum}='read_register'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNu
 fcns.name{fcnNum}='read_status_ctrl'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32'};fcnNum=fcnNum+1;
 %  int program_FPGA ( int , char *, int , int ); 
 fcns.name{fcnNum}='program_FPGA'; fcns.calltype{fcnNum}='cdecl'; fcns.LHS{fcnNum}='int32'; fcns.RHS{fcnNum}={'int32', 'cstring', 'int32', 'int32'};fcnNum=fcnNum+1;
-enuminfo.APSErrorCode=struct('APS_OK',0,'APS_UNKNOWN_ERROR',-1,'APS_FILE_ERROR',-2);
+enuminfo.APSErrorCode=struct('APS_OK',0,'APS_UNKNOWN_ERROR',-1,'APS_FILE_ERROR',-2,'APS_INVALID_OP',-3,'APS_OP_PENDING',-4,'APS_INVALID_DEVICE',-5);
 methodinfo=fcns;
\ No newline at end of file
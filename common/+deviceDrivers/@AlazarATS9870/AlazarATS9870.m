@@ -218,8 +218,11 @@ classdef AlazarATS9870 < deviceDrivers.lib.deviceDriverBase
             totNumBuffers = round(obj.settings.averager.nbrRoundRobins/obj.buffers.roundRobinsPerBuffer);
 
             if strcmp(obj.acquireMode, 'averager')
-                sumDataA = zeros([obj.settings.averager.recordLength, obj.settings.averager.nbrSegments]);
-                sumDataB = zeros([obj.settings.averager.recordLength, obj.settings.averager.nbrSegments]);
+                %Running sums of the raw sample codes, updated by processBufferAvg
+                sumDataA = zeros([obj.settings.averager.recordLength, obj.settings.averager.nbrSegments], 'uint64');
+                sumDataB = zeros([obj.settings.averager.recordLength, obj.settings.averager.nbrSegments], 'uint64');
+                bufferDims = [obj.settings.averager.recordLength, obj.settings.averager.nbrWaveforms, obj.settings.averager.nbrSegments, obj.buffers.roundRobinsPerBuffer];
+                useRunningSums = true;
             end
 
             %Loop until all are processed
@@ -257,9 +260,25 @@ classdef AlazarATS9870 < deviceDrivers.lib.deviceDriverBase
                     obj.data{2} = reshape(obj.data{2}, [obj.settings.averager.recordLength, obj.settings.averager.nbrWaveforms, obj.settings.averager.nbrSegments, obj.buffers.roundRobinsPerBuffer]);
                 else
                     %scale with averaging over repeats (waveforms and round robins)
-                    [obj.data{1}, obj.data{2}] = obj.processBufferAvg(bufferOut.Value, [obj.settings.averager.recordLength, obj.settings.averager.nbrWaveforms, obj.settings.averager.nbrSegments, obj.buffers.roundRobinsPerBuffer], obj.verticalScale);
-                    sumDataA = sumDataA + obj.data{1};
-                    sumDataB = sumDataB + obj.data{2};
+                    if useRunningSums
+                        try
+                            [obj.data{1}, obj.data{2}, sumDataA, sumDataB] = obj.processBufferAvg(bufferOut.Value, bufferDims, obj.verticalScale, sumDataA, sumDataB);
+                        catch err
+                            %processBufferAvg mex files built before the running sums only take 3 inputs
+                            if ~strcmp(err.identifier, 'AlazarATS9870:processBuffer:nrhs')
+                                rethrow(err);
+                            end
+                            warning('AlazarATS9870:processBufferAvg', 'processBufferAvg mex file is out of date; averaging in MATLAB');
+                            useRunningSums = false;
+                            sumDataA = zeros(size(sumDataA));
+                            sumDataB = zeros(size(sumDataB));
+                        end
+                    end
+                    if ~useRunningSums
+                        [obj.data{1}, obj.data{2}] = obj.processBufferAvg(bufferOut.Value, bufferDims, obj.verticalScale);
+                        sumDataA = sumDataA + double(obj.data{1});
+                        sumDataB = sumDataB + double(obj.data{2});
+                    end
                 end
 
                 notify(obj, 'DataReady');
@@ -273,9 +292,15 @@ classdef AlazarATS9870 < deviceDrivers.lib.deviceDriverBase
             end
             
             if strcmp(obj.acquireMode, 'averager')
-                %Average the summed data
-                obj.data{1} = sumDataA/totNumBuffers;
-                obj.data{2} = sumDataB/totNumBuffers;
+                if useRunningSums
+                    %Average the summed data and scale to (-Vs, Vs)
+                    avgScale = 2*obj.verticalScale/255/(totNumBuffers*obj.settings.averager.nbrWaveforms*obj.buffers.roundRobinsPerBuffer);
+                    obj.data{1} = avgScale*double(sumDataA) - obj.verticalScale;
+                    obj.data{2} = avgScale*double(sumDataB) - obj.verticalScale;
+                else
+                    obj.data{1} = sumDataA/totNumBuffers;
+                    obj.data{2} = sumDataB/totNumBuffers;
+                end
             end
 
             %Clear and reallocate the buffer ptrs
@@ -456,6 +481,6 @@ classdef AlazarATS9870 < deviceDrivers.lib.deviceDriverBase
     methods (Static)
         % externally defined methdos
         [dataA, dataB] = processBuffer(buffer, verticalScale);
-        [dataA, dataB] = processBufferAvg(buffer, bufferDims, verticalScale);
+        [dataA, dataB, sumA, sumB] = processBufferAvg(buffer, bufferDims, verticalScale, sumA, sumB);
     end
 end %classdef
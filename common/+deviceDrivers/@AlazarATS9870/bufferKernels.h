@@ -0,0 +1,193 @@
+/*
+ * bufferKernels.h
+ *
+ * Kernels behind the processBuffer and processBufferAvg MEX functions.
+ * The ATS9870 returns uint8 sample codes with all of channel A's records followed by all of channel B's.
+ * Codes [0, 255] map to (-Vs, Vs). Everything is inline so each MEX file builds on its own, e.g.
+ *     mex -largeArrayDims processBuffer.cpp
+ * The AVX2 paths are picked at run time so one binary runs on any x86 machine.
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef BUFFERKERNELS_H_
+#define BUFFERKERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+#include "../../util/kernelSupport.h"
+
+namespace BufferKernels {
+
+using KernelSupport::has_avx2;
+using KernelSupport::num_threads;
+using KernelSupport::parallel_for;
+
+//Work smaller than this many samples is done on the calling thread
+static const size_t PARALLEL_THRESHOLD = 1 << 20;
+//Never hand a thread less than this much work
+static const size_t MIN_CHUNK = 1 << 18;
+//Samples per record averaged as one cache block: 4 KB of uint16 lanes plus 8 KB of uint32 sums stay in L1
+static const size_t AVG_BLOCK = 2048;
+//Rows of codes a uint16 lane can hold before it has to be folded into the uint32 sums (257*255 = 65535)
+static const size_t MAX_UINT16_ROWS = 257;
+//Rows of codes a uint32 buffer sum can hold
+static const size_t MAX_UINT32_ROWS = 16843009;
+
+//How many threads to give workSize bytes or samples of work
+inline size_t num_chunks(const size_t & workSize, const size_t & minChunk) {
+	if (workSize < PARALLEL_THRESHOLD) return 1;
+	return std::min(num_threads(), std::max<size_t>(1, workSize / minChunk));
+}
+
+inline void convert_scalar(const uint8_t * codesA, const uint8_t * codesB, const size_t & begin, const size_t & end,
+		const float & dacScale, const float & verticalScale, float * dataA, float * dataB) {
+	for (size_t ct = begin; ct < end; ct++) {
+		dataA[ct] = dacScale * static_cast<float>(codesA[ct]) - verticalScale;
+		dataB[ct] = dacScale * static_cast<float>(codesB[ct]) - verticalScale;
+	}
+}
+
+#ifdef KERNELS_X86
+//Widen 16 codes to floats and apply scale and offset with an fma
+KERNELS_AVX2 inline void convert16_avx2(const uint8_t * codes, const __m256 & scale, const __m256 & offset, float * data) {
+	__m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i *>(codes));
+	__m256 lo = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(packed));
+	__m256 hi = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(packed, 8)));
+	_mm256_storeu_ps(data, _mm256_fmadd_ps(lo, scale, offset));
+	_mm256_storeu_ps(data + 8, _mm256_fmadd_ps(hi, scale, offset));
+}
+
+//fma rounds once so results can differ from convert_scalar in the last bit
+KERNELS_AVX2 inline void convert_avx2(const uint8_t * codesA, const uint8_t * codesB, const size_t & begin, const size_t & end,
+		const float & dacScale, const float & verticalScale, float * dataA, float * dataB) {
+	const __m256 scale = _mm256_set1_ps(dacScale);
+	const __m256 offset = _mm256_set1_ps(-verticalScale);
+	size_t ct = begin;
+	for (; ct + 32 <= end; ct += 32) {
+		convert16_avx2(codesA + ct, scale, offset, dataA + ct);
+		convert16_avx2(codesA + ct + 16, scale, offset, dataA + ct + 16);
+		convert16_avx2(codesB + ct, scale, offset, dataB + ct);
+		convert16_avx2(codesB + ct + 16, scale, offset, dataB + ct + 16);
+	}
+	convert_scalar(codesA, codesB, ct, end, dacScale, verticalScale, dataA, dataB);
+}
+#endif
+
+/*
+ * Split a buffer of bufferSize codes into its channel A and B halves and scale each to volts in one pass
+ * dataA and dataB are owned by the caller and must each hold bufferSize/2 floats
+ */
+inline void process_buffer(const uint8_t * buffer, const size_t & bufferSize, const float & verticalScale, float * dataA, float * dataB) {
+	const size_t numSamples = bufferSize / 2;
+	const float dacScale = 2.0 * verticalScale / 255.0;
+	const uint8_t * codesA = buffer;
+	const uint8_t * codesB = buffer + numSamples;
+	const bool useAVX2 = has_avx2();
+	parallel_for(numSamples, num_chunks(numSamples, MIN_CHUNK), 32, [=](size_t begin, size_t end) {
+#ifdef KERNELS_X86
+		if (useAVX2) {
+			convert_avx2(codesA, codesB, begin, end, dacScale, verticalScale, dataA, dataB);
+			return;
+		}
+#endif
+		convert_scalar(codesA, codesB, begin, end, dacScale, verticalScale, dataA, dataB);
+	});
+}
+
+inline void accumulate_row_scalar(const uint8_t * codes, const size_t & numSamples, uint16_t * lanes) {
+	for (size_t ct = 0; ct < numSamples; ct++) {
+		lanes[ct] += codes[ct];
+	}
+}
+
+#ifdef KERNELS_X86
+KERNELS_AVX2 inline void accumulate_row_avx2(const uint8_t * codes, const size_t & numSamples, uint16_t * lanes) {
+	size_t ct = 0;
+	for (; ct + 32 <= numSamples; ct += 32) {
+		__m256i packed = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(codes + ct));
+		__m256i * lo = reinterpret_cast<__m256i *>(lanes + ct);
+		__m256i * hi = reinterpret_cast<__m256i *>(lanes + ct + 16);
+		_mm256_storeu_si256(lo, _mm256_add_epi16(_mm256_loadu_si256(lo), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(packed))));
+		_mm256_storeu_si256(hi, _mm256_add_epi16(_mm256_loadu_si256(hi), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(packed, 1))));
+	}
+	accumulate_row_scalar(codes + ct, numSamples - ct, lanes + ct);
+}
+#endif
+
+/*
+ * Average a buffer over waveforms and round robins
+ * bufferDims are [record length x waveforms x segments x round robins] and each channel's half of the
+ * buffer is laid out in that order. dataA and dataB get the record length x segments averages in volts.
+ * When sumA and sumB aren't null the raw codes are also added into them so the caller can keep
+ * running sums across buffers. All outputs are owned by the caller and hold recordLength*numSegments elements.
+ * Each block of samples is summed exactly in integers and only scaled once at the end.
+ * numWaveforms*numRoundRobins must be no more than MAX_UINT32_ROWS.
+ */
+inline void process_buffer_avg(const uint8_t * buffer, const size_t bufferDims[4], const float & verticalScale,
+		float * dataA, float * dataB, uint64_t * sumA, uint64_t * sumB) {
+	const size_t recordLength = bufferDims[0];
+	const size_t numWaveforms = bufferDims[1];
+	const size_t numSegments = bufferDims[2];
+	const size_t numRoundRobins = bufferDims[3];
+	const size_t numRows = numWaveforms * numRoundRobins;
+	const size_t channelSize = recordLength * numWaveforms * numSegments * numRoundRobins;
+	const double avgScale = 2.0 * verticalScale / 255.0 / numRows;
+	const size_t blocksPerRecord = (recordLength + AVG_BLOCK - 1) / AVG_BLOCK;
+	//One task per channel, segment and block of the record
+	const size_t numTasks = 2 * numSegments * blocksPerRecord;
+	const bool useAVX2 = has_avx2();
+
+	parallel_for(numTasks, std::min(numTasks, num_chunks(2 * channelSize, MIN_CHUNK)), 1, [=](size_t begin, size_t end) {
+		uint16_t lanes[AVG_BLOCK];
+		uint32_t sums[AVG_BLOCK];
+		for (size_t task = begin; task < end; task++) {
+			const size_t channel = task / (numSegments * blocksPerRecord);
+			const size_t segment = (task / blocksPerRecord) % numSegments;
+			const size_t blockStart = (task % blocksPerRecord) * AVG_BLOCK;
+			const size_t blockLength = std::min(AVG_BLOCK, recordLength - blockStart);
+			const uint8_t * segmentCodes = buffer + channel * channelSize + segment * recordLength * numWaveforms + blockStart;
+
+			std::fill(sums, sums + blockLength, 0);
+			std::fill(lanes, lanes + blockLength, 0);
+			size_t laneRows = 0;
+			for (size_t roundRobin = 0; roundRobin < numRoundRobins; roundRobin++) {
+				for (size_t waveform = 0; waveform < numWaveforms; waveform++) {
+					const uint8_t * codes = segmentCodes + (waveform + roundRobin * numWaveforms * numSegments) * recordLength;
+#ifdef KERNELS_X86
+					if (useAVX2) {
+						accumulate_row_avx2(codes, blockLength, lanes);
+					} else
+#endif
+					accumulate_row_scalar(codes, blockLength, lanes);
+					if (++laneRows == MAX_UINT16_ROWS) {
+						for (size_t ct = 0; ct < blockLength; ct++) {
+							sums[ct] += lanes[ct];
+						}
+						std::fill(lanes, lanes + blockLength, 0);
+						laneRows = 0;
+					}
+				}
+			}
+
+			const size_t outStart = segment * recordLength + blockStart;
+			float * data = (channel == 0 ? dataA : dataB) + outStart;
+			uint64_t * runningSum = (channel == 0 ? sumA : sumB);
+			for (size_t ct = 0; ct < blockLength; ct++) {
+				sums[ct] += lanes[ct];
+				data[ct] = static_cast<float>(avgScale * sums[ct] - verticalScale);
+			}
+			if (runningSum != nullptr) {
+				for (size_t ct = 0; ct < blockLength; ct++) {
+					runningSum[outStart + ct] += sums[ct];
+				}
+			}
+		}
+	});
+}
+
+} //end namespace BufferKernels
+
+#endif /* BUFFERKERNELS_H_ */
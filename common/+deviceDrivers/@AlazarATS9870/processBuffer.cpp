@@ -0,0 +1,41 @@
+#include "mex.h"
+#include "bufferKernels.h"
+
+/*
+ dataA, dataB = processBuffer(buffer, verticalScale)
+ */
+
+static mxArray * create_output(const mwSize & numSamples) {
+	// the kernel writes every element so skip zeroing the output
+	mxArray * output = mxCreateNumericMatrix(0, 0, mxSINGLE_CLASS, mxREAL);
+	mxSetData(output, mxMalloc(numSamples * sizeof(float)));
+	mxSetM(output, 1);
+	mxSetN(output, numSamples);
+	return output;
+}
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
+	const uint8_t *buffer;
+	mwSize bufferSize;
+	float verticalScale;
+	// error check inputs and outputs
+	if (nrhs != 2) {
+		mexErrMsgIdAndTxt("AlazarATS9870:processBuffer:nrhs", "2 inputs required.");
+	}
+	if (nlhs != 2) {
+		mexErrMsgIdAndTxt("AlazarATS9870:processBuffer:nlhs", "2 outputs required.");
+	}
+	if (mxGetClassID(prhs[0]) != mxUINT8_CLASS) {
+		mexErrMsgIdAndTxt("AlazarATS9870:processBuffer:buffer", "buffer must be uint8.");
+	}
+
+	buffer = (const uint8_t *)mxGetData(prhs[0]);
+	bufferSize = mxGetNumberOfElements(prhs[0]);
+	verticalScale = mxGetScalar(prhs[1]);
+
+	// prepare outputs
+	plhs[0] = create_output(bufferSize/2);
+	plhs[1] = create_output(bufferSize/2);
+
+	BufferKernels::process_buffer(buffer, bufferSize, verticalScale, (float *)mxGetData(plhs[0]), (float *)mxGetData(plhs[1]));
+}
@@ -1,4 +1,4 @@
 function [dataA, dataB] = processBuffer(buffer, verticalScale)
 % PROCESSBUFFER takes an input buffer of uint8s and splits into two output 
-% buffers, dataA and dataB, that are doubles. It scales the input data
-% from [0, 255] to (-Vs, Vs).
\ No newline at end of file
+% buffers, dataA and dataB, that are singles. It scales the input data
+% from [0, 255] to (-Vs, Vs).
@@ -0,0 +1,79 @@
+#include "mex.h"
+#include "bufferKernels.h"
+
+/*
+ dataA, dataB = processBufferAvg(buffer, bufferDims, verticalScale)
+ dataA, dataB, sumA, sumB = processBufferAvg(buffer, bufferDims, verticalScale, sumA, sumB)
+ The second form also returns the running sums sumA and sumB with the buffer's raw sample codes added in.
+ They are uint64 arrays of recordLength*nbrSegments elements; after N buffers the average is
+     2*verticalScale/255/(N*nbrWaveforms*roundRobinsPerBuffer) * double(sumA) - verticalScale
+ */
+
+static mxArray * create_output(const mwSize & numRows, const mwSize & numCols) {
+	// the kernel writes every element so skip zeroing the output
+	mxArray * output = mxCreateNumericMatrix(0, 0, mxSINGLE_CLASS, mxREAL);
+	mxSetData(output, mxMalloc(numRows * numCols * sizeof(float)));
+	mxSetM(output, numRows);
+	mxSetN(output, numCols);
+	return output;
+}
+
+// inputs can't be modified so the updated sums go out in a copy
+static mxArray * create_running_sum(const mxArray * sum, const mwSize & numElements) {
+	if (mxGetClassID(sum) != mxUINT64_CLASS || mxIsComplex(sum) || mxGetNumberOfElements(sum) != numElements) {
+		mexErrMsgIdAndTxt("AlazarATS9870:processBuffer:sum", "sumA and sumB must be uint64 arrays with recordLength*nbrSegments elements.");
+	}
+	return mxDuplicateArray(sum);
+}
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
+	const uint8_t *buffer;
+	mwSize bufferSize, checkSize;
+	size_t bufferDims[4];
+	double *dims;
+	float verticalScale;
+	uint64_t *sumA = nullptr, *sumB = nullptr;
+	// error check inputs and outputs
+	if (nrhs != 3 && nrhs != 5) {
+		mexErrMsgIdAndTxt("AlazarATS9870:processBuffer:nrhs", "3 or 5 inputs required.");
+	}
+	if (nlhs != nrhs - 1) {
+		mexErrMsgIdAndTxt("AlazarATS9870:processBuffer:nlhs", "2 outputs required with 3 inputs and 4 with 5 inputs.");
+	}
+	if (mxGetClassID(prhs[0]) != mxUINT8_CLASS) {
+		mexErrMsgIdAndTxt("AlazarATS9870:processBuffer:buffer", "buffer must be uint8.");
+	}
+
+	buffer = (const uint8_t *)mxGetData(prhs[0]);
+	bufferSize = mxGetNumberOfElements(prhs[0]);
+	if (!mxIsDouble(prhs[1]) || mxGetNumberOfElements(prhs[1]) != 4) {
+		mexErrMsgIdAndTxt("AlazarATS9870:processBuffer:bufferDims", "Expected a 4 element bufferDims vector.");
+	}
+	// bufferDims are [record length x waveforms x segments x round robins per buffer]
+	dims = mxGetPr(prhs[1]);
+	checkSize = 1;
+	for (int ct = 0; ct < 4; ct++) {
+		bufferDims[ct] = dims[ct];
+		checkSize *= bufferDims[ct];
+	}
+	if (2*checkSize != bufferSize) {
+		mexErrMsgIdAndTxt("AlazarATS9870:processBuffer:bufferSize", "length(buffer) and 2*prod(bufferDims) do not match.");
+	}
+	if (bufferDims[1]*bufferDims[3] > BufferKernels::MAX_UINT32_ROWS) {
+		mexErrMsgIdAndTxt("AlazarATS9870:processBuffer:bufferDims", "Too many waveforms and round robins per buffer to sum.");
+	}
+
+	verticalScale = mxGetScalar(prhs[2]);
+
+	// prepare outputs
+	if (nrhs == 5) {
+		plhs[2] = create_running_sum(prhs[3], bufferDims[0]*bufferDims[2]);
+		plhs[3] = create_running_sum(prhs[4], bufferDims[0]*bufferDims[2]);
+		sumA = (uint64_t *)mxGetData(plhs[2]);
+		sumB = (uint64_t *)mxGetData(plhs[3]);
+	}
+	plhs[0] = create_output(bufferDims[0], bufferDims[2]);
+	plhs[1] = create_output(bufferDims[0], bufferDims[2]);
+
+	BufferKernels::process_buffer_avg(buffer, bufferDims, verticalScale, (float *)mxGetData(plhs[0]), (float *)mxGetData(plhs[1]), sumA, sumB);
+}
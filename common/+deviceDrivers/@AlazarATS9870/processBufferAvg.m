@@ -1,5 +1,7 @@
-function [dataA, dataB] = processBufferAvg(buffer, bufferDims, verticalScale)
+function [dataA, dataB, sumA, sumB] = processBufferAvg(buffer, bufferDims, verticalScale, sumA, sumB)
 % PROCESSBUFFERAVG
 %  buffer - input buffer of uint8s
 %  bufferDims - 4 element vector o[record length x waveforms x segments x round robins per buffer]
-%  verticalScale - scale input data from [0, 255] to (-Vs, Vs).
\ No newline at end of file
+%  verticalScale - scale input data from [0, 255] to (-Vs, Vs).
+%  sumA, sumB - optional uint64 running sums of the raw sample codes over
+%  buffers; returned with the buffer added in
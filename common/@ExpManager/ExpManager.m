@@ -56,6 +56,7 @@ classdef ExpManager < handle
         saveVariances = false
         dataFileHeader = struct();
         dataTimeout = 60 % timeout in seconds
+        bufferct = 0 % buffers handed to the measurement filters
     end
     
     methods
@@ -275,6 +276,9 @@ classdef ExpManager < handle
         function process_data(obj, src, ~)
             % download data from src
             measData = struct('ch1', src.transfer_waveform(1), 'ch2', src.transfer_waveform(2));
+            %Tag the buffer so filters sharing work on it (see Channelizer) can tell a new one cheaply
+            obj.bufferct = obj.bufferct + 1;
+            measData.bufferct = obj.bufferct;
             %Apply measurment filters in turn
             structfun(@(m) apply(m, measData), obj.measurements, 'UniformOutput', false);
         end
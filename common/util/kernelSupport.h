@@ -0,0 +1,146 @@
+/*
+ * kernelSupport.h
+ *
+ * Threading and instruction set dispatch shared by the native measurement filters and digitizer buffer kernels.
+ * x86 builds pick their AVX2 kernels at run time so one binary runs on any machine;
+ * NEON is always there on 64 bit ARM so those kernels are chosen when compiling.
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef KERNELSUPPORT_H_
+#define KERNELSUPPORT_H_
+
+#include <cstddef>
+#include <cstdlib>
+#include <algorithm>
+#include <new>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define KERNELS_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(__aarch64__)
+#define KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+//MSVC compiles AVX2 intrinsics without any flags; gcc and clang need them enabled per function
+#if defined(KERNELS_X86) && defined(__GNUC__)
+#define KERNELS_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define KERNELS_AVX2
+#endif
+
+namespace KernelSupport {
+
+//Work smaller than this many input samples is done on the calling thread
+static const size_t PARALLEL_THRESHOLD = 1 << 16;
+
+inline bool has_avx2() {
+	static const bool avx2 = [](){
+#if defined(KERNELS_X86) && defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7) return false;
+		__cpuid(info, 1);
+		//FMA and OSXSAVE, then check the OS saves the YMM registers
+		if ((info[2] & (1 << 12)) == 0 || (info[2] & (1 << 27)) == 0) return false;
+		if ((_xgetbv(0) & 0x6) != 0x6) return false;
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#elif defined(KERNELS_X86)
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+		return false;
+#endif
+	}();
+	return avx2;
+}
+
+inline size_t num_threads() {
+	static const size_t numThreads = std::max(1u, std::thread::hardware_concurrency());
+	return numThreads;
+}
+
+//Threads to split numRecords records of recordLength samples over
+inline size_t num_chunks(const size_t & numRecords, const size_t & recordLength) {
+	return (numRecords * recordLength < PARALLEL_THRESHOLD) ? 1 : std::min(num_threads(), numRecords);
+}
+
+//Split [0, n) into numChunks contiguous chunks and call op(chunk, begin, end) on each from its own thread
+//Chunk edges fall on multiples of align so vector loops only have a tail in the last chunk
+template <typename F>
+void parallel_for_chunks(const size_t & n, const size_t & numChunks, const size_t & align, F op) {
+	if (numChunks < 2) {
+		op(size_t(0), size_t(0), n);
+		return;
+	}
+	size_t chunkLength = (n + numChunks - 1) / numChunks;
+	chunkLength = ((chunkLength + align - 1) / align) * align;
+	std::vector<std::thread> workers;
+	for (size_t chunk = 1; chunk * chunkLength < n; chunk++) {
+		workers.emplace_back(op, chunk, chunk * chunkLength, std::min(n, (chunk + 1) * chunkLength));
+	}
+	op(size_t(0), size_t(0), std::min(n, chunkLength));
+	for (auto & worker : workers) {
+		worker.join();
+	}
+}
+
+template <typename F>
+void parallel_for_chunks(const size_t & n, const size_t & numChunks, F op) {
+	parallel_for_chunks(n, numChunks, 1, op);
+}
+
+//As parallel_for_chunks for work that doesn't care which chunk it is
+template <typename F>
+void parallel_for(const size_t & n, const size_t & numChunks, const size_t & align, F op) {
+	parallel_for_chunks(n, numChunks, align, [&op](size_t, size_t begin, size_t end) {op(begin, end);});
+}
+
+template <typename F>
+void parallel_for(const size_t & n, const size_t & numChunks, F op) {
+	parallel_for(n, numChunks, 1, op);
+}
+
+//Allocates on cache lines so the vector kernels never split a load across two
+template <typename T>
+struct AlignedAllocator {
+	typedef T value_type;
+	static const size_t ALIGNMENT = 64;
+
+	AlignedAllocator() {};
+	template <typename U> AlignedAllocator(const AlignedAllocator<U> &) {};
+
+	T * allocate(const size_t & n) {
+		void * memory = nullptr;
+#ifdef _WIN32
+		memory = _aligned_malloc(n * sizeof(T), ALIGNMENT);
+#else
+		if (posix_memalign(&memory, ALIGNMENT, n * sizeof(T)) != 0) memory = nullptr;
+#endif
+		if (memory == nullptr) throw std::bad_alloc();
+		return static_cast<T *>(memory);
+	}
+	void deallocate(T * memory, const size_t &) {
+#ifdef _WIN32
+		_aligned_free(memory);
+#else
+		free(memory);
+#endif
+	}
+	template <typename U> bool operator==(const AlignedAllocator<U> &) const {return true;};
+	template <typename U> bool operator!=(const AlignedAllocator<U> &) const {return false;};
+};
+
+typedef std::vector<float, AlignedAllocator<float> > AlignedVector;
+
+} //end namespace KernelSupport
+
+#endif /* KERNELSUPPORT_H_ */
@@ -7,28 +7,33 @@
 
 #include "APS.h"
 
-APS::APS() :  isOpen{false}, deviceID_{-1}, handle_{nullptr}, channels_(4), samplingRate_{-1}, writeQueue_(0),
-				streaming_{false}, mymutex_{std::unique_ptr<std::mutex>(new std::mutex())} {}
+APS::APS() :  isOpen{false}, deviceID_{-1}, handle_{nullptr}, channels_(4), doubleBuffered_{false}, sequenceStaged_{false},
+				stagedChannels_(4), stagedMiniLLRepeat_{0}, miniLLRepeatPending_{false}, miniLLRepeat_{0}, activeWFOffset_{0}, samplingRate_{-1}, writeQueue_(0),
+				streaming_{false}, mymutex_{std::unique_ptr<std::recursive_mutex>(new std::recursive_mutex())} {}
 
 APS::APS(int deviceID, string deviceSerial) :  isOpen{false}, deviceID_{deviceID}, deviceSerial_{deviceSerial},
-		handle_{nullptr}, samplingRate_{-1}, writeQueue_(0), streaming_{false}, mymutex_{std::unique_ptr<std::mutex>(new std::mutex())} {
+		handle_{nullptr}, doubleBuffered_{false}, sequenceStaged_{false}, stagedMiniLLRepeat_{0}, miniLLRepeatPending_{false}, miniLLRepeat_{0}, activeWFOffset_{0},
+		samplingRate_{-1}, writeQueue_(0), myBankBouncerThread_(this), streaming_{false}, mymutex_{std::unique_ptr<std::recursive_mutex>(new std::recursive_mutex())} {
 			channels_.reserve(4);
-			myBankBouncerThreads_.reserve(4);
+			stagedChannels_.reserve(4);
 			for(size_t ct=0; ct<4; ct++){
 				channels_.push_back(Channel(ct));
-				myBankBouncerThreads_.emplace_back(ct, this);
+				stagedChannels_.push_back(Channel(ct));
 			}
 			checksums_[FPGA1] = CheckSum();
 			checksums_[FPGA2] = CheckSum();
 };
 
-APS::APS(APS && other) : isOpen{other.isOpen}, deviceID_{other.deviceID_}, deviceSerial_{other.deviceSerial_}, handle_{other.handle_}, samplingRate_{other.samplingRate_},
-		writeQueue_{std::move(other.writeQueue_)}, streaming_{other.streaming_.load()}, mymutex_{std::move(other.mymutex_)}{
+APS::APS(APS && other) : isOpen{other.isOpen}, deviceID_{other.deviceID_}, deviceSerial_{other.deviceSerial_}, handle_{other.handle_},
+		doubleBuffered_{other.doubleBuffered_}, sequenceStaged_{other.sequenceStaged_.load()}, stagedMiniLLRepeat_{other.stagedMiniLLRepeat_},
+		miniLLRepeatPending_{other.miniLLRepeatPending_},
+		miniLLRepeat_{other.miniLLRepeat_},		activeWFOffset_{other.activeWFOffset_}, samplingRate_{other.samplingRate_},
+		writeQueue_{std::move(other.writeQueue_)}, myBankBouncerThread_(this), streaming_{other.streaming_.load()}, mymutex_{std::move(other.mymutex_)}{
 	channels_.reserve(4);
-	myBankBouncerThreads_.reserve(4);
+	stagedChannels_.reserve(4);
 	for(size_t ct=0; ct<4; ct++){
 		channels_.push_back(std::move(other.channels_[ct]));
-		myBankBouncerThreads_.push_back(std::move(other.myBankBouncerThreads_[ct]));
+		stagedChannels_.push_back(std::move(other.stagedChannels_[ct]));
 	}
 	checksums_[FPGA1] = other.checksums_[FPGA1];
 	checksums_[FPGA2] = other.checksums_[FPGA2];
@@ -55,6 +60,10 @@ int APS::connect(){
 
 int APS::disconnect(){
 	if (isOpen){
+		//Don't leave the streaming thread writing to a closed handle
+		if (myBankBouncerThread_.isRunning()){
+			stop();
+		}
 		int success = 0;
 		success = FTDI::disconnect(handle_);
 		if (success == 0) {
@@ -70,6 +79,29 @@ int APS::disconnect(){
 	}
 }
 
+int APS::shutdown(){
+	/*
+	 * Stop the streaming thread and drop the host copies of the sequences, which stops any LL prefetch
+	 * threads, so nothing is left for the destructor to join
+	 */
+	if (myBankBouncerThread_.isRunning()){
+		if (isOpen){
+			stop();
+		}
+		else{
+			myBankBouncerThread_.stop();
+		}
+	}
+	for (auto & ch : channels_) {
+		ch.clear_data();
+	}
+	for (auto & ch : stagedChannels_) {
+		ch.clear_data();
+	}
+	sequenceStaged_ = false;
+	return 0;
+}
+
 int APS::init(const string & bitFile, const bool & forceReload){
 	/* init
 	 * bitFile = path to a valid APS bitfile
@@ -78,6 +110,7 @@ int APS::init(const string & bitFile, const bool & forceReload){
 	 * Initializes the APS into its default ready state. Attempts to figure out if programming is necessary
 	 * by looking at the current bitfile version and the PLL status.
 	 */
+	Trace::Span span("init", deviceID_);
 
 	if (forceReload || read_bitFile_version(ALL_FPGAS) != FIRMWARE_VERSION || !read_PLL_status(ALL_FPGAS)) {
 		FILE_LOG(logINFO) << "Resetting instrument";
@@ -137,6 +170,8 @@ int APS::program_FPGA(const string & bitFile, const FPGASELECT & chipSelect, con
 	 * @param chipSelect which FPGA to write to (FPGA1, FPGA2, BOTH_FGPAS)
 	 * @param expectedVersion - checks whether version register matches this value after programming. -1 = skip the check
 	 */
+	PerfStats::Timer timer(PERF_PROGRAM_FPGA);
+	Trace::Span span("program_FPGA", deviceID_, "fpga", chipSelect);
 
 	//Open the bitfile
 	FILE_LOG(logDEBUG) << "Opening bitfile: " << bitFile;
@@ -155,6 +190,7 @@ int APS::program_FPGA(const string & bitFile, const FPGASELECT & chipSelect, con
 
 	//Pass of the data to a lower-level function to actually push it to the FPGA
 	int bytesProgrammed = FPGA::program_FPGA(handle_, fileData, chipSelect);
+	timer.add_bytes(std::max(bytesProgrammed, 0));
 
 	if (bytesProgrammed > 0 && expectedVersion != -1) {
 		// Read Bit File Version
@@ -236,6 +272,11 @@ int APS::clear_channel_data() {
 	for (auto & ch : channels_) {
 		ch.clear_data();
 	}
+	for (auto & ch : stagedChannels_) {
+		ch.clear_data();
+	}
+	sequenceStaged_ = false;
+	activeWFOffset_ = 0;
 	// clear waveform length registers
 	write(ALL_FPGAS, FPGA_ADDR_CHA_WF_LENGTH, 0, true);
 	write(ALL_FPGAS, FPGA_ADDR_CHB_WF_LENGTH, 0, true);
@@ -248,58 +289,588 @@ int APS::clear_channel_data() {
 	return 0;
 }
 
+int APS::read_sequence_channel(H5::H5File & H5SeqFile, const int & chanct, Channel & chan){
+	/*
+	 * Read the waveform library and any LL data for one channel of an open sequence file into chan
+	 * Returns 1 if the channel has IQ mode LL data, 0 if not, or -1 for a file from before isIQMode whose
+	 * multi-bank LL layout can't be loaded; the caller holds the HDF5 lock
+	 */
+	const vector<string> chanStrs = {"chan_1", "chan_2", "chan_3", "chan_4"};
+	//Load the waveform library first
+	string chanStr = chanStrs[chanct];
+	vector<short> tmpVec = h5array2vector<short>(&H5SeqFile, chanStr + "/waveformLib", H5::PredType::NATIVE_INT16);
+	chan.set_waveform(tmpVec);
+
+	//Check if there is the linklist data and if it is IQ mode style
+	H5::Group chanGroup = H5SeqFile.openGroup(chanStr);
+	USHORT isLinkListData, isIQMode;
+	isLinkListData = h5element2element<USHORT>("isLinkListData", &chanGroup, H5::PredType::NATIVE_UINT16);
+	if (H5Aexists(chanGroup.getId(), "isIQMode") <= 0){
+		FILE_LOG(logERROR) << "Channel " << chanct+1 << " has no isIQMode attribute; sequence files in the old multi-bank format can't be loaded";
+		chanGroup.close();
+		return -1;
+	}
+	isIQMode = h5element2element<USHORT>("isIQMode", &chanGroup, H5::PredType::NATIVE_UINT16);
+	chanGroup.close();
+
+	//Load the linklist data
+	if (isLinkListData){
+		chan.LLBank_.IQMode = isIQMode;
+		chan.LLBank_.read_state_from_hdf5(H5SeqFile, chanStr+"/linkListData");
+	}
+	return (isLinkListData && isIQMode) ? 1 : 0;
+}
+
+int APS::read_sequence_repeat(H5::H5File & H5SeqFile, USHORT & miniLLRepeat){
+	/*
+	 * Read the miniLL repeat count of an open sequence file; the caller holds the HDF5 lock
+	 * Returns -1 for a file from before miniLLRepeat
+	 */
+	H5::Group rootGroup = H5SeqFile.openGroup("/");
+	if (H5Aexists(rootGroup.getId(), "miniLLRepeat") <= 0){
+		FILE_LOG(logERROR) << "Sequence file has no miniLLRepeat attribute";
+		rootGroup.close();
+		return -1;
+	}
+	miniLLRepeat = h5element2element<USHORT>("miniLLRepeat", &rootGroup, H5::PredType::NATIVE_UINT16);
+	rootGroup.close();
+	return 0;
+}
+
+USHORT APS::fold_sequence_repeats(vector<Channel> & chans, const USHORT & miniLLRepeat){
+	/*
+	 * Fold runs of identical miniLLs into the miniLL repeat count when every LL bank allows it
+	 * The repeat register is shared so all banks have to fold by the same factor
+	 * Returns the new miniLL repeat count
+	 */
+	size_t foldFactor = 0;
+	for (auto & chan : chans){
+		if (chan.LLBank_.length > 0){
+			size_t bankFactor = chan.LLBank_.miniLL_repeat_factor();
+			while (bankFactor != 0){
+				size_t tmp = foldFactor % bankFactor;
+				foldFactor = bankFactor;
+				bankFactor = tmp;
+			}
+		}
+	}
+	if (foldFactor > 1 && (static_cast<size_t>(miniLLRepeat)+1)*foldFactor - 1 <= 0xFFFF){
+		FILE_LOG(logINFO) << "Folding repeated miniLLs by a factor of " << foldFactor;
+		for (auto & chan : chans){
+			if (chan.LLBank_.length > 0){
+				chan.LLBank_.fold_miniLL_repeats(foldFactor);
+			}
+		}
+		return (miniLLRepeat+1)*foldFactor - 1;
+	}
+	return miniLLRepeat;
+}
+
+int APS::check_LL_streamable(const LLBank & bank) const{
+	/*
+	 * The streaming thread writes a LL bank to the device a whole miniLL at a time so a bank that will be
+	 * streamed needs miniLLs and each of them has to fit in the device LL memory
+	 * Returns 0 if the bank can be played
+	 */
+	if (bank.length == 0 || (!doubleBuffered_ && bank.length <= MAX_LL_LENGTH)){
+		return 0;
+	}
+	if (bank.numMiniLLs == 0){
+		FILE_LOG(logERROR) << "LL of " << bank.length << " entries has to be streamed but has no miniLLs";
+		return -1;
+	}
+	size_t maxSpan = bank.max_miniLL_span();
+	if (maxSpan >= MAX_LL_LENGTH){
+		FILE_LOG(logERROR) << "LL has a miniLL of " << maxSpan << " entries which does not fit in the device LL memory";
+		return -2;
+	}
+	return 0;
+}
+
+int APS::check_LL_streamable(const vector<Channel> & chans) const{
+	for (const auto & chan : chans){
+		int status = check_LL_streamable(chan.LLBank_);
+		if (status != 0){
+			FILE_LOG(logERROR) << "Channel " << chan.number+1 << " LL can't be streamed";
+			return status;
+		}
+	}
+	return 0;
+}
+
 int APS::load_sequence_file(const string & seqFile){
 	/*
 	 * Load a sequence file from an H5 file
 	 */
+	PerfStats::Timer timer(PERF_LOAD_SEQUENCE);
+	Trace::Span span("load_sequence_file", deviceID_);
 	//First open the file
 	try {
 		FILE_LOG(logINFO) << "Opening sequence file: " << seqFile;
+
+		vector<bool> chanIQMode(4, false);
+
+		typedef std::chrono::steady_clock LoadClock;
+		auto seconds_since = [](const LoadClock::time_point & start){
+			return std::chrono::duration<double>(LoadClock::now() - start).count();
+		};
+		LoadClock::time_point loadStart = LoadClock::now();
+		vector<double> readTime(4, 0), uploadTime(4, 0), readWaitTime(4, 0);
+		vector<int> readStatus(4, 0);
+		USHORT miniLLRepeat;
+		{
+			std::unique_lock<std::recursive_mutex> h5Lock(hdf5_mutex());
+			H5::H5File H5SeqFile(seqFile, H5F_ACC_RDONLY);
+
+			//Get the mini LL count
+			if (read_sequence_repeat(H5SeqFile, miniLLRepeat) != 0){
+				return -1;
+			}
+
+			//Two stage pipeline: a reader thread pulls channel N+1 out of the file while channel N is uploaded
+			//Only the reader thread touches the file until the pipeline drains and it takes the HDF5 lock a channel
+			//at a time so other devices can get at their files during the uploads
+			auto read_channel = [&](int chanct){
+				Trace::Span readSpan("hdf5_read", deviceID_, "channel", chanct);
+				LoadClock::time_point start = LoadClock::now();
+				HDF5Lock readLock(hdf5_mutex());
+				readStatus[chanct] = read_sequence_channel(H5SeqFile, chanct, channels_[chanct]);
+				chanIQMode[chanct] = (readStatus[chanct] > 0);
+				readTime[chanct] = seconds_since(start);
+			};
+
+			h5Lock.unlock();
+			try {
+				//For now assume 4 channel data
+				//Reset the channel data; this talks to the device so it has to wait until the HDF5 lock is dropped
+				clear_channel_data();
+
+				//TODO: check the channelDataFor attribute
+				std::future<void> nextRead = std::async(std::launch::async, read_channel, 0);
+				for(int chanct=0; chanct<4; chanct++){
+					LoadClock::time_point waitStart = LoadClock::now();
+					nextRead.get();
+					readWaitTime[chanct] = seconds_since(waitStart);
+					if (readStatus[chanct] < 0){
+						break;
+					}
+					if (check_waveform_length(chanct, channels_[chanct].waveform_.size()) != 0){
+						readStatus[chanct] = -2;
+						break;
+					}
+					if (chanct < 3){
+						nextRead = std::async(std::launch::async, read_channel, chanct+1);
+					}
+					LoadClock::time_point uploadStart = LoadClock::now();
+					Trace::Span prepSpan("prep_waveform", deviceID_, "channel", chanct);
+					vector<short> prepVec = channels_[chanct].prep_waveform();
+					prepSpan.finish();
+					write_waveform(chanct, prepVec);
+					uploadTime[chanct] = seconds_since(uploadStart);
+					FILE_LOG(logDEBUG) << "Channel " << chanct+1 << " read " << 1e3*readTime[chanct] << " ms; waveform upload " << 1e3*uploadTime[chanct] << " ms; waited on read " << 1e3*readWaitTime[chanct] << " ms";
+				}
+			}
+			catch (...) {
+				//The reader is done by now; the file is closed on the way out and that needs the lock too
+				h5Lock.lock();
+				throw;
+			}
+			h5Lock.lock();
+			H5SeqFile.close();
+		}
+		auto failed = std::find_if(readStatus.begin(), readStatus.end(), [](const int & status){ return status < 0; });
+		if (failed != readStatus.end()){
+			int status = *failed;
+			clear_channel_data();
+			return status;
+		}
+
+		LoadClock::time_point foldStart = LoadClock::now();
+		Trace::Span foldSpan("fold_miniLLs", deviceID_);
+		miniLLRepeat = fold_sequence_repeats(channels_, miniLLRepeat);
+		foldSpan.finish();
+		double foldTime = seconds_since(foldStart);
+		if (check_LL_streamable(channels_) != 0){
+			clear_channel_data();
+			return -2;
+		}
+
+		//If the IQ LL is less than can fit on the chip then write it to the device
+		//In double buffered mode the streaming thread always writes the LL
+		LoadClock::time_point LLUploadStart = LoadClock::now();
+		for(int chanct=0; chanct<4; chanct++){
+			if (!doubleBuffered_ && chanIQMode[chanct] && channels_[chanct].LLBank_.length > 0 &&
+					channels_[chanct].LLBank_.length < MAX_LL_LENGTH){
+				write_LL_data_IQ(dac2fpga(chanct), 0, 0, channels_[chanct].LLBank_.length, true );
+			}
+		}
+		set_miniLL_repeat(miniLLRepeat);
+		double LLUploadTime = seconds_since(LLUploadStart);
+
+		//If the waits on the reader dominate the disk side is the bottleneck, otherwise the USB side is
+		auto sum = [](const vector<double> & vec){ return std::accumulate(vec.begin(), vec.end(), 0.0); };
+		FILE_LOG(logINFO) << "Loaded " << seqFile << " in " << 1e3*seconds_since(loadStart) << " ms: read " << 1e3*sum(readTime)
+				<< " ms; waveform upload " << 1e3*sum(uploadTime) << " ms; waited on read " << 1e3*sum(readWaitTime)
+				<< " ms; miniLL fold " << 1e3*foldTime << " ms; LL upload " << 1e3*LLUploadTime << " ms";
+		return 0;
+	}
+	catch (H5::FileIException & e) {
+		return -1;
+	}
+	return 0;
+}
+
+int APS::compile_sequence_file(const string & seqFile, const string & compiledFile){
+	/*
+	 * Convert an H5 sequence file to the memory mappable compiled format (see CompiledSequence.h)
+	 * Everything load_sequence_file does before talking to the device is done here once
+	 */
+	using namespace CompiledSequence;
+	vector<Channel> chans;
+	vector<bool> chanIQMode(4, false);
+	USHORT miniLLRepeat;
+	try {
+		FILE_LOG(logINFO) << "Compiling sequence file: " << seqFile << " to " << compiledFile;
+		HDF5Lock h5Lock(hdf5_mutex());
 		H5::H5File H5SeqFile(seqFile, H5F_ACC_RDONLY);
+		for(int chanct=0; chanct<4; chanct++){
+			chans.push_back(Channel(chanct));
+			int readStatus = read_sequence_channel(H5SeqFile, chanct, chans[chanct]);
+			if (readStatus < 0){
+				return -1;
+			}
+			chanIQMode[chanct] = (readStatus > 0);
+		}
+		if (read_sequence_repeat(H5SeqFile, miniLLRepeat) != 0){
+			return -1;
+		}
+		H5SeqFile.close();
+	}
+	catch (H5::Exception & e) {
+		return -1;
+	}
+	miniLLRepeat = fold_sequence_repeats(chans, miniLLRepeat);
+
+	Header header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.byteOrderMark = BYTE_ORDER_MARK;
+	header.miniLLRepeat = miniLLRepeat;
+
+	//Sections follow the header, each starting on an 8 byte boundary
+	vector<UCHAR> body;
+	auto add_section = [&](Section & section, const void * data, const size_t & numBytes){
+		body.resize((body.size() + 7) & ~static_cast<size_t>(7), 0);
+		section.offset = sizeof(Header) + body.size();
+		section.size = numBytes;
+		section.crc = crc32(static_cast<const UCHAR *>(data), numBytes);
+		body.insert(body.end(), static_cast<const UCHAR *>(data), static_cast<const UCHAR *>(data) + numBytes);
+	};
+	auto add_image = [&](Section & imageSection, Section & chunkSection, const WireImage & image){
+		vector<uint64_t> chunkEnds = image.chunk_ends();
+		add_section(imageSection, image.bytes.data(), image.bytes.size());
+		add_section(chunkSection, chunkEnds.data(), chunkEnds.size()*sizeof(uint64_t));
+	};
+
+	for(int chanct=0; chanct<4; chanct++){
+		Channel & chan = chans[chanct];
+		ChannelHeader & chanHeader = header.channels[chanct];
+		FPGASELECT fpga = dac2fpga(chanct);
+
+		//Waveform library as int16 for the host copy and its device image as write_waveform would send it
+		chanHeader.numSamples = chan.waveform_.size();
+		vector<short> samples(chan.waveform_.size());
+		std::transform(chan.waveform_.begin(), chan.waveform_.end(), samples.begin(), [](const float & val){
+			return static_cast<short>(std::lround(val*MAX_WF_AMP));
+		});
+		add_section(chanHeader.samples, samples.data(), samples.size()*sizeof(short));
+		WireImage wfImage;
+		if (!samples.empty()){
+			vector<short> prepVec = chan.prep_waveform();
+			bool chanA = (chanct % 2 == 0);
+			wfImage.append_write(fpga, chanA ? FPGA_ADDR_CHA_WF_LENGTH : FPGA_ADDR_CHB_WF_LENGTH, WordVec(1, prepVec.size()/WF_MODULUS - 1));
+			//The length register write doesn't go into the software checksums
+			wfImage.checksum = CheckSum{0, 0};
+			wfImage.append_write(fpga, chanA ? FPGA_BANKSEL_WF_CHA : FPGA_BANKSEL_WF_CHB, WordVec(prepVec.begin(), prepVec.end()));
+		}
+		add_image(chanHeader.wfImage, chanHeader.wfChunks, wfImage);
+		chanHeader.wfChecksum = wfImage.checksum;
+
+		//LL data with its miniLL index
+		LLBank & bank = chan.LLBank_;
+		if (bank.diskBacked){
+			FILE_LOG(logERROR) << "LL on channel " << chanct+1 << " is too long to compile; load the H5 file instead";
+			return -2;
+		}
+		WordVec rawData, packedData;
+		vector<uint64_t> miniLLData;
+		if (bank.length > 0){
+			chanHeader.flags = HAS_LL | (bank.IQMode ? IQ_MODE : 0);
+			chanHeader.LLLength = bank.length;
+			chanHeader.numMiniLLs = bank.numMiniLLs;
+			rawData = bank.raw_data();
+			packedData = bank.get_packed_data(0, bank.length);
+			miniLLData.insert(miniLLData.end(), bank.miniLLStartIdx.begin(), bank.miniLLStartIdx.end());
+			miniLLData.insert(miniLLData.end(), bank.miniLLLengths.begin(), bank.miniLLLengths.end());
+		}
+		add_section(chanHeader.LLArrays, rawData.data(), rawData.size()*sizeof(USHORT));
+		add_section(chanHeader.LLPacked, packedData.data(), packedData.size()*sizeof(USHORT));
+		add_section(chanHeader.miniLLs, miniLLData.data(), miniLLData.size()*sizeof(uint64_t));
+
+		//IQ LLs that fit on the chip get the same writes as write_LL_data_IQ(fpga, 0, 0, length, true)
+		//which always takes the data from the first channel on the FPGA
+		WireImage LLImage;
+		LLBank & fpgaBank = chans[(fpga == FPGA2) ? 2 : 0].LLBank_;
+		if (chanIQMode[chanct] && fpgaBank.length > 0 && fpgaBank.length < MAX_LL_LENGTH){
+			LLImage.append_write(fpga, FPGA_BANKSEL_LL_CHA | 0, fpgaBank.get_packed_data(0, fpgaBank.length));
+			LLImage.append_write(fpga, FPGA_ADDR_CHA_LL_LENGTH, WordVec(1, fpgaBank.length-1));
+		}
+		add_image(chanHeader.LLImage, chanHeader.LLChunks, LLImage);
+		chanHeader.LLChecksum = LLImage.checksum;
+	}
+	body.resize((body.size() + 7) & ~static_cast<size_t>(7), 0);
+	header.fileSize = sizeof(Header) + body.size();
+	header.headerCRC = crc32(reinterpret_cast<const UCHAR *>(&header), offsetof(Header, headerCRC));
+
+	FILE * outFile = fopen(compiledFile.c_str(), "wb");
+	if (outFile == nullptr){
+		FILE_LOG(logERROR) << "Could not open " << compiledFile << " for writing";
+		return -3;
+	}
+	bool writeOK = (fwrite(&header, sizeof(header), 1, outFile) == 1) &&
+			(body.empty() || fwrite(body.data(), body.size(), 1, outFile) == 1);
+	writeOK &= (fclose(outFile) == 0);
+	if (!writeOK){
+		FILE_LOG(logERROR) << "Failed writing compiled sequence " << compiledFile;
+		return -3;
+	}
+	FILE_LOG(logINFO) << "Wrote compiled sequence of " << header.fileSize << " bytes";
+	return 0;
+}
+
+int APS::load_compiled_sequence(const string & compiledFile){
+	/*
+	 * Load a sequence converted with compile_sequence_file
+	 * The file is memory mapped and the pre-formatted writes go straight to the device
+	 */
+	using namespace CompiledSequence;
+	PerfStats::Timer timer(PERF_LOAD_COMPILED);
+	Trace::Span span("load_compiled_sequence", deviceID_);
+	typedef std::chrono::steady_clock LoadClock;
+	LoadClock::time_point loadStart = LoadClock::now();
+
+	FILE_LOG(logINFO) << "Opening compiled sequence file: " << compiledFile;
+	MappedFile file(compiledFile);
+	const Header * header = validate(file);
+	if (header == nullptr){
+		return -1;
+	}
+	for(int chanct=0; chanct<4; chanct++){
+		if (check_waveform_length(chanct, header->channels[chanct].numSamples) != 0){
+			return -2;
+		}
+	}
 
-		const vector<string> chanStrs = {"chan_1", "chan_2", "chan_3", "chan_4"};
-		//For now assume 4 channel data
-		//Reset the channel data
+	clear_channel_data();
+	for(int chanct=0; chanct<4; chanct++){
+		const ChannelHeader & chanHeader = header->channels[chanct];
+		Channel & chan = channels_[chanct];
+		FPGASELECT fpga = dac2fpga(chanct);
+
+		//Host copy of the channel data
+		const short * samples = section_data<short>(file, chanHeader.samples);
+		chan.set_waveform(vector<short>(samples, samples + chanHeader.numSamples));
+		if (chanHeader.flags & HAS_LL){
+			chan.LLBank_.IQMode = (chanHeader.flags & IQ_MODE);
+			chan.LLBank_.init_precomputed(chanHeader.LLLength, section_data<USHORT>(file, chanHeader.LLArrays),
+					section_data<USHORT>(file, chanHeader.LLPacked), section_data<uint64_t>(file, chanHeader.miniLLs), chanHeader.numMiniLLs);
+		}
+
+		//The waveform image assumes unit scale and no offset
+		if (chanHeader.wfImage.size > 0){
+			if (chan.get_scale() == 1 && chan.get_offset() == 0){
+				std::lock_guard<std::recursive_mutex> lock(*mymutex_);
+				FPGA::write_image(handle_, section_data<UCHAR>(file, chanHeader.wfImage), section_data<uint64_t>(file, chanHeader.wfChunks),
+						section_length<uint64_t>(chanHeader.wfChunks));
+				checksums_[fpga].address += chanHeader.wfChecksum.address;
+				checksums_[fpga].data += chanHeader.wfChecksum.data;
+			}
+			else{
+				write_waveform(chanct, chan.prep_waveform());
+			}
+		}
+	}
+
+	if (check_LL_streamable(channels_) != 0){
 		clear_channel_data();
-		//TODO: check the channelDataFor attribute
+		return -2;
+	}
+
+	//In double buffered mode the streaming thread always writes the LL
+	if (!doubleBuffered_){
 		for(int chanct=0; chanct<4; chanct++){
-			//Load the waveform library first
-			string chanStr = chanStrs[chanct];
-			vector<short> tmpVec = h5array2vector<short>(&H5SeqFile, chanStr + "/waveformLib", H5::PredType::NATIVE_INT16);
-			set_waveform(chanct, tmpVec);
-
-			//Check if there is the linklist data and if it is IQ mode style
-			H5::Group chanGroup = H5SeqFile.openGroup(chanStr);
-			USHORT isLinkListData, isIQMode;
-			isLinkListData = h5element2element<USHORT>("isLinkListData", &chanGroup, H5::PredType::NATIVE_UINT16);
-			isIQMode = h5element2element<USHORT>("isIQMode", &chanGroup, H5::PredType::NATIVE_UINT16);
-			chanGroup.close();
-
-			//Load the linklist data
-			if (isLinkListData){
-				if (isIQMode){
-					channels_[chanct].LLBank_.IQMode = true;
-					channels_[chanct].LLBank_.read_state_from_hdf5(H5SeqFile, chanStrs[chanct]+"/linkListData");
-					//If the length is less than can fit on the chip then write it to the device
-					if (channels_[chanct].LLBank_.length < MAX_LL_LENGTH){
-						write_LL_data_IQ(dac2fpga(chanct), 0, 0, channels_[chanct].LLBank_.length, true );
-					}
+			const ChannelHeader & chanHeader = header->channels[chanct];
+			if (chanHeader.LLImage.size > 0){
+				FPGASELECT fpga = dac2fpga(chanct);
+				std::lock_guard<std::recursive_mutex> lock(*mymutex_);
+				FPGA::write_image(handle_, section_data<UCHAR>(file, chanHeader.LLImage), section_data<uint64_t>(file, chanHeader.LLChunks),
+						section_length<uint64_t>(chanHeader.LLChunks));
+				checksums_[fpga].address += chanHeader.LLChecksum.address;
+				checksums_[fpga].data += chanHeader.LLChecksum.data;
+			}
+		}
+	}
+	set_miniLL_repeat(header->miniLLRepeat);
+
+	FILE_LOG(logINFO) << "Loaded compiled sequence " << compiledFile << " (" << file.size << " bytes) in "
+			<< 1e3*std::chrono::duration<double>(LoadClock::now() - loadStart).count() << " ms";
+	return 0;
+}
 
+int APS::set_double_buffered(const bool & enable){
+	/*
+	 * Double buffered mode splits the waveform memory in two halves so the next sequence can be staged
+	 * with stage_sequence_file while the current one plays. The LL is always streamed in this mode so that
+	 * switch_sequence can swap the LL over at a miniLL boundary.
+	 */
+	if (myBankBouncerThread_.isRunning()){
+		FILE_LOG(logERROR) << "Cannot change double buffered mode while running";
+		return -1;
+	}
+	if (enable){
+		for (const auto & chan : channels_){
+			if (chan.waveform_.size() > static_cast<size_t>(MAX_WF_LENGTH/2)){
+				FILE_LOG(logERROR) << "Waveform on channel " << chan.number << " does not fit in half the waveform memory";
+				return -2;
+			}
+		}
+	}
+	else{
+		//Point the LLs back at the bottom of memory first; a disk backed LL can't be moved so leave everything as it was
+		if (activeWFOffset_ != 0){
+			for (int chanct = 0; chanct < 4; chanct++){
+				if (channels_[chanct].LLBank_.length > 0 && channels_[chanct].LLBank_.rebase_addresses(-(MAX_WF_LENGTH/2/WF_MODULUS)) != 0){
+					FILE_LOG(logERROR) << "Could not move the LL on channel " << chanct << " back to the bottom of waveform memory";
+					for (int undoct = 0; undoct < chanct; undoct++){
+						if (channels_[undoct].LLBank_.length > 0){
+							channels_[undoct].LLBank_.rebase_addresses(MAX_WF_LENGTH/2/WF_MODULUS);
+						}
+					}
+					return -3;
 				}
-				else{
-					channels_[chanct].LLBank_.read_state_from_hdf5(H5SeqFile, chanStrs[chanct]+"/linkListData");
+			}
+		}
+		for (auto & chan : stagedChannels_){
+			chan.clear_data();
+		}
+		sequenceStaged_ = false;
+		//Put the waveforms back at the bottom of memory
+		if (activeWFOffset_ != 0){
+			activeWFOffset_ = 0;
+			for (int chanct = 0; chanct < 4; chanct++){
+				if (!channels_[chanct].waveform_.empty()){
+					write_waveform(chanct, channels_[chanct].prep_waveform());
 				}
 			}
 		}
-		//Set the mini LL count
-		H5::Group rootGroup = H5SeqFile.openGroup("/");
+		//Short LLs are no longer streamed so put them on the device now
+		for (int chanct = 0; chanct < 4; chanct++){
+			const LLBank & bank = channels_[chanct].LLBank_;
+			if (bank.IQMode && bank.length > 0 && bank.length < MAX_LL_LENGTH){
+				write_LL_data_IQ(dac2fpga(chanct), 0, 0, bank.length, true);
+			}
+		}
+	}
+	doubleBuffered_ = enable;
+	return 0;
+}
+
+int APS::stage_sequence_file(const string & seqFile){
+	/*
+	 * Load the next sequence from an H5 file into the inactive half of waveform memory while the current one plays
+	 * The LL addresses are shifted to point at the inactive half and the LL is held on the host until switch_sequence
+	 */
+	if (!doubleBuffered_){
+		FILE_LOG(logERROR) << "Staging a sequence needs double buffered mode";
+		return -2;
+	}
+	if (myBankBouncerThread_.switchRequested){
+		FILE_LOG(logERROR) << "Previous sequence switch is still in progress";
+		return -3;
+	}
+	size_t stageOffset = (activeWFOffset_ == 0) ? MAX_WF_LENGTH/2 : 0;
+	try {
+		FILE_LOG(logINFO) << "Staging sequence file: " << seqFile << " at waveform address " << stageOffset;
+
+		//Reading the file can take a while so only grab the device once there is something to write
+		vector<Channel> stagedChannels;
+		vector<bool> chanIQMode(4, false);
 		USHORT miniLLRepeat;
-		miniLLRepeat = h5element2element<USHORT>("miniLLRepeat", &rootGroup, H5::PredType::NATIVE_UINT16);
-		rootGroup.close();
-		set_miniLL_repeat(miniLLRepeat);
+		{
+			HDF5Lock h5Lock(hdf5_mutex());
+			H5::H5File H5SeqFile(seqFile, H5F_ACC_RDONLY);
+			for(int chanct=0; chanct<4; chanct++){
+				stagedChannels.push_back(Channel(chanct));
+				stagedChannels[chanct].set_offset(channels_[chanct].get_offset());
+				stagedChannels[chanct].set_scale(channels_[chanct].get_scale());
+				int readStatus = read_sequence_channel(H5SeqFile, chanct, stagedChannels[chanct]);
+				if (readStatus < 0){
+					return -1;
+				}
+				chanIQMode[chanct] = (readStatus > 0);
+			}
+			if (read_sequence_repeat(H5SeqFile, miniLLRepeat) != 0){
+				return -1;
+			}
+			H5SeqFile.close();
+		}
 
-		//Close the file
-		H5SeqFile.close();
+		for(int chanct=0; chanct<4; chanct++){
+			Channel & chan = stagedChannels[chanct];
+			if (chan.waveform_.size() > static_cast<size_t>(MAX_WF_LENGTH/2)){
+				FILE_LOG(logERROR) << "Staged waveform on channel " << chanct << " does not fit in half the waveform memory";
+				return -4;
+			}
+			//Any LL has to be IQ mode streamable to be switched to
+			if (chan.LLBank_.length > 0 && !chanIQMode[chanct]){
+				FILE_LOG(logERROR) << "Staged LL on channel " << chanct << " is not an IQ mode LL";
+				return -5;
+			}
+			//A streaming FPGA can't be left without a LL to play
+			if (channels_[chanct].LLBank_.length > 0 && chan.LLBank_.length == 0){
+				FILE_LOG(logERROR) << "Staged sequence has no LL for channel " << chanct;
+				return -5;
+			}
+		}
+
+		miniLLRepeat = fold_sequence_repeats(stagedChannels, miniLLRepeat);
+		if (check_LL_streamable(stagedChannels) != 0){
+			return -5;
+		}
+		for (auto & chan : stagedChannels){
+			if (chan.LLBank_.length > 0 && chan.LLBank_.rebase_addresses(stageOffset/WF_MODULUS) != 0){
+				FILE_LOG(logERROR) << "Could not move the staged LL to the inactive waveform memory";
+				return -6;
+			}
+		}
+
+		//Now write the waveforms into the inactive half
+		//The length registers belong to the playing sequence so they are only updated by the switch
+		mymutex_->lock();
+		if (miniLLRepeat != miniLLRepeat_){
+			FILE_LOG(logWARNING) << "Staged sequence has miniLL repeat " << miniLLRepeat << " instead of " << miniLLRepeat_
+					<< "; while streaming the new count only takes effect once the switched sequence is playing";
+		}
+		for(int chanct=0; chanct<4; chanct++){
+			if (!stagedChannels[chanct].waveform_.empty()){
+				write_waveform(chanct, stagedChannels[chanct].prep_waveform(), stageOffset, false, false);
+			}
+		}
+		stagedChannels_ = std::move(stagedChannels);
+		stagedMiniLLRepeat_ = miniLLRepeat;
+		sequenceStaged_ = true;
+		mymutex_->unlock();
 		return 0;
 	}
 	catch (H5::FileIException & e) {
@@ -308,6 +879,62 @@ int APS::load_sequence_file(const string & seqFile){
 	return 0;
 }
 
+int APS::switch_sequence(){
+	/*
+	 * Switch playback over to the staged sequence
+	 * While streaming the switch happens at a miniLL boundary and this waits until the new sequence is playing
+	 * Returns 0 once switched, 1 if the switch is still pending after SWITCH_TIMEOUT_MS
+	 */
+	if (!sequenceStaged_){
+		FILE_LOG(logERROR) << "No sequence staged to switch to";
+		return -1;
+	}
+	if (!myBankBouncerThread_.isRunning()){
+		//Nothing is playing so just make the staged sequence current; run() will stream the LL
+		mymutex_->lock();
+		commit_staged_sequence(false);
+		mymutex_->unlock();
+		return 0;
+	}
+	myBankBouncerThread_.switchRequested = true;
+	auto start = std::chrono::steady_clock::now();
+	while (myBankBouncerThread_.switchRequested){
+		if (std::chrono::steady_clock::now() - start > std::chrono::milliseconds(SWITCH_TIMEOUT_MS)){
+			FILE_LOG(logWARNING) << "Sequence switch still pending after " << SWITCH_TIMEOUT_MS << " ms";
+			return 1;
+		}
+		usleep(1000);
+	}
+	return 0;
+}
+
+int APS::commit_staged_sequence(const bool & queue){
+	/*
+	 * Make the staged sequence the current one; the device mutex must be held
+	 * queue = true - called by the streaming thread: only add the register writes to the output queue and leave
+	 * the LL repeat register for the thread to write once the device has played out the old sequence
+	 */
+	for (int chanct = 0; chanct < 4; chanct++){
+		std::swap(channels_[chanct].waveform_, stagedChannels_[chanct].waveform_);
+		std::swap(channels_[chanct].LLBank_, stagedChannels_[chanct].LLBank_);
+		stagedChannels_[chanct].clear_data();
+		//Staging only wrote the waveform data so the lengths go now
+		USHORT wfLength = channels_[chanct].waveform_.empty() ? 0 : channels_[chanct].waveform_.size()/WF_MODULUS - 1;
+		write(dac2fpga(chanct), (chanct % 2 == 0) ? FPGA_ADDR_CHA_WF_LENGTH : FPGA_ADDR_CHB_WF_LENGTH, wfLength, queue);
+	}
+	activeWFOffset_ = (activeWFOffset_ == 0) ? MAX_WF_LENGTH/2 : 0;
+	if (queue){
+		miniLLRepeatPending_ = (stagedMiniLLRepeat_ != miniLLRepeat_);
+	}
+	else{
+		miniLLRepeat_ = stagedMiniLLRepeat_;
+		write(ALL_FPGAS, FPGA_ADDR_LL_REPEAT, miniLLRepeat_, false);
+	}
+	sequenceStaged_ = false;
+	FILE_LOG(logINFO) << "Device ID: " << deviceID_ << " switched to staged sequence";
+	return 0;
+}
+
 int APS::set_channel_enabled(const int & dac, const bool & enable){
 	return channels_[dac].set_enabled(enable);
 }
@@ -342,6 +969,57 @@ int APS::set_channel_scale(const int & dac, const float & scale){
 	return 0;
 }
 
+int APS::set_channel_params(const vector<int> & dacs, const vector<float> & offsets, const vector<float> & scales, const vector<bool> & enables){
+	/*
+	 * Batch version of set_channel_offset/scale/enabled
+	 * Empty offsets, scales or enables leave that setting alone; otherwise they match dacs element for element
+	 * Each touched waveform is rewritten once and everything goes out in a single flush
+	 */
+	for (auto vecSize : {offsets.size(), scales.size(), enables.size()}){
+		if (vecSize != 0 && vecSize != dacs.size()){
+			FILE_LOG(logERROR) << "Channel parameter arrays must be empty or match the number of channels";
+			return -1;
+		}
+	}
+	for (const int & dac : dacs){
+		if (dac < 0 || dac > 3){
+			FILE_LOG(logERROR) << "Invalid channel " << dac << " in set_channel_params";
+			return -2;
+		}
+	}
+
+	std::lock_guard<std::recursive_mutex> lock(*mymutex_);
+	vector<bool> rewriteWF(4, false), rewriteOffset(4, false);
+	for (size_t ct = 0; ct < dacs.size(); ct++){
+		Channel & chan = channels_[dacs[ct]];
+		if (!offsets.empty()){
+			chan.set_offset(offsets[ct]);
+			rewriteWF[dacs[ct]] = true;
+			rewriteOffset[dacs[ct]] = true;
+		}
+		if (!scales.empty()){
+			chan.set_scale(scales[ct]);
+			rewriteWF[dacs[ct]] = true;
+		}
+		if (!enables.empty()){
+			chan.set_enabled(enables[ct]);
+		}
+	}
+
+	for (int dac = 0; dac < 4; dac++){
+		if (rewriteWF[dac] && !channels_[dac].waveform_.empty()){
+			write_waveform(dac, channels_[dac].prep_waveform(), activeWFOffset_, true);
+		}
+		if (rewriteOffset[dac]){
+			set_offset_register(dac, channels_[dac].get_offset(), true);
+		}
+	}
+	if (!writeQueue_.empty()){
+		flush();
+	}
+	return 0;
+}
+
 float APS::get_channel_scale(const int & dac) const{
 	return channels_[dac].get_scale();
 }
@@ -394,6 +1072,8 @@ double APS::get_trigger_interval() const{
 }
 
 int APS::set_miniLL_repeat(const USHORT & miniLLRepeat){
+	miniLLRepeat_ = miniLLRepeat;
+	miniLLRepeatPending_ = false;
 	return FPGA::write_FPGA(handle_, FPGA_ADDR_LL_REPEAT, miniLLRepeat, ALL_FPGAS);
 }
 
@@ -407,15 +1087,25 @@ int APS::run() {
 		allChannels &= tmpChannel.enabled_;
 	}
 
-	//If we have more LL entries than we can handle then we need to stream
-	for (int chanct = 0; chanct < 4; ++chanct) {
-		if (channelsEnabled[chanct]){
-			if (channels_[chanct].LLBank_.length > MAX_LL_LENGTH && !myBankBouncerThreads_[chanct].isRunning()){
-				streaming_ = false;
-				myBankBouncerThreads_[chanct].start();
-				while(!streaming_){
-					usleep(10000);
-				}
+	//If we have more LL entries than we can handle, or we might switch sequences on the fly, then we need to stream
+	//One scheduler thread handles all the FPGAs that need it
+	if (!myBankBouncerThread_.isRunning()){
+		myBankBouncerThread_.fpgas.clear();
+		for (int chanct = 0; chanct < 4; ++chanct) {
+			FPGASELECT fpga = dac2fpga(chanct);
+			if (channelsEnabled[chanct] && (channels_[chanct].LLBank_.length > MAX_LL_LENGTH || (doubleBuffered_ && channels_[chanct].LLBank_.length > 0)) &&
+					std::find(myBankBouncerThread_.fpgas.begin(), myBankBouncerThread_.fpgas.end(), fpga) == myBankBouncerThread_.fpgas.end()){
+				myBankBouncerThread_.fpgas.push_back(fpga);
+			}
+		}
+		if (!myBankBouncerThread_.fpgas.empty()){
+			if (check_LL_streamable(channels_) != 0){
+				return -1;
+			}
+			streaming_ = false;
+			myBankBouncerThread_.start();
+			while(!streaming_){
+				usleep(10000);
 			}
 		}
 	}
@@ -441,11 +1131,13 @@ int APS::run() {
 
 int APS::stop() {
 
-	// stop all channels
-	for (int chanct = 0; chanct < 4; ++chanct) {
-		if (channels_[chanct].LLBank_.length > MAX_LL_LENGTH){
-			myBankBouncerThreads_[chanct].stop();
-		}
+	// stop streaming
+	myBankBouncerThread_.stop();
+	//A switch that never reached a miniLL boundary won't happen now; the sequence stays staged
+	myBankBouncerThread_.switchRequested = false;
+	//One that did is finished off so the next run plays the new sequence with its own repeat count
+	if (miniLLRepeatPending_){
+		set_miniLL_repeat(stagedMiniLLRepeat_);
 	}
 
 	//Try to stop in a wait for trigger state by making the trigger interval long
@@ -468,6 +1160,24 @@ int APS::stop() {
 
 }
 
+int APS::set_waveform_strided(const int & dac, const void * data, const size_t & numPts, const ptrdiff_t & stride, const ELEMENT_TYPE & type){
+	/*
+	 * Like set_waveform but reads straight from the caller's (possibly non-contiguous) array
+	 */
+	if (dac < 0 || dac > 3){
+		return -2;
+	}
+	if (check_waveform_length(dac, numPts) != 0){
+		return -1;
+	}
+	vector<short> prepVec;
+	int status = channels_[dac].set_waveform(data, numPts, stride, type, prepVec);
+	if (status != 0){
+		return status;
+	}
+	return write_waveform(dac, prepVec);
+}
+
 int APS::set_run_mode(const int & dac, const RUN_MODE & mode) {
 /********************************************************************
  * Description : Sets run mode
@@ -548,7 +1258,8 @@ int APS::set_repeat_mode(const int & dac, const bool & mode) {
 	return 0;
 }
 
-int APS::set_LLData_IQ(const FPGASELECT & fpga, const WordVec & addr, const WordVec & count, const WordVec & trigger1, const WordVec & trigger2, const WordVec & repeat){
+int APS::set_LLData_IQ(const FPGASELECT & fpga, WordVec addr, WordVec count, WordVec trigger1, WordVec trigger2, WordVec repeat){
+	//The arrays are taken by value so callers handing over temporaries don't pay for a copy
 
 	//We store the IQ linklist data in channels 1 and 3
 	int dataChan;
@@ -562,11 +1273,16 @@ int APS::set_LLData_IQ(const FPGASELECT & fpga, const WordVec & addr, const Word
 		default:
 			return -1;
 	}
-	channels_[dataChan].LLBank_ = LLBank(addr, count, trigger1, trigger2, repeat);
+	size_t LLLength = addr.size();
+	channels_[dataChan].LLBank_ = LLBank(std::move(addr), std::move(count), std::move(trigger1), std::move(trigger2), std::move(repeat));
+	if (check_LL_streamable(channels_[dataChan].LLBank_) != 0){
+		channels_[dataChan].LLBank_.clear();
+		return -2;
+	}
 
 	//If we can fit it on then do so
-	if (addr.size() < MAX_LL_LENGTH){
-		write_LL_data_IQ(fpga, 0, 0, addr.size(), true );
+	if (LLLength < MAX_LL_LENGTH){
+		write_LL_data_IQ(fpga, 0, 0, LLLength, true );
 	}
 
 	return 0;
@@ -595,6 +1311,7 @@ int APS::write(const FPGASELECT & fpga, const unsigned int & addr, const vector<
 	//Pack the data
 	vector<UCHAR> dataPacket = FPGA::format(fpga, addr, data);
 
+	std::lock_guard<std::recursive_mutex> lock(*mymutex_);
 	//Update the software checksums
 	//Address checksum is defined as lower word of address
 	checksums_[fpga].address += addr & 0xFFFF;
@@ -623,7 +1340,11 @@ int APS::write(const FPGASELECT & fpga, const unsigned int & addr, const vector<
 
 int APS::flush() {
 	// flush write queue to USB interface
+	std::lock_guard<std::recursive_mutex> lock(*mymutex_);
+	PerfStats::Timer timer(PERF_FLUSH);
+	Trace::Span span("transfer", deviceID_, "bytes", writeQueue_.size());
 	int bytesWritten = FPGA::write_block(handle_, writeQueue_, offsetQueue_);
+	timer.add_bytes(bytesWritten);
 	FILE_LOG(logDEBUG1) << "Flushed " << bytesWritten << " bytes to device";
 	writeQueue_.clear();
 	offsetQueue_.clear();
@@ -652,6 +1373,7 @@ UCHAR APS::read_status_ctrl() const {
 
 int APS::setup_PLL() {
 	// set the on-board PLL to its default state (two 1.2 GHz outputs, and one 300 MHz output)
+	Trace::Span span("setup_PLL", deviceID_);
 	FILE_LOG(logINFO) << "Setting up PLL";
 
 	// Disable DDRs
@@ -812,6 +1534,8 @@ int APS::test_PLL_sync(const FPGASELECT & fpga, const int & numRetries /* see he
 	 *         fpga (1 or 2)
 	 *         numRetries - number of times to restart the test if the global sync test fails (step 5)
 	 */
+	PerfStats::Timer timer(PERF_TEST_PLL_SYNC);
+	Trace::Span span("test_PLL_sync", deviceID_, "fpga", fpga);
 
 	// Test for DAC clock phase match
 	bool inSync, globalSync;
@@ -1119,6 +1843,7 @@ int APS::get_PLL_freq(const FPGASELECT & fpga) const {
 
 int APS::setup_VCXO() {
 	// Write the standard VCXO setup
+	Trace::Span span("setup_VCXO", deviceID_);
 
 	FILE_LOG(logINFO) << "Setting up VCX0";
 
@@ -1144,6 +1869,8 @@ int APS::setup_DAC(const int & dac) const
  * inputs: dac = 0, 1, 2, or 3
  */
 {
+	PerfStats::Timer timer(PERF_SETUP_DAC);
+	Trace::Span span("setup_DAC", deviceID_, "dac", dac);
 	BYTE data;
 	BYTE SD, MSD, MHD;
 	BYTE edgeMSD, edgeMHD;
@@ -1300,10 +2027,11 @@ bool APS::verify_checksums(const FPGASELECT & fpga){
 	return true;
 }
 
-int APS::set_offset_register(const int & dac, const float & offset) {
+int APS::set_offset_register(const int & dac, const float & offset, const bool & queue /* see header for default */) {
 	/* APS::set_offset_register
 	 * Write the zero register for the associated channel
 	 * offset - offset in normalized full range (-1, 1)
+	 * queue = true - only add the write to the output queue
 	 */
 
 	ULONG zeroRegisterAddr;
@@ -1331,16 +2059,39 @@ int APS::set_offset_register(const int & dac, const float & offset) {
 	scaledOffset = WORD(offset * MAX_WF_AMP);
 	FILE_LOG(logINFO) << "Setting DAC " << dac << "  zero register to " << scaledOffset;
 
-	FPGA::write_FPGA(handle_, zeroRegisterAddr, scaledOffset, fpga);
+	write(fpga, zeroRegisterAddr, scaledOffset, queue);
 
 	return 0;
 }
 
+int APS::check_waveform_length(const int & dac, const size_t & numPts) const{
+	//In double buffered mode a channel only has the half of waveform memory it is playing from
+	size_t maxLength = doubleBuffered_ ? MAX_WF_LENGTH/2 : MAX_WF_LENGTH;
+	if (numPts > maxLength){
+		FILE_LOG(logERROR) << "Waveform of " << numPts << " points on channel " << dac << " is longer than the " << maxLength
+				<< (doubleBuffered_ ? " points in half the waveform memory" : " points of waveform memory");
+		return -1;
+	}
+	return 0;
+}
+
 int APS::write_waveform(const int & dac, const vector<short> & wfData) {
+	//Waveforms go to whichever half of memory is playing in double buffered mode
+	return write_waveform(dac, wfData, activeWFOffset_);
+}
+
+int APS::write_waveform(const int & dac, const vector<short> & wfData, const size_t & wfOffset, const bool & queue /* see header for default */,
+		const bool & writeLengthFlag /* see header for default */) {
 	/*Write waveform data to FPGA memory
 	 * dac = channel (0-3)
 	 * wfData = signed short waveform data
+	 * wfOffset = sample address in waveform memory to start writing at
+	 * queue = true - only add the writes to the output queue; the checksums are not verified
+	 * writeLengthFlag = false - leave the waveform length register alone, e.g. when staging into the inactive half
 	 */
+	PerfStats::Timer timer(PERF_WRITE_WAVEFORM);
+	timer.add_bytes(2*wfData.size());
+	Trace::Span span("write_waveform", deviceID_, "dac", dac);
 
 	ULONG tmpData, wfLength;
 	int sizeReg, startAddr;
@@ -1365,15 +2116,28 @@ int APS::write_waveform(const int & dac, const vector<short> & wfData) {
 	if (fpga == INVALID_FPGA) {
 		return -1;
 	}
+	if (wfOffset + wfData.size() > static_cast<size_t>(MAX_WF_LENGTH)) {
+		FILE_LOG(logERROR) << "Waveform of " << wfData.size() << " points at " << wfOffset << " runs past the end of waveform memory";
+		return -3;
+	}
 
 	//Waveform length used by FPGA must be an integer multiple of WF_MODULUS and is 0 counted
 	wfLength = wfData.size() / WF_MODULUS - 1;
 	FILE_LOG(logINFO) << "Loading Waveform length " << wfData.size() << " (FPGA count = " << wfLength << " ) into FPGA  " << fpga << " DAC " << dac;
 
 	//Write the waveform parameters
-	FPGA::write_FPGA(handle_, sizeReg, wfLength, fpga);
+	if (queue){
+		if (writeLengthFlag){
+			write(fpga, sizeReg, wfLength, true);
+		}
+		write(fpga, startAddr | wfOffset, vector<USHORT>(wfData.begin(), wfData.end()), true);
+		return 0;
+	}
+	if (writeLengthFlag){
+		FPGA::write_FPGA(handle_, sizeReg, wfLength, fpga);
+	}
 
-	if (FILELog::ReportingLevel() >= logDEBUG2) {
+	if (writeLengthFlag && FILE_LOG_ENABLED(logDEBUG2)) {
 		//Double check it took
 		tmpData = FPGA::read_FPGA(handle_, sizeReg, fpga);
 		FILE_LOG(logDEBUG2) << "Size set to: " << tmpData;
@@ -1381,16 +2145,18 @@ int APS::write_waveform(const int & dac, const vector<short> & wfData) {
 	}
 
 	//Reset the checksums
-	if (FILELog::ReportingLevel() >= logDEBUG) {
+	if (FILE_LOG_ENABLED(logDEBUG)) {
 		reset_checksums(fpga);
 	}
 
 	//Format the data and add to write queue
-	write(fpga, startAddr, vector<USHORT>(wfData.begin(), wfData.end()), true);
+	Trace::Span encodeSpan("encode", deviceID_);
+	write(fpga, startAddr | wfOffset, vector<USHORT>(wfData.begin(), wfData.end()), true);
+	encodeSpan.finish();
 	flush();
 
 	//Verify the checksums
-	if (FILELog::ReportingLevel() >= logDEBUG) {
+	if (FILE_LOG_ENABLED(logDEBUG)) {
 		if (!verify_checksums(fpga)){
 			FILE_LOG(logERROR) << "Checksums didn't match after writing waveform data";
 			return -2;
@@ -1400,12 +2166,19 @@ int APS::write_waveform(const int & dac, const vector<short> & wfData) {
 }
 
 
-int APS::write_LL_data_IQ(const FPGASELECT & fpga, const ULONG & startAddr, const size_t & startIdx, const size_t & stopIdx, const bool & writeLengthFlag ){
+int APS::write_LL_data_IQ(const FPGASELECT & fpga, const ULONG & startAddr, const size_t & startIdx, const size_t & stopIdx, const bool & writeLengthFlag, const bool & queue /* see header for default */){
+	/* APS::write_LL_data_IQ
+	 * fpga = FPGA1, FPGA2 or ALL_FPGAS (when both FPGAs hold identical LL data)
+	 * queue = false - flush to device immediately, true - only add the writes to the output queue
+	 */
+	PerfStats::Timer timer(PERF_WRITE_LL_DATA);
+	Trace::Span span("write_LL_data_IQ", deviceID_, "fpga", fpga);
 
 	//We store the IQ linklist data in channels 1 and 3
 	int dataChan;
 	switch(fpga){
 		case FPGA1:
+		case ALL_FPGAS:
 			dataChan = 0;
 			break;
 		case FPGA2:
@@ -1421,7 +2194,7 @@ int APS::write_LL_data_IQ(const FPGASELECT & fpga, const ULONG & startAddr, cons
 	}
 	else{
 		// must be wrapping around the end, compute the modular distance
-		entriesToWrite = mymod(static_cast<int>(stopIdx)-static_cast<int>(startIdx), static_cast<int>(channels_[dataChan].LLBank_.length));
+		entriesToWrite = moddiff(stopIdx, startIdx, channels_[dataChan].LLBank_.length);
 	}
 
 	FILE_LOG(logDEBUG1) << "Writing LL Data for Channel: " << dataChan << "; Length: " << entriesToWrite;
@@ -1435,13 +2208,16 @@ int APS::write_LL_data_IQ(const FPGASELECT & fpga, const ULONG & startAddr, cons
 		writeData = channels_[dataChan].LLBank_.get_packed_data(startIdx, tmpStopIdx);
 		//queue it
 		write(fpga, FPGA_BANKSEL_LL_CHA | startAddr, writeData, true);
+		timer.add_bytes(2*writeData.size());
 		//the second segment is written to the top of the memory (startAddr = 0)
 		writeData = channels_[dataChan].LLBank_.get_packed_data(tmpStopIdx, stopIdx);
 		write(fpga, FPGA_BANKSEL_LL_CHA | 0, writeData, true);
+		timer.add_bytes(2*writeData.size());
 	}
 	else{
 		writeData = channels_[dataChan].LLBank_.get_packed_data(startIdx, stopIdx);
 		write(fpga, FPGA_BANKSEL_LL_CHA | startAddr, writeData, true);
+		timer.add_bytes(2*writeData.size());
 	}
 
 	//If necessary write the LL length register
@@ -1451,89 +2227,11 @@ int APS::write_LL_data_IQ(const FPGASELECT & fpga, const ULONG & startAddr, cons
 	}
 
 	//Flush the queue to the device
-	flush();
-	return 0;
-}
-
-//int APS::write_LL_data(const int & dac, const int & bankNum, const int & targetBank) {
-	/*
-	 * write_LL_data
-	 * dac = channel (0-3)
-	 * bankNum = LL bank number to load (having previously been stored in the driver with add_LL_bank()
-	 * targetBank = where to load the bank (0 = bank A, 1 = bank B)
-	 */
-	//TODO: make work
-	/*
-
-	int startAddr;
-	int sizeReg;
-
-	FPGASELECT fpga = dac2fpga(dac);
-	if (fpga == INVALID_FPGA) {
-		return -1;
-	}
-
-	// setup register addressing based on DAC
-	switch(dac) {
-		case 0:
-		case 2:
-			if (targetBank == 0) {
-				startAddr = FPGA_ADDR_CHA_LL_A_WRITE;
-				sizeReg = FPGA_OFF_CHA_LL_A_CTRL;
-			} else {
-				startAddr = FPGA_ADDR_CHA_LL_B_WRITE;
-				sizeReg = FPGA_OFF_CHA_LL_B_CTRL;
-			}
-			break;
-		case 1:
-		case 3:
-			if (targetBank == 0) {
-				startAddr    = FPGA_ADDR_CHB_LL_A_WRITE;
-				sizeReg = FPGA_OFF_CHB_LL_A_CTRL;
-			} else {
-				startAddr = FPGA_ADDR_CHB_LL_B_WRITE;
-				sizeReg = FPGA_OFF_CHB_LL_B_CTRL;
-			}
-			break;
-		default:
-			return -2;
-	}
-
-	size_t bankLength = channels_[dac].banks_[bankNum].length;
-
-	if ( int(bankLength) > MAX_LL_LENGTH)  {
-		return -3;
-	}
-	FILE_LOG(logINFO) << "Loading LinkList length " << bankLength << " into DAC " << dac << " bank " << bankNum << " targetBank " << targetBank;
-
-	//Set the link list size
-	int lastElementOffset = (targetBank==0) ? (bankLength-1) : (bankLength-1) + MAX_LL_LENGTH ;
-
-	FILE_LOG(logDEBUG2) << "Writing Link List Control Reg: " << myhex << sizeReg << " = " << lastElementOffset;
-
-	// clear checksums
-	if (FILELog::ReportingLevel() >= logDEBUG) {
-		reset_checksums(fpga);
-	}
-
-	// write control reg
-	write(fpga, sizeReg, lastElementOffset, true);
-
-	//Write the LL data and flush to device
-	write(fpga, startAddr, channels_[dac].banks_[bankNum].get_packed_data(), true);
-	flush();
-
-	// verify the checksum if we are in sufficient debug mode
-	if (FILELog::ReportingLevel() >= logDEBUG) {
-		if (!verify_checksums(fpga)){
-			FILE_LOG(logERROR) << "Checksums didn't match after writing LL data";
-			return -2;
-		}
+	if (!queue){
+		flush();
 	}
 	return 0;
-
 }
-	*/
 
 int APS::read_LL_addr(const FPGASELECT & fpga){
 	/*
@@ -1570,6 +2268,14 @@ int APS::read_miniLL_startAddr(const FPGASELECT & fpga){
 	return FPGA::read_FPGA(handle_, FPGA_ADDR_CHA_MINILLSTART, fpga);
 }
 
+vector<int> APS::read_miniLL_startAddr(const vector<FPGASELECT> & fpgas){
+	/*
+	 * Read the start of the currently playing miniLL on several FPGAs in one USB round trip
+	 */
+	WordVec regVals = FPGA::read_FPGA(handle_, FPGA_ADDR_CHA_MINILLSTART, fpgas);
+	return vector<int>(regVals.begin(), regVals.end());
+}
+
 int APS::save_state_file(string & stateFile){
 
 	if (stateFile.length() == 0) {
@@ -1577,12 +2283,13 @@ int APS::save_state_file(string & stateFile){
 	}
 
 	FILE_LOG(logDEBUG) << "Writing State For Device: " << deviceSerial_ << " to hdf5 file: " << stateFile;
+	HDF5Lock h5Lock(hdf5_mutex());
 	H5::H5File H5StateFile(stateFile, H5F_ACC_TRUNC);
 	string rootStr = "";
-	write_state_to_hdf5(H5StateFile, rootStr);
+	int status = write_state_to_hdf5(H5StateFile, rootStr);
 	//Close the file
 	H5StateFile.close();
-	return 0;
+	return status;
 }
 
 int APS::read_state_file(string & stateFile){
@@ -1592,12 +2299,13 @@ int APS::read_state_file(string & stateFile){
 	}
 
 	FILE_LOG(logDEBUG) << "Reading State For Device: " << deviceSerial_ << " from hdf5 file: " << stateFile;
+	HDF5Lock h5Lock(hdf5_mutex());
 	H5::H5File H5StateFile(stateFile, H5F_ACC_RDONLY);
 	string rootStr = "";
-	read_state_from_hdf5(H5StateFile, rootStr);
+	int status = read_state_from_hdf5(H5StateFile, rootStr);
 	//Close the file
 	H5StateFile.close();
-	return 0;
+	return status;
 }
 
 int APS::write_state_to_hdf5(H5::H5File & H5StateFile, const string & rootStr){
@@ -1610,8 +2318,34 @@ int APS::write_state_to_hdf5(H5::H5File & H5StateFile, const string & rootStr){
 		FILE_LOG(logDEBUG) << "Creating Group: " << tmpStream.str();
 		H5::Group tmpGroup = H5StateFile.createGroup(tmpStream.str());
 		tmpGroup.close();
-		channels_[chanct].write_state_to_hdf5(H5StateFile,tmpStream.str());
+		if (channels_[chanct].write_state_to_hdf5(H5StateFile,tmpStream.str()) != 0){
+			return -1;
+		}
 	}
+
+	//Device wide settings
+	FILE_LOG(logDEBUG) << "Creating Group: " << rootStr + "/device";
+	H5::Group tmpGroup = H5StateFile.createGroup(rootStr + "/device");
+	int samplingRate = (samplingRate_ > 0 || !isOpen) ? samplingRate_ : get_sampleRate();
+	element2h5attribute<int>("samplingRate", samplingRate, &tmpGroup, H5::PredType::NATIVE_INT);
+	element2h5attribute<USHORT>("miniLLRepeat", miniLLRepeat_, &tmpGroup, H5::PredType::NATIVE_UINT16);
+	unsigned int doubleBuffered = doubleBuffered_;
+	element2h5attribute<unsigned int>("doubleBuffered", doubleBuffered, &tmpGroup, H5::PredType::NATIVE_UINT);
+	uint64_t activeWFOffset = activeWFOffset_;
+	element2h5attribute<uint64_t>("activeWFOffset", activeWFOffset, &tmpGroup, H5::PredType::NATIVE_UINT64);
+
+	//The CSRs and trigger interval only live on the device
+	if (isOpen){
+		USHORT CSR1 = FPGA::read_FPGA(handle_, FPGA_ADDR_CSR, FPGA1);
+		USHORT CSR2 = FPGA::read_FPGA(handle_, FPGA_ADDR_CSR, FPGA2);
+		USHORT trigIntervalUpper = FPGA::read_FPGA(handle_, FPGA_ADDR_TRIG_INTERVAL, FPGA1);
+		USHORT trigIntervalLower = FPGA::read_FPGA(handle_, FPGA_ADDR_TRIG_INTERVAL+1, FPGA1);
+		element2h5attribute<USHORT>("CSR1", CSR1, &tmpGroup, H5::PredType::NATIVE_UINT16);
+		element2h5attribute<USHORT>("CSR2", CSR2, &tmpGroup, H5::PredType::NATIVE_UINT16);
+		element2h5attribute<USHORT>("trigIntervalUpper", trigIntervalUpper, &tmpGroup, H5::PredType::NATIVE_UINT16);
+		element2h5attribute<USHORT>("trigIntervalLower", trigIntervalLower, &tmpGroup, H5::PredType::NATIVE_UINT16);
+	}
+	tmpGroup.close();
 	return 0;
 }
 
@@ -1622,7 +2356,110 @@ int APS::read_state_from_hdf5(H5::H5File & H5StateFile, const string & rootStr){
 		tmpStream.str("");
 		tmpStream << rootStr << "/chan_" << chanct+1;
 		FILE_LOG(logDEBUG) << "Reading State For Channel " << chanct + 1<< " from hdf5 file";
-		channels_[chanct].read_state_from_hdf5(H5StateFile,tmpStream.str());
+		if (channels_[chanct].read_state_from_hdf5(H5StateFile,tmpStream.str()) != 0){
+			return -1;
+		}
+	}
+	return 0;
+}
+
+int APS::restore_to_device(string & stateFile){
+	/*
+	 * Put the device back in the configuration saved with save_state_file
+	 * Memory and register writes go out in a single flush; only the PLL is set up separately
+	 */
+	if (stateFile.length() == 0) {
+		stateFile += "cache_" + deviceSerial_ + ".h5";
+	}
+	if (myBankBouncerThread_.isRunning()){
+		FILE_LOG(logERROR) << "Cannot restore state while streaming; stop the APS first";
+		return -1;
+	}
+
+	FILE_LOG(logINFO) << "Restoring device " << deviceSerial_ << " from state file: " << stateFile;
+	typedef std::chrono::steady_clock LoadClock;
+	LoadClock::time_point restoreStart = LoadClock::now();
+
+	int samplingRate;
+	USHORT CSRs[2] = {0, 0};
+	USHORT trigInterval[2] = {0, 0};
+	bool hasRegisters;
+	try {
+		HDF5Lock h5Lock(hdf5_mutex());
+		H5::H5File H5StateFile(stateFile, H5F_ACC_RDONLY);
+		string rootStr = "";
+		if (read_state_from_hdf5(H5StateFile, rootStr) != 0){
+			FILE_LOG(logERROR) << "State file " << stateFile << " does not hold the full channel state";
+			H5StateFile.close();
+			return -3;
+		}
+
+		H5::Group tmpGroup = H5StateFile.openGroup(rootStr + "/device");
+		samplingRate = h5element2element<int>("samplingRate", &tmpGroup, H5::PredType::NATIVE_INT);
+		miniLLRepeat_ = h5element2element<USHORT>("miniLLRepeat", &tmpGroup, H5::PredType::NATIVE_UINT16);
+		doubleBuffered_ = h5element2element<unsigned int>("doubleBuffered", &tmpGroup, H5::PredType::NATIVE_UINT);
+		activeWFOffset_ = h5element2element<uint64_t>("activeWFOffset", &tmpGroup, H5::PredType::NATIVE_UINT64);
+		hasRegisters = tmpGroup.attrExists("CSR1");
+		if (hasRegisters){
+			CSRs[0] = h5element2element<USHORT>("CSR1", &tmpGroup, H5::PredType::NATIVE_UINT16);
+			CSRs[1] = h5element2element<USHORT>("CSR2", &tmpGroup, H5::PredType::NATIVE_UINT16);
+			trigInterval[0] = h5element2element<USHORT>("trigIntervalUpper", &tmpGroup, H5::PredType::NATIVE_UINT16);
+			trigInterval[1] = h5element2element<USHORT>("trigIntervalLower", &tmpGroup, H5::PredType::NATIVE_UINT16);
+		}
+		tmpGroup.close();
+		H5StateFile.close();
+	}
+	catch (H5::Exception & e) {
+		FILE_LOG(logERROR) << "Could not read device state from " << stateFile;
+		return -2;
+	}
+	for (auto & chan : stagedChannels_){
+		chan.clear_data();
+	}
+	sequenceStaged_ = false;
+
+	if (samplingRate > 0 && set_sampleRate(samplingRate) != 0){
+		FILE_LOG(logERROR) << "PLL did not sync at " << samplingRate << " MHz while restoring state";
+	}
+
+	//Hold the state machines in reset while memory is rewritten
+	const USHORT SMRSTBits = CSRMSK_CHA_SMRSTN | CSRMSK_CHB_SMRST;
+	const FPGASELECT fpgas[2] = {FPGA1, FPGA2};
+	if (hasRegisters){
+		for (int fpgact = 0; fpgact < 2; fpgact++){
+			write(fpgas[fpgact], FPGA_ADDR_CSR, CSRs[fpgact] & ~SMRSTBits, true);
+		}
+		write(ALL_FPGAS, FPGA_ADDR_TRIG_INTERVAL, {trigInterval[0], trigInterval[1]}, true);
+	}
+	for (int chanct = 0; chanct < 4; chanct++){
+		Channel & chan = channels_[chanct];
+		if (!chan.waveform_.empty()){
+			write_waveform(chanct, chan.prep_waveform(), activeWFOffset_, true);
+		}
+		else{
+			write(dac2fpga(chanct), (chanct % 2 == 0) ? FPGA_ADDR_CHA_WF_LENGTH : FPGA_ADDR_CHB_WF_LENGTH, 0, true);
+		}
+		set_offset_register(chanct, chan.get_offset(), true);
+	}
+	//Short IQ LLs go on the device now; anything else is streamed by run()
+	for (int fpgact = 0; fpgact < 2; fpgact++){
+		const LLBank & bank = channels_[2*fpgact].LLBank_;
+		if (!doubleBuffered_ && bank.IQMode && bank.length > 0 && bank.length < MAX_LL_LENGTH){
+			write_LL_data_IQ(fpgas[fpgact], 0, 0, bank.length, true, true);
+		}
+		else{
+			write(fpgas[fpgact], FPGA_ADDR_CHA_LL_LENGTH, 0, true);
+		}
+	}
+	write(ALL_FPGAS, FPGA_ADDR_LL_REPEAT, miniLLRepeat_, true);
+	size_t bytesQueued = writeQueue_.size();
+	flush();
+
+	FILE_LOG(logINFO) << "Restored " << bytesQueued << " bytes of device state in " << 1e3*std::chrono::duration<double>(LoadClock::now() - restoreStart).count() << " ms";
+
+	//Pick up where we left off if the state machines were running
+	if (hasRegisters && ((CSRs[0] | CSRs[1]) & SMRSTBits)){
+		return run();
 	}
 	return 0;
 }
@@ -1632,82 +2469,210 @@ void BankBouncerThread::run(){
 	//This is not exception safe....
 	myAPS_->mymutex_->lock();
 
-	FPGASELECT fpga = dac2fpga(channel_);
-
 	//To reduce traffic on the USB bus write only when we have a decent block size
 	//TODO:: implement
 //	const int MIN_WRITE_SIZE = MAX_LL_LENGTH/4;
 
-	//The current addresses in hardware and software
-	//nextMiniLL is the final miniLL we would like to write (% #miniLL's)
-	//lastMiniLL is the last miniLL we have written (% #miniLL's)
-	//curAddrHW is the hardware address of start of the currently playing miniLL (% MAX_LL_LENGTH)
+	//The streaming state for each target FPGA
+	//nextMiniLL is the next miniLL of the bank to write
 	//nextWriteAddrHW is the next address we write to in hardware (% MAX_LL_LENGTH)
-	int nextMiniLL, lastMiniLL, curAddrHW, nextWriteAddrHW;
-
-	//Get a pointer shortcut to the current bank
-	LLBank* curLLBank = &myAPS_->channels_[channel_].LLBank_;
-
-	//Helper function to see how many miniLL's we can write
-	auto entries_can_write = [&]() {
-		//Check how many we can fit in
-		int entriesOpen = mymod(curAddrHW-nextWriteAddrHW, MAX_LL_LENGTH);
-		int entriesToWrite = 0;
-		while ((entriesToWrite + curLLBank->miniLLLengths[nextMiniLL]) < entriesOpen){
-			entriesToWrite += curLLBank->miniLLLengths[nextMiniLL];
-			nextMiniLL = (nextMiniLL+1)%curLLBank->numMiniLLs;
-		}
-		FILE_LOG(logDEBUG1) << "Device ID: " << myAPS_->deviceID_ << " Next write Addr: " << nextWriteAddrHW << " Can write " << entriesToWrite << " entries.";
-		FILE_LOG(logDEBUG1) << "LastMiniLL: " << lastMiniLL << " nextMiniLL: " << nextMiniLL;
+	//queuedAddrHW are the hardware start addresses of the miniLLs written but not yet played, oldest first
+	//oldMiniLLs is how many of those still belong to the sequence we switched away from
+	//pollIdx are the indices into the batched poll results of the FPGAs this stream feeds
+	struct LLStream {
+		FPGASELECT fpga;
+		LLBank* bank;
+		size_t nextMiniLL;
+		int nextWriteAddrHW;
+		std::deque<int> queuedAddrHW;
+		size_t oldMiniLLs;
+		vector<size_t> pollIdx;
 	};
+	vector<LLStream> streams;
 
-	//Write the LL length to the max
-	FILE_LOG(logDEBUG1) << "Writing Link List Length: " << myhex << MAX_LL_LENGTH << " at address: " << FPGA_ADDR_CHA_LL_LENGTH;
-	myAPS_->write(fpga, FPGA_ADDR_CHA_LL_LENGTH, MAX_LL_LENGTH-1, false);
-	FILE_LOG(logDEBUG2) << "LL Length Register: " << FPGA::read_FPGA(myAPS_->handle_, FPGA_ADDR_CHA_LL_LENGTH, FPGA1);
+	//IQ LL data lives in channel 0 for FPGA1 and channel 2 for FPGA2
+	auto fpga2bank = [this](const FPGASELECT & fpga) {
+		return &myAPS_->channels_[(fpga == FPGA2) ? 2 : 0].LLBank_;
+	};
 
-	// Fill sequence memory
-	myAPS_->write_LL_data_IQ(fpga, 0, 0, MAX_LL_LENGTH, false);
+	//If both FPGAs are streaming identical data then write to both at once
+	//A staged sequence may not have identical banks so double buffered mode keeps them separate
+	if (fpgas.size() == 2 && !myAPS_->doubleBuffered_ && *fpga2bank(FPGA1) == *fpga2bank(FPGA2)) {
+		FILE_LOG(logDEBUG) << "Device ID: " << myAPS_->deviceID_ << " streaming identical LL data to both FPGAs";
+		streams.push_back({ALL_FPGAS, fpga2bank(FPGA1), 0, 0, {}, 0, {0, 1}});
+	}
+	else {
+		for (size_t ct = 0; ct < fpgas.size(); ct++) {
+			streams.push_back({fpgas[ct], fpga2bank(fpgas[ct]), 0, 0, {}, 0, {ct}});
+		}
+	}
 
-	// find the index of the last full miniLL that fit in memory
-	WordVec::iterator lastMiniLLIdxIt = std::lower_bound(curLLBank->miniLLStartIdx.begin(), curLLBank->miniLLStartIdx.end(), MAX_LL_LENGTH);
-	nextMiniLL = std::distance(curLLBank->miniLLStartIdx.begin(), lastMiniLLIdxIt) - 1;
-	lastMiniLL = nextMiniLL - 1;
+	//Number of entries from the start of a miniLL to the start of the next one
+	auto miniLL_span = [](const LLBank* bank, const size_t & idx) {
+		return ((idx+1 < bank->numMiniLLs) ? bank->miniLL_start(idx+1) : bank->length) - bank->miniLL_start(idx);
+	};
+
+	//Queue as many whole miniLLs as fit in entriesOpen, cycling through the bank as often as needed
+	//Each contiguous run of miniLLs up to the end of the bank goes out as one write
+	//Loading checks every streamed bank has miniLLs that fit, but a pass that queues nothing always ends the loop
+	auto queue_miniLLs = [&](LLStream & stream, const size_t & entriesOpen) {
+		LLBank* bank = stream.bank;
+		size_t entriesWritten = 0;
+		while (true) {
+			size_t passStartWritten = entriesWritten;
+			size_t runStart = stream.nextMiniLL;
+			size_t runEntries = 0;
+			int runAddrHW = stream.nextWriteAddrHW;
+			//Strictly less than so the write address never catches up with the playing address
+			while (stream.nextMiniLL < bank->numMiniLLs && (entriesWritten + runEntries + miniLL_span(bank, stream.nextMiniLL)) < entriesOpen) {
+				stream.queuedAddrHW.push_back((runAddrHW + runEntries) % MAX_LL_LENGTH);
+				runEntries += miniLL_span(bank, stream.nextMiniLL);
+				stream.nextMiniLL++;
+			}
+			if (runEntries > 0) {
+				size_t stopIdx = (stream.nextMiniLL < bank->numMiniLLs) ? bank->miniLL_start(stream.nextMiniLL) : bank->length;
+				myAPS_->write_LL_data_IQ(stream.fpga, runAddrHW, bank->miniLL_start(runStart), stopIdx, false, true);
+				entriesWritten += runEntries;
+				stream.nextWriteAddrHW = (runAddrHW + runEntries) % MAX_LL_LENGTH;
+			}
+			if (stream.nextMiniLL < bank->numMiniLLs) {
+				break;
+			}
+			stream.nextMiniLL = 0;
+			if (entriesWritten == passStartWritten) {
+				break;
+			}
+		}
+		FILE_LOG(logDEBUG1) << "Device ID: " << myAPS_->deviceID_ << " FPGA: " << stream.fpga << " Wrote " << entriesWritten << " entries; next write Addr: " << stream.nextWriteAddrHW << " nextMiniLL: " << stream.nextMiniLL;
+		return entriesWritten;
+	};
 
-	nextWriteAddrHW = curLLBank->miniLLStartIdx[nextMiniLL];
-	curAddrHW = 0;
+	Trace::Span fillSpan("stream_initial_fill", myAPS_->deviceID_);
+	for (auto & stream : streams) {
+		//Write the LL length to the max
+		FILE_LOG(logDEBUG1) << "Writing Link List Length: " << myhex << MAX_LL_LENGTH << " at address: " << FPGA_ADDR_CHA_LL_LENGTH;
+		myAPS_->write(stream.fpga, FPGA_ADDR_CHA_LL_LENGTH, MAX_LL_LENGTH-1, true);
+
+		// Fill sequence memory with whole miniLLs
+		queue_miniLLs(stream, MAX_LL_LENGTH);
+	}
+	//Push the initial fill for every FPGA in one transfer
+	myAPS_->flush();
+	fillSpan.finish();
+	FILE_LOG(logDEBUG2) << "LL Length Register: " << FPGA::read_FPGA(myAPS_->handle_, FPGA_ADDR_CHA_LL_LENGTH, FPGA1);
 
 	//Let the main thread know we are ready to roll
 	myAPS_->streaming_ = true;
 	myAPS_->mymutex_->unlock();
 
+	//A switch has to leave alone every queued miniLL the device could start on before the rewritten LL lands.
+	//That is how many miniLLs it gets through in the time from a poll to the end of the writes that follow,
+	//so keep the fastest miniLL rate and longest poll to write latency seen; the first poll has no rate to go on so doesn't switch
+	typedef std::chrono::steady_clock StreamClock;
+	StreamClock::time_point lastPollTime;
+	double maxMiniLLRate = 0;
+	double maxWriteLatency = 0;
+
 	//Now loop while streaming
 	while(running_) {
-		//Poll for current hardware address
+		Trace::Span refillSpan("stream_refill", myAPS_->deviceID_);
+		//Poll for current hardware addresses of all the FPGAs at once
 		myAPS_->mymutex_->lock();
-		curAddrHW = myAPS_->read_miniLL_startAddr(fpga);
+		vector<int> curAddrHW = myAPS_->read_miniLL_startAddr(fpgas);
 		myAPS_->mymutex_->unlock();
-		FILE_LOG(logDEBUG1) << "Device ID: " << myAPS_->deviceID_ << " Current LL Addr: " << curAddrHW;
+		StreamClock::time_point pollTime = StreamClock::now();
+		double pollInterval = (lastPollTime == StreamClock::time_point()) ? 0 : std::chrono::duration<double>(pollTime - lastPollTime).count();
+		lastPollTime = pollTime;
+		for (size_t ct = 0; ct < fpgas.size(); ct++) {
+			FILE_LOG(logDEBUG1) << "Device ID: " << myAPS_->deviceID_ << " FPGA: " << fpgas[ct] << " Current LL Addr: " << curAddrHW[ct];
+		}
+
+		//Drop the miniLLs every FPGA of a stream has moved past and note where the one furthest along is
+		vector<size_t> leadPos(streams.size(), 0);
+		bool allFound = true;
+		for (size_t streamct = 0; streamct < streams.size(); streamct++) {
+			LLStream & stream = streams[streamct];
+			size_t minPos = stream.queuedAddrHW.size();
+			size_t maxPos = 0;
+			for (size_t idx : stream.pollIdx) {
+				auto playingIt = std::find(stream.queuedAddrHW.begin(), stream.queuedAddrHW.end(), curAddrHW[idx]);
+				if (playingIt == stream.queuedAddrHW.end()) {
+					allFound = false;
+					minPos = 0;
+					break;
+				}
+				size_t pos = std::distance(stream.queuedAddrHW.begin(), playingIt);
+				minPos = std::min(minPos, pos);
+				maxPos = std::max(maxPos, pos);
+			}
+			stream.queuedAddrHW.erase(stream.queuedAddrHW.begin(), stream.queuedAddrHW.begin() + minPos);
+			stream.oldMiniLLs -= std::min(stream.oldMiniLLs, minPos);
+			leadPos[streamct] = maxPos - std::min(maxPos, minPos);
+			if (pollInterval > 0) {
+				maxMiniLLRate = std::max(maxMiniLLRate, minPos / pollInterval);
+			}
+		}
+
+		myAPS_->mymutex_->lock();
+
+		//Switch to the staged sequence by rewinding each stream to just past the guard miniLLs and writing the new LL from there
+		//This needs to know which miniLL every FPGA is playing so wait for a poll where they can all be found
+		bool switching = switchRequested && myAPS_->sequenceStaged_ && allFound && pollInterval > 0;
+		if (switching) {
+			size_t guardMiniLLs = SWITCH_GUARD_MINILLS + static_cast<size_t>(std::ceil(maxMiniLLRate * maxWriteLatency));
+			FILE_LOG(logDEBUG) << "Device ID: " << myAPS_->deviceID_ << " switching sequence with " << guardMiniLLs << " guard miniLLs";
+			for (size_t streamct = 0; streamct < streams.size(); streamct++) {
+				LLStream & stream = streams[streamct];
+				size_t keep = leadPos[streamct] + 1 + guardMiniLLs;
+				if (keep < stream.queuedAddrHW.size()) {
+					stream.nextWriteAddrHW = stream.queuedAddrHW[keep];
+					stream.queuedAddrHW.erase(stream.queuedAddrHW.begin() + keep, stream.queuedAddrHW.end());
+				}
+				stream.oldMiniLLs = stream.queuedAddrHW.size();
+				stream.nextMiniLL = 0;
+			}
+			myAPS_->commit_staged_sequence(true);
+		}
 
-		//See how many more miniLL's we can fit in
-		entries_can_write();
+		//Queue up whatever each stream can fit in
+		bool haveData = switching;
+		for (size_t streamct = 0; streamct < streams.size(); streamct++) {
+			LLStream & stream = streams[streamct];
+			//Check how many entries we can fit in; for a shared stream the FPGA with the least room wins
+			int entriesOpen = MAX_LL_LENGTH;
+			for (size_t idx : stream.pollIdx) {
+				entriesOpen = std::min(entriesOpen, mymod(curAddrHW[idx]-stream.nextWriteAddrHW, MAX_LL_LENGTH));
+			}
+			haveData |= (queue_miniLLs(stream, entriesOpen) > 0);
+		}
+		//Send the refills for all FPGAs as a single transfer
+		if (haveData) {
+			myAPS_->flush();
+			maxWriteLatency = std::max(maxWriteLatency, std::chrono::duration<double>(StreamClock::now() - pollTime).count());
+		}
 
-		//If there is something to write then do so
-		if (mymod(nextMiniLL - lastMiniLL, curLLBank->numMiniLLs) > 1){
-			size_t startMiniLL = (lastMiniLL+1)%curLLBank->numMiniLLs;
-			USHORT curWriteAddrHW = nextWriteAddrHW;
-			myAPS_->mymutex_->lock();
-			myAPS_->write_LL_data_IQ(fpga, USHORT(curWriteAddrHW), curLLBank->miniLLStartIdx[startMiniLL] , curLLBank->miniLLStartIdx[nextMiniLL], false);
-			myAPS_->mymutex_->unlock();
-			//Update where we want to write to next
-			nextWriteAddrHW = mymod(nextWriteAddrHW + mymod(curLLBank->miniLLStartIdx[nextMiniLL] - curLLBank->miniLLStartIdx[startMiniLL], curLLBank->length), MAX_LL_LENGTH);
-			lastMiniLL = nextMiniLL-1;
+		//Once every FPGA has played out the old sequence the switch is done
+		//The repeat register is shared by every miniLL so the new count only goes out now
+		if (switchRequested && !myAPS_->sequenceStaged_) {
+			bool drained = true;
+			for (auto & stream : streams) {
+				drained &= (stream.oldMiniLLs == 0);
+			}
+			if (drained) {
+				if (myAPS_->miniLLRepeatPending_) {
+					myAPS_->set_miniLL_repeat(myAPS_->stagedMiniLLRepeat_);
+				}
+				FILE_LOG(logDEBUG) << "Device ID: " << myAPS_->deviceID_ << " now playing switched sequence";
+				switchRequested = false;
+			}
 		}
+		myAPS_->mymutex_->unlock();
+		refillSpan.finish();
 
 		//Sleep for 10ms to reduce bus congestion
 		std::this_thread::sleep_for( std::chrono::milliseconds(10) );
 	}
-	
+
 
 
 }
@@ -24,6 +24,7 @@ public:
 
 	int connect();
 	int disconnect();
+	int shutdown();
 
 	int init(const string &, const bool &);
 	int reset(const FPGASELECT &) const;
@@ -50,24 +51,61 @@ public:
 	float get_channel_offset(const int &) const;
 	int set_channel_scale(const int &, const float &);
 	float get_channel_scale(const int &) const;
-	int set_offset_register(const int &, const float &);
+	int set_offset_register(const int &, const float &, const bool & queue = false);
+	int set_channel_params(const vector<int> &, const vector<float> &, const vector<float> &, const vector<bool> &);
 
 	int set_miniLL_repeat(const USHORT &);
 
 
 	template <typename T>
 	int set_waveform(const int & dac, const vector<T> & data){
+		if (check_waveform_length(dac, data.size()) != 0){
+			return -1;
+		}
 		channels_[dac].set_waveform(data);
 		return write_waveform(dac, channels_[dac].prep_waveform());
 	}
 
+	//Update several channels and send all the waveforms in one USB transaction
+	template <typename T>
+	int set_waveforms(const vector<int> & dacs, const vector<vector<T>> & data){
+		if (dacs.size() != data.size()){
+			return -1;
+		}
+		for (size_t ct = 0; ct < dacs.size(); ct++){
+			if (dacs[ct] < 0 || dacs[ct] > 3){
+				FILE_LOG(logERROR) << "Invalid channel " << dacs[ct] << " in set_waveforms";
+				return -2;
+			}
+			if (check_waveform_length(dacs[ct], data[ct].size()) != 0 || channels_[dacs[ct]].set_waveform(data[ct]) != 0){
+				return -3;
+			}
+		}
+		std::lock_guard<std::recursive_mutex> lock(*mymutex_);
+		for (const int & dac : dacs){
+			write_waveform(dac, channels_[dac].prep_waveform(), activeWFOffset_, true);
+		}
+		flush();
+		return 0;
+	}
+
+	int set_waveform_strided(const int &, const void *, const size_t &, const ptrdiff_t &, const ELEMENT_TYPE &);
+
 	int set_run_mode(const int &, const RUN_MODE &);
 	int set_repeat_mode(const int &, const bool &);
 
-	int set_LLData_IQ(const FPGASELECT &, const WordVec &, const WordVec &, const WordVec &, const WordVec &, const WordVec &);
+	int set_LLData_IQ(const FPGASELECT &, WordVec, WordVec, WordVec, WordVec, WordVec);
 	int clear_channel_data();
 
 	int load_sequence_file(const string &);
+	static int compile_sequence_file(const string &, const string &);
+	int load_compiled_sequence(const string &);
+
+	int set_double_buffered(const bool &);
+	int stage_sequence_file(const string &);
+	int switch_sequence();
+
+	int restore_to_device(string &);
 
 	int run();
 	int stop();
@@ -89,16 +127,31 @@ private:
 	string deviceSerial_;
 	FT_HANDLE handle_;
 	vector<Channel> channels_;
+	//Double buffered mode: the next sequence waits in stagedChannels_ while its waveforms sit in the inactive half of memory
+	bool doubleBuffered_;
+	//Read by switch_sequence and the streaming thread without the device mutex
+	std::atomic<bool> sequenceStaged_;
+	vector<Channel> stagedChannels_;
+	USHORT stagedMiniLLRepeat_;
+	//Set when the streaming thread has switched LLs but the device is still playing the old sequence,
+	//so stagedMiniLLRepeat_ has yet to go to the LL repeat register
+	bool miniLLRepeatPending_;
+	//Last value written to the LL repeat register; the register can't be read back
+	USHORT miniLLRepeat_;
+	//Sample address of the half of waveform memory currently playing
+	size_t activeWFOffset_;
 	map<FPGASELECT, CheckSum> checksums_;
 	int samplingRate_;
 	vector<UCHAR> writeQueue_;
 	vector<size_t> offsetQueue_;
-	vector<BankBouncerThread> myBankBouncerThreads_;
+	BankBouncerThread myBankBouncerThread_;
 	//Flag for whether streaming is up and running
 	std::atomic<bool> streaming_;
 	//A mutex to control access to the APS unit during streaming
+	//write and flush take it so the streaming thread and callers never share the write queue or checksums;
+	//it is recursive so a batch of writes can hold it until its flush
 	//Since mutexs are non-copyable and non-movable we use an unique_ptr
-	std::unique_ptr<std::mutex> mymutex_;
+	std::unique_ptr<std::recursive_mutex> mymutex_;
 
 	int write(const FPGASELECT & fpga, const unsigned int & addr, const USHORT & data, const bool & queue = false);
 	int write(const FPGASELECT & fpga, const unsigned int & addr, const vector<USHORT> & data, const bool & queue = false);
@@ -127,14 +180,24 @@ private:
 	int reset_checksums(const FPGASELECT &);
 	bool verify_checksums(const FPGASELECT &);
 
+	int check_waveform_length(const int &, const size_t &) const;
 	int write_waveform(const int &, const vector<short> &);
+	int write_waveform(const int &, const vector<short> &, const size_t &, const bool & queue = false, const bool & writeLengthFlag = true);
+
+	static int read_sequence_channel(H5::H5File &, const int &, Channel &);
+	static int read_sequence_repeat(H5::H5File &, USHORT &);
+	static USHORT fold_sequence_repeats(vector<Channel> &, const USHORT &);
+	int check_LL_streamable(const LLBank &) const;
+	int check_LL_streamable(const vector<Channel> &) const;
+	int commit_staged_sequence(const bool &);
 
-	int write_LL_data_IQ(const FPGASELECT &, const ULONG &, const size_t &, const size_t &, const bool &);
+	int write_LL_data_IQ(const FPGASELECT &, const ULONG &, const size_t &, const size_t &, const bool &, const bool & queue = false);
 	int set_LL_data_IQ(const FPGASELECT &, const WordVec &, const WordVec &, const WordVec &, const WordVec &, const WordVec &);
 	int stream_LL_data(const int);
 	int read_LL_addr(const FPGASELECT &);
 	int read_LL_addr(const int &);
 	int read_miniLL_startAddr(const FPGASELECT &);
+	vector<int> read_miniLL_startAddr(const vector<FPGASELECT> &);
 
 
 
@@ -6,21 +6,39 @@
  */
 
 #include "APSRack.h"
+#include "libaps.h"
 
-APSRack::APSRack() : numDevices_{0} {
+APSRack::APSRack() : devices_{nullptr}, nextOpID_{1}, cleanedUp_{false} {
+	//Start the log writer first so it outlives the rack
+	Output2FILE::Flush();
+	//Start with an empty table so readers always have one
+	std::lock_guard<std::mutex> lock(enumMutex_);
+	publish(new DeviceTable());
 }
 
 APSRack::~APSRack()  {
-	//Close the logging file so we don't leave it dangling
-	fclose(Output2FILE::Stream());
+	//This runs when the library is unloaded and joining a thread then deadlocks on the loader lock.
+	//cleanup() stops the threads; if it wasn't called leave everything that may own one to the OS.
+	if (!cleanedUp_) {
+		for (auto & worker : asyncWorkers_) {
+			worker.second.release();
+		}
+		for (auto & table : tables_) {
+			table.release();
+		}
+	}
+	//Write out what is queued and close the logging file so we don't leave it dangling
+	Output2FILE::Redirect(nullptr);
 }
 
 //Initialize the rack by polling for devices and serial numbers
 int APSRack::init() {
 
 	//Create the logger
+	Output2FILE::Start();
 	FILE* pFile = fopen("libaps.log", "a");
-	Output2FILE::Stream() = pFile;
+	Output2FILE::Redirect(pFile);
+	cleanedUp_ = false;
 
 	//Enumerate the serial numbers of the devices attached
 	enumerate_devices();
@@ -28,15 +46,35 @@ int APSRack::init() {
 	return 0;
 }
 
+int APSRack::cleanup() {
+	/*
+	 * Stop and join every thread the library started: the async workers, the streaming and LL prefetch
+	 * threads of each unit and finally the log writer. Call before unloading the library.
+	 */
+	{
+		std::lock_guard<std::mutex> lock(asyncMutex_);
+		asyncWorkers_.clear();
+		asyncOps_.clear();
+	}
+	for (auto & device : device_table().devices) {
+		std::lock_guard<std::mutex> lock(device->lock);
+		device->aps.shutdown();
+	}
+	FILE_LOG(logINFO) << "Stopped all library threads";
+	Output2FILE::Shutdown();
+	cleanedUp_ = true;
+	return 0;
+}
+
 //Initialize a specific APS unit
 int APSRack::initAPS(const int & deviceID, const string & bitFile, const bool & forceReload){
-	return APSs_[deviceID].init(bitFile, forceReload);
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.init(bitFile, forceReload); });
 }
 
 int APSRack::get_num_devices()  {
 	int numDevices;
 	FT_ListDevices(&numDevices, NULL, FT_LIST_NUMBER_ONLY);
-	if (numDevices_ != numDevices) {
+	if (static_cast<int>(device_table().devices.size()) != numDevices) {
 		update_device_enumeration();
 	}
 	return numDevices;
@@ -54,61 +92,92 @@ string APSRack::get_deviceSerial(const int & deviceID) {
 	// match serials for each device id to make sure mapping of device count to serial
 	// number is still correct
 	// if serial number is different re-enumerate
+	const DeviceTable * table = &device_table();
 	for(unsigned int cnt = 0; cnt < testSerials.size(); cnt++) {
-		if (testSerials[cnt].compare(deviceSerials_[cnt]) != 0) {
-			FILE_LOG(logDEBUG) << testSerials[cnt] << " does not match " << deviceSerials_[cnt] << " re-enumerating.";
+		if (cnt >= table->serials.size() || testSerials[cnt].compare(table->serials[cnt]) != 0) {
+			FILE_LOG(logDEBUG) << testSerials[cnt] << " does not match the enumerated devices; re-enumerating.";
 			update_device_enumeration();
+			table = &device_table();
 			break;
 		}
 	}
 
 	// test to make sure ID is valid relative to vector size
-	if (static_cast<size_t>(deviceID) > deviceSerials_.size()) {
+	if (deviceID < 0 || static_cast<size_t>(deviceID) >= table->serials.size()) {
 		return "InvalidID";
 	}
 
-	return deviceSerials_[deviceID];
+	return table->serials[deviceID];
+}
+
+int APSRack::serial2dev(const string & deviceSerial) const{
+	//Device ID for a serial number or -1 if it is not attached
+	const DeviceTable & table = device_table();
+	auto it = table.serial2dev.find(deviceSerial);
+	return (it == table.serial2dev.end()) ? -1 : it->second;
+}
+
+APSRack::Device * APSRack::find_device(const int & deviceID) const{
+	const DeviceTable & table = device_table();
+	if (deviceID < 0 || static_cast<size_t>(deviceID) >= table.devices.size()){
+		FILE_LOG(logERROR) << "Unknown device ID " << deviceID;
+		return nullptr;
+	}
+	return table.devices[deviceID].get();
+}
+
+void APSRack::publish(DeviceTable * table){
+	/*
+	 * Make table the current device table; enumMutex_ must be held
+	 * Old tables are kept until the rack goes away since readers may still be using them without a lock.
+	 * Re-enumeration only happens when units are plugged in or removed so they don't pile up.
+	 */
+	tables_.emplace_back(table);
+	devices_.store(table, std::memory_order_release);
 }
 
 //This will reset the APS vector so it really should only be called during initialization
 void APSRack::enumerate_devices() {
 
+	std::lock_guard<std::mutex> enumLock(enumMutex_);
+
 	//Have to disconnect everything first
-	for (auto & aps : APSs_){
-		aps.disconnect();
+	for (auto & device : device_table().devices){
+		std::lock_guard<std::mutex> lock(device->lock);
+		device->aps.disconnect();
 	}
-	FTDI::get_device_serials(deviceSerials_);
-	numDevices_ = deviceSerials_.size();
 
-	APSs_.clear();
-	APSs_.reserve(numDevices_);
+	DeviceTable * newTable = new DeviceTable();
+	FTDI::get_device_serials(newTable->serials);
+	newTable->devices.reserve(newTable->serials.size());
 
 	//	Now setup the map between device serials and number and assign the APS units appropriately
 	//	Also setup the FPGA checksums
 	size_t devicect = 0;
-	for (string tmpSerial : deviceSerials_) {
-		serial2dev[tmpSerial] = devicect;
-		APSs_.emplace_back(devicect, tmpSerial);
+	for (string tmpSerial : newTable->serials) {
+		newTable->serial2dev[tmpSerial] = devicect;
+		newTable->devices.emplace_back(new Device(devicect, tmpSerial));
 		FILE_LOG(logDEBUG) << "Device " << devicect << " has serial number " << tmpSerial;
 		devicect++;
 	}
+	publish(newTable);
 }
 
 // This will update enumerate of devices by matching serial numbers
 // If a device is missing it will be removed
 // New devices are added 
-// Old devices are left as is (moved in place to new vector)
+// Old devices are left as is (shared with the new table)
 void APSRack::update_device_enumeration() {
 
-	vector<string> newSerials;
-	FTDI::get_device_serials(newSerials);
+	std::lock_guard<std::mutex> enumLock(enumMutex_);
+	const DeviceTable & oldTable = device_table();
 
-	// construct new APS_ vector & new serial2dev map
-	vector<APS> newAPS_;
-	map<string, int> newSerial2dev;
+	// construct new device table
+	DeviceTable * newTable = new DeviceTable();
+	FTDI::get_device_serials(newTable->serials);
 
 	size_t devicect = 0;
-	for (string tmpSerial : newSerials) {
+	for (string tmpSerial : newTable->serials) {
 		
 		// example test to see if FTDI thinks device is open
 		if (FTDI::isOpen(devicect)) {
@@ -116,49 +185,51 @@ void APSRack::update_device_enumeration() {
 		}
 
 		// does the new serial number exist in the old list? 
-		if ( serial2dev.count(tmpSerial) > 0) {
-			// move from old APSs_ vector to new
-			newAPS_.push_back(std::move(APSs_[serial2dev[tmpSerial]]));
-			newAPS_.back().deviceID_ = devicect;
+		auto oldDevice = oldTable.serial2dev.find(tmpSerial);
+		if (oldDevice != oldTable.serial2dev.end()) {
+			// share it with the new table
+			std::shared_ptr<Device> device = oldTable.devices[oldDevice->second];
+			{
+				std::lock_guard<std::mutex> lock(device->lock);
+				device->aps.deviceID_ = devicect;
+			}
+			newTable->devices.push_back(device);
 			FILE_LOG(logDEBUG) << "Old Device " << devicect << " [ " << tmpSerial << " ] moved";
 		} else {
-			// does not exist so construct it in the new vector
-			newAPS_.emplace_back(devicect, tmpSerial);
+			// does not exist so construct it in the new table
+			newTable->devices.emplace_back(new Device(devicect, tmpSerial));
 			FILE_LOG(logDEBUG) << "New Device " << devicect << " [ " << tmpSerial << " ]";
 		}
 
-		newSerial2dev[tmpSerial] = devicect;
+		newTable->serial2dev[tmpSerial] = devicect;
 		devicect++;
 	}
 
-	// update APSRack members with new lists
-	numDevices_ = newSerials.size();  // number of devices
-	deviceSerials_ = newSerials;		  // device serial vector
-	APSs_ = std::move(newAPS_);           // APS vector
-	serial2dev = newSerial2dev;           // serial to device map
+	publish(newTable);
 }
 
 UCHAR APSRack::read_status_control(const int & deviceID) const{
-	return APSs_[deviceID].read_status_ctrl();
+	return with_device(deviceID, UCHAR(0), [&](APS & aps){ return aps.read_status_ctrl(); });
 }
 
 int APSRack::read_bitfile_version(const int & deviceID) const {
-	return APSs_[deviceID].read_bitFile_version(ALL_FPGAS);
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.read_bitFile_version(ALL_FPGAS); });
 }
 
 int APSRack::connect(const int & deviceID){
 	//Connect to a instrument specified by deviceID
-	return APSs_[deviceID].connect();
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.connect(); });
 }
 
 int APSRack::disconnect(const int & deviceID){
-	return APSs_[deviceID].disconnect();
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.disconnect(); });
 }
 
 int APSRack::connect(const string & deviceSerial){
 	//Look up the associated ID and call the next connect
-	if (serial2dev.count(deviceSerial) > 0) {
-		return APSs_[serial2dev[deviceSerial]].connect();
+	int deviceID = serial2dev(deviceSerial);
+	if (deviceID >= 0) {
+		return connect(deviceID);
 	} else {
 		return -1;
 	}
@@ -166,50 +237,70 @@ int APSRack::connect(const string & deviceSerial){
 
 int APSRack::disconnect(const string & deviceSerial){
 	//Look up the associated ID and call the next connect
-	return APSs_[serial2dev[deviceSerial]].disconnect();
+	return disconnect(serial2dev(deviceSerial));
 }
 
 int APSRack::program_FPGA(const int & deviceID, const string &bitFile, const FPGASELECT & chipSelect, const int & expectedVersion){
-	return APSs_[deviceID].program_FPGA(bitFile, chipSelect, expectedVersion);
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.program_FPGA(bitFile, chipSelect, expectedVersion); });
 }
 
 int APSRack::setup_DACs(const int & deviceID) const{
-	return APSs_[deviceID].setup_DACs();
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.setup_DACs(); });
 }
 
 int APSRack::set_sampleRate(const int & deviceID, const int & freq) {
-	return APSs_[deviceID].set_sampleRate(freq);
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.set_sampleRate(freq); });
 }
 
 int APSRack::get_sampleRate(const int & deviceID) const{
-	return APSs_[deviceID].get_sampleRate();
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.get_sampleRate(); });
 }
 
 int APSRack::set_run_mode(const int & deviceID, const int & dac, const RUN_MODE & mode){
-	return APSs_[deviceID].set_run_mode(dac, mode);
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.set_run_mode(dac, mode); });
 }
 
 int APSRack::set_repeat_mode(const int & deviceID, const int & dac, const bool & mode){
-	return APSs_[deviceID].set_repeat_mode(dac, mode);
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.set_repeat_mode(dac, mode); });
 }
 
 int APSRack::clear_channel_data(const int & deviceID) {
-	return APSs_[deviceID].clear_channel_data();
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.clear_channel_data(); });
 }
 
 int APSRack::run(const int & deviceID) {
-	return APSs_[deviceID].run();
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.run(); });
 }
 int APSRack::stop(const int & deviceID) {
-	return APSs_[deviceID].stop();
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.stop(); });
 }
 
 int APSRack::load_sequence_file(const int & deviceID, const string & seqFile){
-	return APSs_[deviceID].load_sequence_file(seqFile);
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.load_sequence_file(seqFile); });
+}
+
+int APSRack::compile_sequence_file(const string & seqFile, const string & compiledFile){
+	return APS::compile_sequence_file(seqFile, compiledFile);
+}
+
+int APSRack::load_compiled_sequence(const int & deviceID, const string & compiledFile){
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.load_compiled_sequence(compiledFile); });
+}
+
+int APSRack::set_double_buffered(const int & deviceID, const bool & enable){
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.set_double_buffered(enable); });
+}
+
+int APSRack::stage_sequence_file(const int & deviceID, const string & seqFile){
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.stage_sequence_file(seqFile); });
 }
 
-int APSRack::set_LL_data(const int & deviceID, const int & channelNum, const WordVec & addr, const WordVec & count, const WordVec & trigger1, const WordVec & trigger2, const WordVec & repeat){
-	return APSs_[deviceID].set_LLData_IQ(dac2fpga(channelNum), addr, count, trigger1, trigger2, repeat);
+int APSRack::switch_sequence(const int & deviceID){
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.switch_sequence(); });
+}
+
+int APSRack::set_LL_data(const int & deviceID, const int & channelNum, WordVec addr, WordVec count, WordVec trigger1, WordVec trigger2, WordVec repeat){
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.set_LLData_IQ(dac2fpga(channelNum), std::move(addr), std::move(count), std::move(trigger1), std::move(trigger2), std::move(repeat)); });
 }
 
 int APSRack::get_running(const int & deviceID){
@@ -220,10 +311,8 @@ int APSRack::get_running(const int & deviceID){
 
 int APSRack::set_log(FILE * pFile) {
 	if (pFile) {
-		//Close the current file
-		if(Output2FILE::Stream()) fclose(Output2FILE::Stream());
-		//Assign the new one
-		Output2FILE::Stream() = pFile;
+		//Close the current file and assign the new one
+		Output2FILE::Redirect(pFile);
 		return 1;
 	} else {
 		return 0;
@@ -235,64 +324,90 @@ int APSRack::set_logging_level(const int & logLevel){
 	return 0;
 }
 
+string APSRack::get_perf_stats() const{
+	return PerfStats::to_json();
+}
+
+int APSRack::reset_perf_stats(){
+	PerfStats::reset();
+	return 0;
+}
+
+int APSRack::enable_trace(const bool & enable){
+	Trace::set_enabled(enable);
+	return 0;
+}
+
+int APSRack::export_trace(const string & traceFile){
+	return Trace::export_json(traceFile);
+}
+
 int APSRack::set_trigger_source(const int & deviceID, const TRIGGERSOURCE & triggerSource) {
-	return APSs_[deviceID].set_trigger_source(triggerSource);
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.set_trigger_source(triggerSource); });
 }
 
 TRIGGERSOURCE APSRack::get_trigger_source(const int & deviceID) const{
-	return APSs_[deviceID].get_trigger_source();
+	return with_device(deviceID, INTERNAL, [&](APS & aps){ return aps.get_trigger_source(); });
 }
 
 int APSRack::set_trigger_interval(const int & deviceID, const double & interval){
-	return APSs_[deviceID].set_trigger_interval(interval);
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.set_trigger_interval(interval); });
 }
 
 double APSRack::get_trigger_interval(const int & deviceID) const{
-	return APSs_[deviceID].get_trigger_interval();
+	return with_device(deviceID, -1.0, [&](APS & aps){ return aps.get_trigger_interval(); });
 }
 
 int APSRack::set_miniLL_repeat(const int & deviceID, const USHORT & repeat){
-	return APSs_[deviceID].set_miniLL_repeat(repeat);
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.set_miniLL_repeat(repeat); });
 }
 
 int APSRack::set_channel_enabled(const int & deviceID, const int & channelNum, const bool & enable){
-	return APSs_[deviceID].set_channel_enabled(channelNum, enable);
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.set_channel_enabled(channelNum, enable); });
 }
 
 bool APSRack::get_channel_enabled(const int & deviceID, const int & channelNum) const{
-	return APSs_[deviceID].get_channel_enabled(channelNum);
+	return with_device(deviceID, false, [&](APS & aps){ return aps.get_channel_enabled(channelNum); });
+}
+
+int APSRack::set_waveform_strided(const int & deviceID, const int & channelNum, const void * data, const size_t & numPts, const ptrdiff_t & stride, const ELEMENT_TYPE & type){
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.set_waveform_strided(channelNum, data, numPts, stride, type); });
+}
+
+int APSRack::set_channel_params(const int & deviceID, const vector<int> & channelNums, const vector<float> & offsets, const vector<float> & scales, const vector<bool> & enables){
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.set_channel_params(channelNums, offsets, scales, enables); });
 }
 
 int APSRack::set_channel_offset(const int & deviceID, const int & channelNum, const float & offset){
-	return APSs_[deviceID].set_channel_offset(channelNum, offset);
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.set_channel_offset(channelNum, offset); });
 }
 
 float APSRack::get_channel_offset(const int & deviceID, const int & channelNum) const{
-	return APSs_[deviceID].get_channel_offset(channelNum);
+	return with_device(deviceID, 0.0f, [&](APS & aps){ return aps.get_channel_offset(channelNum); });
 }
 
 int APSRack::set_channel_scale(const int & deviceID, const int & channelNum, const float & scale){
-	return APSs_[deviceID].set_channel_scale(channelNum, scale);
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.set_channel_scale(channelNum, scale); });
 }
 
 float APSRack::get_channel_scale(const int & deviceID, const int & channelNum) const{
-	return APSs_[deviceID].get_channel_scale(channelNum);
+	return with_device(deviceID, 0.0f, [&](APS & aps){ return aps.get_channel_scale(channelNum); });
 }
 
 int APSRack::save_state_files(){
 	// loop through available APS Units and save state
-	for(unsigned int apsct = 0; apsct < APSs_.size(); apsct++) {
+	for(unsigned int apsct = 0; apsct < device_table().devices.size(); apsct++) {
 		string stateFileName = ""; // use default file name
-		APSs_[apsct].save_state_file(stateFileName);
+		with_device(apsct, 0, [&](APS & aps){ return aps.save_state_file(stateFileName); });
 	}
 	return 0;
 }
 
 int APSRack::read_state_files(){
 	// loop through available APS Units and load state
-	for(unsigned int  apsct = 0; apsct < APSs_.size(); apsct++) {
+	for(unsigned int  apsct = 0; apsct < device_table().devices.size(); apsct++) {
 		string stateFileName = ""; // use default file name
-		APSs_[apsct].read_state_file(stateFileName);
+		with_device(apsct, 0, [&](APS & aps){ return aps.read_state_file(stateFileName); });
 	}
 	return 0;
 }
@@ -304,19 +419,27 @@ int APSRack::save_bulk_state_file(string & stateFile){
 	}
 
 	FILE_LOG(logDEBUG) << "Writing Bulk State File " << stateFile;
+	//Device locks come before the HDF5 lock everywhere else so take them all first
+	const DeviceTable & table = device_table();
+	vector<std::unique_lock<std::mutex>> deviceLocks;
+	for (auto & device : table.devices) {
+		deviceLocks.emplace_back(device->lock);
+	}
+	HDF5Lock h5Lock(hdf5_mutex());
 	H5::H5File H5StateFile(stateFile, H5F_ACC_TRUNC);
 	// loop through available APS Units and save state
-	for(unsigned int  apsct = 0; apsct < APSs_.size(); apsct++) {
+	int status = 0;
+	for (auto & device : table.devices) {
 		string rootStr = "/";
-		rootStr += APSs_[apsct].deviceSerial_ ;
+		rootStr += device->aps.deviceSerial_ ;
 		FILE_LOG(logDEBUG) << "Creating Group: " << rootStr;
 		H5::Group tmpGroup = H5StateFile.createGroup(rootStr);
 		tmpGroup.close();
-		APSs_[apsct].write_state_to_hdf5(H5StateFile, rootStr);
+		status |= device->aps.write_state_to_hdf5(H5StateFile, rootStr);
 	}
 	//Close the file
 	H5StateFile.close();
-	return 0;
+	return status;
 }
 
 int APSRack::read_bulk_state_file(string & stateFile){
@@ -324,23 +447,139 @@ int APSRack::read_bulk_state_file(string & stateFile){
 		stateFile += "cache_APSRack.h5";
 	}
 	FILE_LOG(logDEBUG) << "Reading Bulk State File " << stateFile;
+	const DeviceTable & table = device_table();
+	vector<std::unique_lock<std::mutex>> deviceLocks;
+	for (auto & device : table.devices) {
+		deviceLocks.emplace_back(device->lock);
+	}
+	HDF5Lock h5Lock(hdf5_mutex());
 	H5::H5File H5StateFile(stateFile, H5F_ACC_RDONLY);
 
 	// loop through available APS Units and load data
-	for(unsigned int  apsct = 0; apsct < APSs_.size(); apsct++) {
+	int status = 0;
+	for (auto & device : table.devices) {
 		string rootStr = "/";
-		rootStr += "/" + APSs_[apsct].deviceSerial_;
-		APSs_[apsct].read_state_from_hdf5(H5StateFile, rootStr);
+		rootStr += "/" + device->aps.deviceSerial_;
+		status |= device->aps.read_state_from_hdf5(H5StateFile, rootStr);
 	}
 	//Close the file
 	H5StateFile.close();
-	return 0;
+	return status;
+}
+
+int APSRack::save_state_file(const int & deviceID, string & stateFile){
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.save_state_file(stateFile); });
+}
+
+int APSRack::restore_to_device(const int & deviceID, string & stateFile){
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.restore_to_device(stateFile); });
+}
+
+int APSRack::submit_async(const int & deviceID, std::function<int(APS &)> op){
+	/*
+	 * Queue op on the device's worker thread and return an ID for op_poll/op_wait/op_result
+	 * Operations on the same device run in the order they were submitted. The device is looked up now
+	 * so the operation runs against this unit even if the IDs are re-enumerated before it starts.
+	 */
+	const DeviceTable & table = device_table();
+	if (deviceID < 0 || static_cast<size_t>(deviceID) >= table.devices.size()){
+		FILE_LOG(logERROR) << "Cannot queue async operation for unknown device " << deviceID;
+		return APS_INVALID_DEVICE;
+	}
+	std::shared_ptr<Device> device = table.devices[deviceID];
+	std::lock_guard<std::mutex> lock(asyncMutex_);
+	std::unique_ptr<AsyncWorker> & worker = asyncWorkers_[device->aps.deviceSerial_];
+	if (!worker){
+		worker.reset(new AsyncWorker());
+	}
+	prune_async_ops();
+	int opID = nextOpID_++;
+	asyncOps_[opID] = worker->submit([device, op](){
+		std::lock_guard<std::mutex> deviceLock(device->lock);
+		return op(device->aps);
+	});
+	FILE_LOG(logDEBUG) << "Queued async operation " << opID << " on device " << deviceID << " (" << device->aps.deviceSerial_ << ")";
+	return opID;
+}
+
+void APSRack::prune_async_ops(){
+	/*
+	 * Keep the operation table bounded when callers never collect their results: once it is full
+	 * drop the oldest finished operations. asyncMutex_ must be held.
+	 */
+	for (auto it = asyncOps_.begin(); asyncOps_.size() >= MAX_ASYNC_OPS && it != asyncOps_.end(); ){
+		if (it->second.wait_for(std::chrono::milliseconds(0)) == std::future_status::ready){
+			FILE_LOG(logWARNING) << "Dropping uncollected result of async operation " << it->first;
+			it = asyncOps_.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+std::shared_future<int> APSRack::find_op(const int & opID){
+	std::lock_guard<std::mutex> lock(asyncMutex_);
+	auto it = asyncOps_.find(opID);
+	return (it == asyncOps_.end()) ? std::shared_future<int>() : it->second;
+}
+
+int APSRack::op_poll(const int & opID){
+	//1 if the operation has finished, 0 if it is still queued or running
+	return op_wait(opID, 0);
+}
+
+int APSRack::op_wait(const int & opID, const int & timeoutMS){
+	/*
+	 * Wait up to timeoutMS milliseconds (forever if negative) for an operation
+	 * Returns 1 if it finished, 0 on timeout
+	 */
+	std::shared_future<int> op = find_op(opID);
+	if (!op.valid()){
+		return APS_INVALID_OP;
+	}
+	if (timeoutMS < 0){
+		op.wait();
+		return 1;
+	}
+	return (op.wait_for(std::chrono::milliseconds(timeoutMS)) == std::future_status::ready) ? 1 : 0;
+}
+
+int APSRack::op_result(const int & opID){
+	/*
+	 * Return code of a finished operation; the ID is released afterwards
+	 */
+	std::shared_future<int> op = find_op(opID);
+	if (!op.valid()){
+		return APS_INVALID_OP;
+	}
+	if (op.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready){
+		return APS_OP_PENDING;
+	}
+	{
+		std::lock_guard<std::mutex> lock(asyncMutex_);
+		asyncOps_.erase(opID);
+	}
+	try {
+		return op.get();
+	} catch (...) {
+		return APS_UNKNOWN_ERROR;
+	}
+}
+
+int APSRack::op_discard(const int & opID){
+	/*
+	 * Release an operation ID without collecting its result; a queued or running operation still runs
+	 */
+	std::lock_guard<std::mutex> lock(asyncMutex_);
+	return (asyncOps_.erase(opID) == 0) ? APS_INVALID_OP : APS_OK;
 }
 
 int APSRack::raw_write(int deviceID, int numBytes, UCHAR* data){
-	DWORD bytesWritten;
-	FT_Write(APSs_[deviceID].handle_, data, numBytes, &bytesWritten);
-	return int(bytesWritten);
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){
+		DWORD bytesWritten;
+		FT_Write(aps.handle_, data, numBytes, &bytesWritten);
+		return int(bytesWritten);
+	});
 }
 
 int APSRack::raw_read(int deviceID, FPGASELECT fpga) {
@@ -349,16 +588,20 @@ int APSRack::raw_read(int deviceID, FPGASELECT fpga) {
 	USHORT transferSize = 1;
 	int Command = APS_FPGA_IO;
 
-	//Send the read command byte
+	//Send the read command byte and look for the data
 	UCHAR commandPacket = 0x80 | Command | (fpga<<2) | transferSize;
-    FT_Write(APSs_[deviceID].handle_, &commandPacket, 1, &bytesWritten);
-
-	//Look for the data
-	FT_Read(APSs_[deviceID].handle_, dataBuffer, 2, &bytesRead);
+	int status = with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){
+		FT_Write(aps.handle_, &commandPacket, 1, &bytesWritten);
+		FT_Read(aps.handle_, dataBuffer, 2, &bytesRead);
+		return 0;
+	});
+	if (status != 0){
+		return status;
+	}
 	FILE_LOG(logDEBUG2) << "Read " << bytesRead << " bytes with value" << myhex << ((dataBuffer[0] << 8) | dataBuffer[1]);
 	return int((dataBuffer[0] << 8) | dataBuffer[1]);
 }
 
 int APSRack::read_register(int deviceID, FPGASELECT fpga, int addr){
-	return FPGA::read_FPGA(APSs_[deviceID].handle_, addr, fpga);
+	return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return int(FPGA::read_FPGA(aps.handle_, addr, fpga)); });
 }
@@ -10,15 +10,24 @@
 #ifndef APSRACK_H_
 #define APSRACK_H_
 
+#include "libaps.h"
 
+/*
+ * The rack is safe to use from several threads at once:
+ * - every call into an APS unit holds that unit's lock, so calls for different units run
+ *   concurrently and calls for the same unit are serialized
+ * - the device table is an immutable snapshot replaced wholesale on re-enumeration, so looking
+ *   up a device is a single atomic load
+ */
 class APSRack {
 public:
 	APSRack();
 	~APSRack();
 
-	map<string, int> serial2dev;
+	int serial2dev(const string &) const;
 
 	int init();
+	int cleanup();
 	int initAPS(const int &, const string &, const bool &);
 	int connect(const int &);
 	int connect(const string &);
@@ -55,6 +64,8 @@ public:
 	int set_channel_scale(const int &, const int &, const float &);
 	float get_channel_scale(const int &, const int &) const;
 	int set_channel_enabled(const int &, const int &, const bool &);
+	int set_waveform_strided(const int &, const int &, const void *, const size_t &, const ptrdiff_t &, const ELEMENT_TYPE &);
+	int set_channel_params(const int &, const vector<int> &, const vector<float> &, const vector<float> &, const vector<bool> &);
 	bool get_channel_enabled(const int &, const int &) const;
 
 	int get_running(const int &);
@@ -62,24 +73,48 @@ public:
 	int set_log(FILE *);
 	int set_logging_level(const int &);
 
+	string get_perf_stats() const;
+	int reset_perf_stats();
+	int enable_trace(const bool &);
+	int export_trace(const string &);
+
 	//Pass through both short and float waveforms
 	template <typename T>
 	int set_waveform(const int & deviceID, const int & dac, const vector<T> & data){
-		return APSs_[deviceID].set_waveform(dac, data);
+		return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.set_waveform(dac, data); });
+	}
+
+	template <typename T>
+	int set_waveforms(const int & deviceID, const vector<int> & dacs, const vector<vector<T>> & data){
+		return with_device(deviceID, int(APS_INVALID_DEVICE), [&](APS & aps){ return aps.set_waveforms(dacs, data); });
 	}
 
 	int set_run_mode(const int &, const int &, const RUN_MODE &);
 	int set_repeat_mode(const int &, const int &, const bool & mode);
 
-	int set_LL_data(const int &, const int &, const WordVec &, const WordVec &, const WordVec &, const WordVec &, const WordVec &);
+	int set_LL_data(const int &, const int &, WordVec, WordVec, WordVec, WordVec, WordVec);
 	int set_LL_data(const int &, const int &, const WordVec &, const WordVec &, const WordVec &, const WordVec &);
 
 	int load_sequence_file(const int &, const string &);
+	int compile_sequence_file(const string &, const string &);
+	int load_compiled_sequence(const int &, const string &);
+	int set_double_buffered(const int &, const bool &);
+	int stage_sequence_file(const int &, const string &);
+	int switch_sequence(const int &);
 
 	int save_state_files();
 	int read_state_files();
 	int save_bulk_state_file(string & );
 	int read_bulk_state_file(string & );
+	int save_state_file(const int &, string &);
+	int restore_to_device(const int &, string &);
+
+	//Asynchronous operations run on a per-device worker and are tracked by an operation ID
+	int submit_async(const int &, std::function<int(APS &)>);
+	int op_poll(const int &);
+	int op_wait(const int &, const int &);
+	int op_result(const int &);
+	int op_discard(const int &);
 
 	int raw_write(int, int, UCHAR*);
 	int raw_read(int, FPGASELECT);
@@ -88,9 +123,51 @@ public:
 private:
 	APSRack(const APSRack&) = delete;
 	APSRack& operator=(const APSRack&) = delete;
-	int numDevices_;
-	vector<APS> APSs_;
-	vector<string> deviceSerials_;
+
+	//An attached unit and the lock held for every call into it
+	struct Device {
+		Device(const int & deviceID, const string & deviceSerial) : aps(deviceID, deviceSerial) {};
+		APS aps;
+		std::mutex lock;
+	};
+
+	//Snapshot of the attached units; never modified once published
+	struct DeviceTable {
+		vector<string> serials;
+		map<string, int> serial2dev;
+		vector<std::shared_ptr<Device>> devices;
+	};
+
+	std::atomic<const DeviceTable *> devices_;
+	//Every table published so far; guarded by enumMutex_ which also serializes re-enumeration
+	vector<std::unique_ptr<const DeviceTable>> tables_;
+	std::mutex enumMutex_;
+
+	const DeviceTable & device_table() const {return *devices_.load(std::memory_order_acquire);};
+	void publish(DeviceTable *);
+	Device * find_device(const int &) const;
+
+	//Run op on a device with its lock held; returns invalid for an unknown device ID
+	template <typename R, typename F>
+	R with_device(const int & deviceID, const R & invalid, F op) const{
+		Device * device = find_device(deviceID);
+		if (device == nullptr){
+			return invalid;
+		}
+		std::lock_guard<std::mutex> lock(device->lock);
+		return op(device->aps);
+	}
+
+	//Async workers keyed by serial so queued operations stay with the unit they were submitted for
+	//across re-enumeration; created on first use
+	map<string, std::unique_ptr<AsyncWorker>> asyncWorkers_;
+	map<int, std::shared_future<int>> asyncOps_;
+	int nextOpID_;
+	std::mutex asyncMutex_;
+	std::shared_future<int> find_op(const int &);
+	//Whether cleanup has stopped every library thread since the last init
+	bool cleanedUp_;
+	void prune_async_ops();
 };
 
 
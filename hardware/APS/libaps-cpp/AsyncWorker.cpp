@@ -0,0 +1,46 @@
+/*
+ * AsyncWorker.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "AsyncWorker.h"
+
+AsyncWorker::AsyncWorker() {}
+
+AsyncWorker::~AsyncWorker() {
+	//Let the current operation finish; anything still queued is dropped and its future reports a broken promise
+	//APSRack only destroys workers from cleanup, never while the library is unloading
+	stop();
+}
+
+std::shared_future<int> AsyncWorker::submit(std::function<int()> op){
+	std::packaged_task<int()> job(op);
+	std::shared_future<int> result = job.get_future().share();
+	{
+		std::lock_guard<std::mutex> lock(jobMutex_);
+		jobs_.push_back(std::move(job));
+		if (!isRunning()){
+			start();
+		}
+	}
+	jobAdded_.notify_one();
+	return result;
+}
+
+void AsyncWorker::run(){
+	//Wake up regularly to check whether we have been stopped
+	const std::chrono::milliseconds checkInterval(100);
+	while (running_) {
+		std::packaged_task<int()> job;
+		{
+			std::unique_lock<std::mutex> lock(jobMutex_);
+			if (!jobAdded_.wait_for(lock, checkInterval, [this](){ return !jobs_.empty(); })){
+				continue;
+			}
+			job = std::move(jobs_.front());
+			jobs_.pop_front();
+		}
+		job();
+	}
+}
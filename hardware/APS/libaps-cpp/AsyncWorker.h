@@ -0,0 +1,39 @@
+/*
+ * AsyncWorker.h
+ *
+ * A background thread that runs queued device operations in order.
+ * APSRack keeps one per device so the async C API calls on a device are serialized
+ * while calls on different devices (and the caller's own thread) carry on in parallel.
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "headings.h"
+
+#ifndef ASYNCWORKER_H_
+#define ASYNCWORKER_H_
+
+#include <condition_variable>
+
+class AsyncWorker : public Runnable
+{
+public:
+	AsyncWorker();
+	~AsyncWorker();
+
+	//Queue an operation; the future becomes ready with its return code (or exception) once it has run
+	std::shared_future<int> submit(std::function<int()>);
+
+protected:
+	void run();
+
+private:
+	AsyncWorker(const AsyncWorker&) = delete;
+	AsyncWorker& operator=(const AsyncWorker&) = delete;
+
+	std::deque<std::packaged_task<int()>> jobs_;
+	std::mutex jobMutex_;
+	std::condition_variable jobAdded_;
+};
+
+#endif /* ASYNCWORKER_H_ */
@@ -66,17 +66,23 @@ private:
 };
 
 
+//A single streaming scheduler per APS unit
+//Polls all the streaming FPGAs in one batched read and packs their refills into one USB transfer
 class BankBouncerThread : public Runnable
 {
 public:
-	BankBouncerThread() : channel_(), myAPS_() {};
-	BankBouncerThread(int ch, APS * aps) : channel_{ch}, myAPS_{aps} {};
+	BankBouncerThread() : switchRequested{false}, myAPS_() {};
+	BankBouncerThread(APS * aps) : switchRequested{false}, myAPS_{aps} {};
+
+	//Which FPGAs need streaming; must be set before start()
+	vector<FPGASELECT> fpgas;
+	//Set to switch over to the staged sequence at the next miniLL boundary; cleared once the new sequence is playing
+	std::atomic<bool> switchRequested;
 
 protected:
 	void run();
 
 private:
-	int channel_;
     APS * myAPS_;
 };
 
@@ -76,6 +76,51 @@ int Channel::set_waveform(const vector<short> & data) {
 	return 0;
 }
 
+int Channel::set_waveform(const void * data, const size_t & numPts, const ptrdiff_t & stride, const ELEMENT_TYPE & type, vector<short> & prepVec) {
+	/*
+	 * Strided, typed waveform ingestion
+	 * Fills the waveform library and the scaled, clipped device data (as prep_waveform would) in a single pass
+	 * int16 data is in DAC units (-8191, 8191); float data is normalized (-1, 1)
+	 */
+	if (numPts > size_t(MAX_WF_LENGTH)){
+		FILE_LOG(logERROR) << "Tried to update waveform to longer than max allowed: " << numPts;
+		return -1;
+	}
+	//Reject an unknown type before touching the current waveform
+	if (type != ELEMENT_INT16 && type != ELEMENT_FLOAT32 && type != ELEMENT_FLOAT64){
+		FILE_LOG(logERROR) << "Unknown element type " << type;
+		return -1;
+	}
+	const float normalization = (type == ELEMENT_INT16) ? 1.0f/MAX_WF_AMP : 1.0f;
+	size_t paddedLength = size_t(WF_MODULUS*ceil(float(numPts)/WF_MODULUS));
+	waveform_.assign(paddedLength, 0);
+	prepVec.resize(paddedLength);
+
+	size_t numClipped = 0;
+	auto prep = [&](const float & val) -> short {
+		float scaled = MAX_WF_AMP*(scale_*val+offset_);
+		if (scaled > MAX_WF_AMP || scaled < -MAX_WF_AMP){
+			numClipped++;
+			return (scaled > 0) ? MAX_WF_AMP : -MAX_WF_AMP;
+		}
+		return short(scaled);
+	};
+	int status = for_each_strided(data, numPts, stride, type, [&](const size_t & ct, const float & val){
+		waveform_[ct] = val*normalization;
+		prepVec[ct] = prep(waveform_[ct]);
+	});
+	if (status != 0){
+		return status;
+	}
+	for (size_t ct = numPts; ct < paddedLength; ct++){
+		prepVec[ct] = prep(0);
+	}
+	if (numClipped > 0){
+		FILE_LOG(logWARNING) << "Clipped " << numClipped << " waveform elements to the DAC range";
+	}
+	return 0;
+}
+
 vector<short> Channel::prep_waveform() const{
 	//Apply the scale,offset and covert to integer format
 	vector<short> prepVec(waveform_.size());
@@ -117,62 +162,54 @@ int Channel::write_state_to_hdf5(H5::H5File & H5StateFile, const string & rootSt
 
 	element2h5attribute<float>("offset",  offset_,    &tmpGroup, H5::PredType::NATIVE_FLOAT);
 	element2h5attribute<float>("scale",   scale_,     &tmpGroup, H5::PredType::NATIVE_FLOAT);
-	element2h5attribute<bool>("enabled",  enabled_,   &tmpGroup, H5::PredType::NATIVE_UINT);
+	//NATIVE_UINT is wider than a bool so go through an unsigned
+	unsigned int enabled = enabled_;
+	element2h5attribute<unsigned int>("enabled",  enabled,   &tmpGroup, H5::PredType::NATIVE_UINT);
 	element2h5attribute<int>("trigDelay", trigDelay_, &tmpGroup, H5::PredType::NATIVE_INT);
 
 	tmpGroup.close();
 
 	//Save the linklist data
-
-	// save number of banks to rootStr + /linkListData attribute "numBanks"
-//	USHORT numBanks;
-//	numBanks = banks_.size();//get number of banks from channel
-//
-//	// set attribute
-//	FILE_LOG(logDEBUG) << "Creating Group: " << rootStr + "/linkListData";
-//	tmpGroup = H5StateFile.createGroup(rootStr + "/linkListData");
-//	element2h5attribute<USHORT>("numBanks",  numBanks, &tmpGroup,H5::PredType::NATIVE_UINT16);
-//	tmpGroup.close();
-//
-//	std::ostringstream tmpStream;
-//	//Now loop over the number of banks found and add the bank
-//	for (USHORT bankct=0; bankct<numBanks; bankct++) {
-//		tmpStream.str("");
-//		tmpStream << rootStr << "/linkListData/bank" << bankct+1 ;
-//		FILE_LOG(logDEBUG) << "Writing State Bank: " << bankct+1 << " from hdf5";
-//		banks_[bankct].write_state_to_hdf5(H5StateFile, tmpStream.str() );
-//	}
+	FILE_LOG(logDEBUG) << "Creating Group: " << rootStr + "/linkListData";
+	tmpGroup = H5StateFile.createGroup(rootStr + "/linkListData");
+	USHORT isIQMode = LLBank_.IQMode;
+	element2h5attribute<USHORT>("isIQMode", isIQMode, &tmpGroup, H5::PredType::NATIVE_UINT16);
+	tmpGroup.close();
+	if (LLBank_.write_state_to_hdf5(H5StateFile, rootStr + "/linkListData") != 0){
+		FILE_LOG(logERROR) << "Could not save the LL for " << rootStr;
+		return -1;
+	}
 	return 0;
 }
 
 int Channel::read_state_from_hdf5(H5::H5File & H5StateFile, const string & rootStr){
 	clear_data();
 	// read waveform data
-	waveform_ = h5array2vector<float>(&H5StateFile, rootStr + "/waveformLib",   H5::PredType::NATIVE_INT16);
+	waveform_ = h5array2vector<float>(&H5StateFile, rootStr + "/waveformLib",   H5::PredType::NATIVE_FLOAT);
 
 	// load state information
 	H5::Group tmpGroup = H5StateFile.openGroup(rootStr);
 	offset_    = h5element2element<float>("offset",&tmpGroup, H5::PredType::NATIVE_FLOAT);
 	scale_     = h5element2element<float>("scale",&tmpGroup, H5::PredType::NATIVE_FLOAT);
-	enabled_   = h5element2element<bool>("enabled",&tmpGroup, H5::PredType::NATIVE_UINT);
+	enabled_   = h5element2element<unsigned int>("enabled",&tmpGroup, H5::PredType::NATIVE_UINT);
 	trigDelay_ = h5element2element<int>("trigDelay",&tmpGroup, H5::PredType::NATIVE_INT);
+	tmpGroup.close();
 
-	//Load the linklist data
-	//First figure our how many banks there are from the attribute
-	tmpGroup = H5StateFile.openGroup(rootStr + "/linkListData");
-	USHORT numBanks;
-	numBanks = h5element2element<USHORT>("numBanks",&tmpGroup, H5::PredType::NATIVE_UINT16);
-  tmpGroup.close();
-
-	std::ostringstream tmpStream;
-	//Now loop over the number of banks found and add the bank
-	for (USHORT bankct=0; bankct<numBanks; bankct++){
-		LLBank bank;
-		tmpStream.str(rootStr);
-		tmpStream << "/linkListData/bank" << bankct+1;
-		FILE_LOG(logDEBUG) << "Reading State Bank: " << bankct+1 << " from hdf5";
-		bank.read_state_from_hdf5( H5StateFile, tmpStream.str());
-//		banks_.push_back(bank);
+	//Every state file saves the linklist data of every channel, even an empty one
+	string LLStr = rootStr + "/linkListData";
+	if (H5Lexists(H5StateFile.getId(), LLStr.c_str(), H5P_DEFAULT) <= 0){
+		FILE_LOG(logERROR) << "No LL data in state file for " << rootStr;
+		return -1;
 	}
-	return 0;
+	tmpGroup = H5StateFile.openGroup(LLStr);
+	if (!tmpGroup.attrExists("isIQMode")){
+		//Older state files only have a bank count here
+		FILE_LOG(logERROR) << "LL data in state file for " << rootStr << " is in the old multi-bank format";
+		tmpGroup.close();
+		return -1;
+	}
+	LLBank_.IQMode = h5element2element<USHORT>("isIQMode", &tmpGroup, H5::PredType::NATIVE_UINT16);
+	tmpGroup.close();
+	FILE_LOG(logDEBUG) << "Reading LL state from hdf5";
+	return LLBank_.read_state_from_hdf5(H5StateFile, LLStr);
 }
@@ -26,6 +26,7 @@ public:
 
 	int set_waveform(const vector<float> &);
 	int set_waveform(const vector<short> &);
+	int set_waveform(const void *, const size_t &, const ptrdiff_t &, const ELEMENT_TYPE &, vector<short> &);
 	vector<short> prep_waveform() const;
 
 	int clear_data();
@@ -0,0 +1,151 @@
+/*
+ * CompiledSequence.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "CompiledSequence.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+uint32_t CompiledSequence::crc32(const UCHAR * data, const size_t & numBytes){
+	//Standard reflected CRC-32 (polynomial 0xEDB88320)
+	static uint32_t table[256];
+	static std::once_flag tableFlag;
+	std::call_once(tableFlag, [](){
+		for (uint32_t ct = 0; ct < 256; ct++){
+			uint32_t crc = ct;
+			for (int bitct = 0; bitct < 8; bitct++){
+				crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : (crc >> 1);
+			}
+			table[ct] = crc;
+		}
+	});
+	uint32_t crc = 0xFFFFFFFF;
+	for (size_t ct = 0; ct < numBytes; ct++){
+		crc = table[(crc ^ data[ct]) & 0xFF] ^ (crc >> 8);
+	}
+	return crc ^ 0xFFFFFFFF;
+}
+
+void CompiledSequence::WireImage::append_write(const FPGASELECT & fpga, const unsigned int & addr, const WordVec & data){
+	//Same packing and checksum bookkeeping as a queued APS::write
+	vector<UCHAR> dataPacket = FPGA::format(fpga, addr, data);
+	for (auto tmpOffset : FPGA::computeCmdByteOffsets(data.size())){
+		cmdOffsets.push_back(tmpOffset + bytes.size());
+	}
+	bytes.insert(bytes.end(), dataPacket.begin(), dataPacket.end());
+	checksum.address += addr & 0xFFFF;
+	for (auto tmpData : data){
+		checksum.data += tmpData;
+	}
+}
+
+vector<uint64_t> CompiledSequence::WireImage::chunk_ends() const{
+	//FT_Write breaks with writes longer than 64kB so split at the last command byte that fits
+	const size_t maxWriteLength = 65536;
+	vector<uint64_t> ends;
+	size_t chunkStart = 0;
+	while (chunkStart < bytes.size()){
+		if (bytes.size() - chunkStart > maxWriteLength){
+			auto breakPt = std::upper_bound(cmdOffsets.begin(), cmdOffsets.end(), chunkStart + maxWriteLength);
+			chunkStart = *(breakPt-1);
+		}
+		else{
+			chunkStart = bytes.size();
+		}
+		ends.push_back(chunkStart);
+	}
+	return ends;
+}
+
+#ifdef _WIN32
+
+CompiledSequence::MappedFile::MappedFile(const string & fileName) : data(nullptr), size(0), file_(INVALID_HANDLE_VALUE), mapping_(NULL) {
+	file_ = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file_ == INVALID_HANDLE_VALUE){
+		return;
+	}
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(file_, &fileSize);
+	mapping_ = CreateFileMapping(file_, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping_ == NULL){
+		return;
+	}
+	data = static_cast<const UCHAR *>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+	if (data != nullptr){
+		size = fileSize.QuadPart;
+	}
+}
+
+CompiledSequence::MappedFile::~MappedFile(){
+	if (data != nullptr) UnmapViewOfFile(data);
+	if (mapping_ != NULL) CloseHandle(mapping_);
+	if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+}
+
+#else
+
+CompiledSequence::MappedFile::MappedFile(const string & fileName) : data(nullptr), size(0), fd_(-1) {
+	fd_ = open(fileName.c_str(), O_RDONLY);
+	if (fd_ < 0){
+		return;
+	}
+	struct stat fileStat;
+	if (fstat(fd_, &fileStat) != 0 || fileStat.st_size == 0){
+		return;
+	}
+	void * mapped = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_SHARED, fd_, 0);
+	if (mapped == MAP_FAILED){
+		return;
+	}
+	data = static_cast<const UCHAR *>(mapped);
+	size = fileStat.st_size;
+	//We read straight through the file once
+	madvise(mapped, size, MADV_SEQUENTIAL);
+}
+
+CompiledSequence::MappedFile::~MappedFile(){
+	if (data != nullptr) munmap(const_cast<UCHAR *>(data), size);
+	if (fd_ >= 0) close(fd_);
+}
+
+#endif
+
+const CompiledSequence::Header * CompiledSequence::validate(const MappedFile & file){
+	/*
+	 * Check the header and every section of a mapped compiled sequence
+	 * Returns the header or nullptr if the file is not usable
+	 */
+	if (file.data == nullptr || file.size < sizeof(Header)){
+		FILE_LOG(logERROR) << "Compiled sequence file is missing or too short";
+		return nullptr;
+	}
+	const Header * header = reinterpret_cast<const Header *>(file.data);
+	if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->byteOrderMark != BYTE_ORDER_MARK){
+		FILE_LOG(logERROR) << "Not a compiled sequence file for this host";
+		return nullptr;
+	}
+	if (header->version != VERSION){
+		FILE_LOG(logERROR) << "Compiled sequence version " << header->version << " is not supported; recompile the sequence";
+		return nullptr;
+	}
+	if (header->fileSize != file.size || crc32(file.data, offsetof(Header, headerCRC)) != header->headerCRC){
+		FILE_LOG(logERROR) << "Compiled sequence header is corrupt";
+		return nullptr;
+	}
+	for (const ChannelHeader & chan : header->channels){
+		for (const Section * section : {&chan.samples, &chan.wfImage, &chan.wfChunks, &chan.LLArrays, &chan.LLPacked, &chan.miniLLs, &chan.LLImage, &chan.LLChunks}){
+			if (section->offset + section->size > file.size || section->offset % 8 != 0 ||
+					crc32(file.data + section->offset, section->size) != section->crc){
+				FILE_LOG(logERROR) << "Compiled sequence section at " << section->offset << " is corrupt";
+				return nullptr;
+			}
+		}
+	}
+	return header;
+}
@@ -0,0 +1,128 @@
+/*
+ * CompiledSequence.h
+ *
+ * A binary sequence format that can be memory mapped and sent straight to the device.
+ * APS::compile_sequence_file does the HDF5 parsing, miniLL folding and FPGA formatting once
+ * and stores the results; APS::load_compiled_sequence maps the file and writes the wire
+ * images without touching individual elements.
+ *
+ * Layout: a CompiledSeqHeader at the start of the file followed by 8 byte aligned sections.
+ * Everything is stored in host byte order; the byte order mark catches files from another host.
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "headings.h"
+
+#ifndef COMPILEDSEQUENCE_H_
+#define COMPILEDSEQUENCE_H_
+
+#include <cstddef>
+#include <cstring>
+
+namespace CompiledSequence {
+
+static const char MAGIC[8] = {'A', 'P', 'S', 'C', 'S', 'E', 'Q', '\0'};
+static const uint32_t VERSION = 1;
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+//Channel flags
+static const uint32_t HAS_LL = 0x1;
+static const uint32_t IQ_MODE = 0x2;
+
+//A contiguous chunk of the file with its own CRC32
+struct Section {
+	uint64_t offset;
+	uint64_t size;
+	uint32_t crc;
+	uint32_t reserved;
+};
+
+struct ChannelHeader {
+	uint32_t flags;
+	uint32_t reserved;
+	//Waveform length in samples (padded to WF_MODULUS) and LL length in entries
+	uint64_t numSamples;
+	uint64_t LLLength;
+	uint64_t numMiniLLs;
+	//int16 waveform library as stored in the sequence file
+	Section samples;
+	//FT_Write bytes for the waveform length register and data, unscaled and at the bottom of memory
+	Section wfImage;
+	//uint64 end offsets of <= 64kB FT_Write chunks through wfImage, split on command bytes
+	Section wfChunks;
+	//uint16 addr, count, trigger1, trigger2, repeat arrays of LLLength each
+	Section LLArrays;
+	//uint16 packed LL words as streamed to the device
+	Section LLPacked;
+	//uint64 miniLL start indices followed by uint64 miniLL lengths
+	Section miniLLs;
+	//FT_Write bytes for the LL data and length register; empty when the LL has to be streamed
+	Section LLImage;
+	Section LLChunks;
+	//Software checksum contributions of the two images
+	CheckSum wfChecksum;
+	CheckSum LLChecksum;
+};
+
+struct Header {
+	char magic[8];
+	uint32_t version;
+	uint32_t byteOrderMark;
+	uint64_t fileSize;
+	USHORT miniLLRepeat;
+	USHORT reserved[3];
+	ChannelHeader channels[4];
+	//CRC32 of everything in the header before this field
+	uint32_t headerCRC;
+	uint32_t reserved2;
+};
+
+uint32_t crc32(const UCHAR *, const size_t &);
+
+//Builds up an FT_Write image the same way APS::write queues writes
+struct WireImage {
+	vector<UCHAR> bytes;
+	vector<size_t> cmdOffsets;
+	CheckSum checksum;
+
+	WireImage() : checksum{0, 0} {};
+	void append_write(const FPGASELECT &, const unsigned int &, const WordVec &);
+	vector<uint64_t> chunk_ends() const;
+};
+
+//Read-only memory map of a whole file
+class MappedFile {
+public:
+	MappedFile(const string &);
+	~MappedFile();
+
+	const UCHAR * data;
+	size_t size;
+
+private:
+	MappedFile(const MappedFile &) = delete;
+	MappedFile & operator=(const MappedFile &) = delete;
+#ifdef _WIN32
+	HANDLE file_;
+	HANDLE mapping_;
+#else
+	int fd_;
+#endif
+};
+
+const Header * validate(const MappedFile &);
+
+template <typename T>
+const T * section_data(const MappedFile & file, const Section & section){
+	return reinterpret_cast<const T *>(file.data + section.offset);
+}
+
+template <typename T>
+size_t section_length(const Section & section){
+	return section.size / sizeof(T);
+}
+
+} //end namespace CompiledSequence
+
+#endif /* COMPILEDSEQUENCE_H_ */
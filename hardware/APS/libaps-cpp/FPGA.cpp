@@ -324,10 +324,11 @@ int FPGA::write_register(
 USHORT FPGA::read_FPGA(FT_HANDLE deviceHandle, const ULONG & addr, FPGASELECT chipSelect)
 {
 
+	PerfStats::Timer timer(PERF_READ_FPGA);
 	if (chipSelect == ALL_FPGAS) chipSelect = FPGA1; // can only read from one FPGA at a time, assume we want data from FPGA 1
 
 	//Write the address with the read bit high
-	write_FPGA(deviceHandle, FPGA_ADDR_REGREAD | addr, vector<USHORT>(0), chipSelect );
+	timer.add_bytes(write_FPGA(deviceHandle, FPGA_ADDR_REGREAD | addr, vector<USHORT>(0), chipSelect ));
 
 	//Now clock out the data by writing a read command byte
 	// Start all packets with a APS Command Byte with the R/W = 1 for read for 2 bytes
@@ -349,6 +350,8 @@ USHORT FPGA::read_FPGA(FT_HANDLE deviceHandle, const ULONG & addr, FPGASELECT ch
 	if (!FT_SUCCESS(ftStatus) || bytesRead != 2){
 		FILE_LOG(logDEBUG2) << "FPGA::read_register: Error reading from USB with status = " << ftStatus << "; bytes read = " << bytesRead;
 	}
+	timer.add_transfers(3, 1);
+	timer.add_bytes(bytesWritten + bytesRead);
 
 	USHORT data = (readData[0] << 8) | readData[1];
 
@@ -357,6 +360,47 @@ USHORT FPGA::read_FPGA(FT_HANDLE deviceHandle, const ULONG & addr, FPGASELECT ch
 	return data;
 }
 
+WordVec FPGA::read_FPGA(FT_HANDLE deviceHandle, const ULONG & addr, const vector<FPGASELECT> & chipSelects)
+/*
+ * Read the same register from several FPGAs in a single USB round trip.
+ * The address and read command bytes for each FPGA are packed into one write
+ * and the data for all of them is clocked back with one read.
+ */
+{
+	PerfStats::Timer timer(PERF_READ_FPGA);
+	vector<UCHAR> commandPacket;
+	for (auto chipSelect : chipSelects) {
+		//Write the address with the read bit high followed by the 2 byte read command
+		vector<UCHAR> addrPacket = format(chipSelect, FPGA_ADDR_REGREAD | addr, vector<USHORT>(0));
+		commandPacket.insert(commandPacket.end(), addrPacket.begin(), addrPacket.end());
+		commandPacket.push_back(0x80 | APS_FPGA_IO | (chipSelect<<2) | 1);
+	}
+
+	DWORD bytesWritten, bytesRead;
+	FT_STATUS ftStatus;
+	ftStatus = FT_Write(deviceHandle, &commandPacket[0], commandPacket.size(), &bytesWritten);
+	if (!FT_SUCCESS(ftStatus) || bytesWritten != commandPacket.size()){
+		FILE_LOG(logDEBUG2) << "FPGA::read_FPGA: Error writing to USB with status = " << ftStatus << "; bytes written = " << bytesWritten;
+	}
+
+	//Put some data to make sure they're updated
+	vector<UCHAR> readData(2*chipSelects.size(), 0xBA);
+	ftStatus = FT_Read(deviceHandle, &readData[0], readData.size(), &bytesRead);
+	if (!FT_SUCCESS(ftStatus) || bytesRead != readData.size()){
+		FILE_LOG(logDEBUG2) << "FPGA::read_FPGA: Error reading from USB with status = " << ftStatus << "; bytes read = " << bytesRead;
+	}
+	timer.add_transfers(2, 1);
+	timer.add_bytes(bytesWritten + bytesRead);
+
+	WordVec data(chipSelects.size());
+	for (size_t ct = 0; ct < chipSelects.size(); ct++) {
+		data[ct] = (readData[2*ct] << 8) | readData[2*ct+1];
+		FILE_LOG(logDEBUG2) << "Reading address " << myhex << addr << " on FPGA " << chipSelects[ct] << " with data " << data[ct];
+	}
+
+	return data;
+}
+
 int FPGA::write_FPGA(FT_HANDLE deviceHandle, const unsigned int & addr, const USHORT & data, const FPGASELECT & fpga){
 	//Create a vector and pass on
 	return write_FPGA(deviceHandle, addr, vector<USHORT>(1, data), fpga );
@@ -426,6 +470,7 @@ int FPGA::write_FPGA(FT_HANDLE deviceHandle, const unsigned int & addr, const ve
 }
 
 int FPGA::write_block(FT_HANDLE deviceHandle, vector<UCHAR> & dataPackets, const vector<size_t> & offsets){
+	PerfStats::Timer timer(PERF_WRITE_BLOCK);
 
 	// seems to break with writes longer than 64kB so split on that
 	ULONG bytesWritten=0, tmpBytesWritten=0;
@@ -434,18 +479,39 @@ int FPGA::write_block(FT_HANDLE deviceHandle, vector<UCHAR> & dataPackets, const
 	while (std::distance(curIdx, dataPackets.end()) > 0){
 		if (std::distance(curIdx,dataPackets.end()) > maxWriteLength){
 			//Find the last command byte where the data packet will fit under 64kB.
-			auto breakPt = std::lower_bound(offsets.begin(), offsets.end(), std::distance(curIdx,dataPackets.begin()) + maxWriteLength);
-			DWORD ptsToWrite = *(breakPt-1) - std::distance(curIdx,dataPackets.begin());
+			auto breakPt = std::upper_bound(offsets.begin(), offsets.end(), std::distance(dataPackets.begin(), curIdx) + maxWriteLength);
+			DWORD ptsToWrite = *(breakPt-1) - std::distance(dataPackets.begin(), curIdx);
 			FT_Write(deviceHandle, &(*curIdx), ptsToWrite, &tmpBytesWritten);
+			timer.add_transfers(1);
 			bytesWritten += tmpBytesWritten;
 			std::advance(curIdx, ptsToWrite);
 		}
 		else{
 			FT_Write(deviceHandle, &(*curIdx), std::distance(curIdx,dataPackets.end()), &tmpBytesWritten);
+			timer.add_transfers(1);
 			bytesWritten += tmpBytesWritten;
 			curIdx = dataPackets.end();
 		}
 	}
+	timer.add_bytes(bytesWritten);
+	return(bytesWritten);
+}
+
+int FPGA::write_image(FT_HANDLE deviceHandle, const UCHAR * image, const uint64_t * chunkEnds, const size_t & numChunks){
+	/*
+	 * Write a pre-formatted block of FPGA commands in chunks already split on command bytes
+	 * chunkEnds are the byte offsets into image where each chunk stops
+	 */
+	PerfStats::Timer timer(PERF_WRITE_IMAGE);
+	ULONG bytesWritten=0, tmpBytesWritten=0;
+	uint64_t chunkStart = 0;
+	for (size_t chunkct = 0; chunkct < numChunks; chunkct++){
+		FT_Write(deviceHandle, const_cast<UCHAR *>(image + chunkStart), chunkEnds[chunkct] - chunkStart, &tmpBytesWritten);
+		bytesWritten += tmpBytesWritten;
+		chunkStart = chunkEnds[chunkct];
+	}
+	timer.add_transfers(numChunks);
+	timer.add_bytes(bytesWritten);
 	return(bytesWritten);
 }
 
@@ -567,6 +633,21 @@ vector<size_t> FPGA::computeCmdByteOffsets(const size_t & dataLength){
 	return offsets;
 }
 
+vector<UCHAR> FPGA::serialize_SPI(const UCHAR & command, const vector<UCHAR> & byteBuffer){
+/* Helper function to build an SPI packet: the command byte followed by the data serialized
+ * MS bit first into bit 0 of the packet bytes
+ */
+	vector<UCHAR> dataPacket(1 + 8*byteBuffer.size());
+	dataPacket[0] = command;
+	vector<UCHAR>::iterator packetIt = dataPacket.begin() + 1;
+	for (const UCHAR & dataByte : byteBuffer){
+		for (int bitct = 7; bitct >= 0; bitct--){
+			*packetIt++ = (dataByte >> bitct) & 1;
+		}
+	}
+	return dataPacket;
+}
+
 int FPGA::write_SPI
 (
 		FT_HANDLE deviceHandle,
@@ -604,6 +685,7 @@ int FPGA::write_SPI
  *
  ********************************************************************/
 {
+	PerfStats::Timer timer(PERF_WRITE_SPI);
 	FT_STATUS ftStatus;
 	vector<UCHAR> dataPacket(0);
 	DWORD bytesWritten;
@@ -632,14 +714,12 @@ int FPGA::write_SPI
 
 	// Start all packets with a APS Command Byte with the R/W= 0 for write
 	// Note that command byte from DAC has the SEL bits for the desired DAC set
-	dataPacket.push_back(Command);
-
-	// Serialize the data into bit 0 of the packet bytes
-	for(size_t ct = 0; ct < 8*byteBuffer.size(); ct++)
-		dataPacket.push_back( (byteBuffer[ct/8]>>(7-(ct%8))) & 1 );
+	dataPacket = serialize_SPI(Command, byteBuffer);
 
 	ftStatus = FT_Write(deviceHandle, &dataPacket[0], dataPacket.size(), &bytesWritten);
 	if (!FT_SUCCESS(ftStatus)) {FILE_LOG(logERROR) << "Write SPI command failed";}
+	timer.add_transfers(1);
+	timer.add_bytes(bytesWritten);
 
 	return bytesWritten;
 }
@@ -654,6 +734,7 @@ int FPGA::read_SPI
 )
 
 {
+	PerfStats::Timer timer(PERF_READ_SPI);
 	FT_STATUS ftStatus;
 	vector<UCHAR> dataPacket(0);
 	DWORD bytesWritten, bytesRead;
@@ -681,11 +762,7 @@ int FPGA::read_SPI
 
 	// Start all packets with a APS Command Byte with the R/W= 0 for write
 	// Note that command byte from DAC has the SEL bits for the desired DAC set
-	dataPacket.push_back(Command);
-
-	// Serialize the data into bit 0 of the packet bytes
-	for(size_t ct = 0; ct < 8*byteBuffer.size(); ct++)
-		dataPacket.push_back( (byteBuffer[ct/8]>>(7-(ct%8))) & 1 );
+	dataPacket = serialize_SPI(Command, byteBuffer);
 
 
 	// Write the SPI command.  This stores the last 8 SPI read bits in the I/O FPGA SerData register
@@ -702,6 +779,8 @@ int FPGA::read_SPI
 	// Read the one byte of serial data from the SerData register
 	ftStatus = FT_Read(deviceHandle, Data, 1, &bytesRead);
 	if (!FT_SUCCESS(ftStatus)) {FILE_LOG(logERROR) << "Read SPI command failed";}
+	timer.add_transfers(3, 1);
+	timer.add_bytes(dataPacket.size() + 1 + bytesRead);
 
 	return(bytesRead);
 
@@ -738,7 +817,7 @@ int FPGA::clear_bit(FT_HANDLE deviceHandle, const FPGASELECT & fpga, const int &
 
 	FPGA::write_FPGA(deviceHandle, addr, currentState & ~mask, fpga);
 
-	if (FILELog::ReportingLevel() >= logDEBUG2) {
+	if (FILE_LOG_ENABLED(logDEBUG2)) {
 		// verify write
 		check_cur_state();
 	}
@@ -776,7 +855,7 @@ int FPGA::set_bit(FT_HANDLE deviceHandle, const FPGASELECT & fpga, const int & a
 
 	FPGA::write_FPGA(deviceHandle, addr, currentState | mask, fpga);
 
-	if (FILELog::ReportingLevel() >= logDEBUG2) {
+	if (FILE_LOG_ENABLED(logDEBUG2)) {
 		// verify write
 		check_cur_state();
 		if ((currentState & mask) == 0) {
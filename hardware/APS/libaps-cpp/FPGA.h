@@ -28,14 +28,17 @@ int clear_bit(FT_HANDLE, const FPGASELECT &, const int &, const int &);
 int set_bit(FT_HANDLE, const FPGASELECT &, const int &, const int &);
 
 USHORT read_FPGA(FT_HANDLE, const ULONG &, FPGASELECT);
+WordVec read_FPGA(FT_HANDLE, const ULONG &, const vector<FPGASELECT> &);
 
 int write_FPGA(FT_HANDLE, const unsigned int &, const USHORT &, const FPGASELECT &);
 int write_FPGA(FT_HANDLE, const unsigned int &, const WordVec &, const FPGASELECT &);
 int write_FPGA(FT_HANDLE, const unsigned int &, const WordVec &, const FPGASELECT &, map<FPGASELECT, CheckSum> &);
 
 int write_block(FT_HANDLE, vector<UCHAR> &, const vector<size_t> &);
+int write_image(FT_HANDLE, const UCHAR *, const uint64_t *, const size_t &);
 vector<UCHAR> format(const FPGASELECT &, const unsigned int &, const WordVec &);
 vector<size_t> computeCmdByteOffsets(const size_t &);
+vector<UCHAR> serialize_SPI(const UCHAR &, const vector<UCHAR> &);
 
 } //end namespace FPGA
 
@@ -7,17 +7,40 @@
 
 #include "LLBank.h"
 
-LLBank::LLBank() : length{0}, addr_(0), count_(0), repeat_(0),trigger1_(0), trigger2_(0) {
+#include <cstring>
+
+size_t LLBank::parallelThreshold = LL_PARALLEL_THRESHOLD;
+
+//Split [0, numItems) into contiguous ranges and run func(threadIdx, begin, end) on each
+//The first range runs on the calling thread
+static void parallel_for(const size_t & numItems, const size_t & numThreads, const std::function<void(size_t, size_t, size_t)> & func){
+	size_t rangeSize = (numItems + numThreads - 1) / numThreads;
+	vector<std::thread> workers;
+	for (size_t threadct = 1; threadct < numThreads; threadct++){
+		size_t begin = std::min(numItems, threadct*rangeSize);
+		size_t end = std::min(numItems, begin + rangeSize);
+		workers.emplace_back(func, threadct, begin, end);
+	}
+	func(0, 0, std::min(numItems, rangeSize));
+	for (auto & worker : workers){
+		worker.join();
+	}
+}
+
+LLBank::LLBank() : length{0}, IQMode{false}, diskBacked{false}, numMiniLLs{0}, addr_(0), count_(0), repeat_(0),trigger1_(0), trigger2_(0), maxMiniLLSpan_{0} {
 	// TODO Auto-generated constructor stub
 }
 
-LLBank::LLBank(const WordVec & addr, const WordVec & count, const WordVec & trigger, const WordVec & repeat) :
-		length(addr.size()), IQMode(false), addr_(addr), count_(count), repeat_(repeat), trigger1_(trigger){
+//The arrays are taken by value and moved in so temporaries are never copied
+LLBank::LLBank(WordVec addr, WordVec count, WordVec trigger, WordVec repeat) :
+		length(addr.size()), IQMode(false), diskBacked(false), addr_(std::move(addr)), count_(std::move(count)), repeat_(std::move(repeat)), trigger1_(std::move(trigger)),
+		maxMiniLLSpan_(0){
 	init_data();
 };
 
-LLBank::LLBank(const WordVec & addr, const WordVec & count, const WordVec & trigger1, const WordVec & trigger2, const WordVec & repeat) :
-		length(addr.size()), IQMode(true), addr_(addr), count_(count), repeat_(repeat), trigger1_(trigger1), trigger2_(trigger2){
+LLBank::LLBank(WordVec addr, WordVec count, WordVec trigger1, WordVec trigger2, WordVec repeat) :
+		length(addr.size()), IQMode(true), diskBacked(false), addr_(std::move(addr)), count_(std::move(count)), repeat_(std::move(repeat)),
+		trigger1_(std::move(trigger1)), trigger2_(std::move(trigger2)), maxMiniLLSpan_(0){
 	init_data();
 };
 
@@ -32,40 +55,290 @@ void LLBank::clear(){
 	repeat_.clear();
 	trigger1_.clear();
 	trigger2_.clear();
-	packedData_.clear();
+	blocks_.clear();
+	segStartIdx_.clear();
+	segBlock_.clear();
+	segIsMiniLL_.clear();
 	miniLLStartIdx.clear();
 	miniLLLengths.clear();
+	numMiniLLs = 0;
+	diskBacked = false;
+	diskSource_.reset();
+	miniLLSource_.reset();
+	miniLLWindow_.reset();
+	maxMiniLLSpan_ = 0;
+
+}
 
+void LLBank::copy_packed_data(const size_t & startIdx, const size_t & stopIdx, WordVec & vecOut) const{
+	//Append the packed entries [startIdx, stopIdx) by walking the segments that cover them
+	int lengthMult = IQMode ? 5 : 4;
+	size_t segct = std::distance(segStartIdx_.begin(), std::upper_bound(segStartIdx_.begin(), segStartIdx_.end(), startIdx)) - 1;
+	size_t curIdx = startIdx;
+	while (curIdx < stopIdx){
+		size_t segStart = segStartIdx_[segct];
+		size_t segStop = (segct+1 < segStartIdx_.size()) ? segStartIdx_[segct+1] : length;
+		size_t copyStop = std::min(stopIdx, segStop);
+		const WordVec & block = blocks_[segBlock_[segct]];
+		vecOut.insert(vecOut.end(), block.begin()+lengthMult*(curIdx-segStart), block.begin()+lengthMult*(copyStop-segStart));
+		curIdx = copyStop;
+		segct++;
+	}
 }
 
 WordVec LLBank::get_packed_data(const size_t & startIdx, const size_t & stopIdx){
 	//Pull out packed data starting at startIdx but not inclusive of stopIdx
+	if (diskBacked){
+		return diskSource_->get_packed_data(startIdx, stopIdx);
+	}
 	WordVec vecOut;
 	//If we are in IQ mode then we have an extra word for every entry
 	int lengthMult = IQMode ? 5 : 4;
 	//Handle wrapping around the top of the LL data
 	if (stopIdx < startIdx){
-		vecOut.assign(packedData_.begin()+lengthMult*startIdx, packedData_.end());
-		vecOut.insert(vecOut.end(), packedData_.begin(), packedData_.begin()+lengthMult*stopIdx);
+		vecOut.reserve(lengthMult*(length-startIdx+stopIdx));
+		copy_packed_data(startIdx, length, vecOut);
+		copy_packed_data(0, stopIdx, vecOut);
 	}
 	else{
-		vecOut.assign(packedData_.begin()+lengthMult*startIdx, packedData_.begin()+lengthMult*stopIdx);
+		vecOut.reserve(lengthMult*(stopIdx-startIdx));
+		copy_packed_data(startIdx, stopIdx, vecOut);
 	}
 	return vecOut;
 }
 
+//Words of LLFileSource storage per spooled miniLL start index
+static const size_t MINILL_INDEX_WIDTH = sizeof(uint64_t)/sizeof(USHORT);
+
+size_t LLBank::miniLL_start(const size_t & miniLLIdx) const{
+	//LL index of the first entry of a miniLL
+	if (!diskBacked){
+		return miniLLStartIdx[miniLLIdx];
+	}
+	//Read the spooled index a chunk at a time so walking the miniLLs in order rarely goes back to disk
+	std::lock_guard<std::mutex> lock(miniLLWindow_->mutex);
+	IdxVec & window = miniLLWindow_->startIdx;
+	if (miniLLIdx < miniLLWindow_->first || miniLLIdx >= miniLLWindow_->first + window.size()){
+		size_t first = (miniLLIdx / LL_DISK_CHUNK_LENGTH) * LL_DISK_CHUNK_LENGTH;
+		size_t stop = std::min(numMiniLLs, first + LL_DISK_CHUNK_LENGTH);
+		WordVec words = miniLLSource_->get_packed_data(first, stop);
+		window.resize(stop - first);
+		for (size_t ct = 0; ct < window.size(); ct++){
+			uint64_t startIdx;
+			std::memcpy(&startIdx, words.data() + MINILL_INDEX_WIDTH*ct, sizeof(startIdx));
+			window[ct] = startIdx;
+		}
+		miniLLWindow_->first = first;
+	}
+	return window[miniLLIdx - miniLLWindow_->first];
+}
+
+size_t LLBank::max_miniLL_span() const{
+	//Longest run of entries from the start of a miniLL to the start of the next one (or the end of the LL)
+	return maxMiniLLSpan_;
+}
+
+void LLBank::track_miniLL_spans(IdxVec::const_iterator begin, IdxVec::const_iterator end, size_t & lastStart){
+	//Fold the spans ending at each of the miniLL starts [begin, end) into maxMiniLLSpan_
+	//lastStart carries the previous start between calls and is length before the first one
+	for (auto it = begin; it != end; ++it){
+		if (lastStart != length){
+			maxMiniLLSpan_ = std::max(maxMiniLLSpan_, *it - lastStart);
+		}
+		lastStart = *it;
+	}
+}
+
+void LLBank::close_miniLL_spans(const size_t & lastStart){
+	//The last miniLL runs to the end of the LL
+	if (lastStart != length){
+		maxMiniLLSpan_ = std::max(maxMiniLLSpan_, length - lastStart);
+	}
+}
+
+int LLBank::spool_miniLL_index(){
+	//Move the miniLL start indices found so far out to the index spool file
+	vector<uint64_t> startIdx(miniLLStartIdx.begin(), miniLLStartIdx.end());
+	WordVec words(MINILL_INDEX_WIDTH*startIdx.size());
+	if (!startIdx.empty()){
+		std::memcpy(words.data(), startIdx.data(), startIdx.size()*sizeof(uint64_t));
+		if (miniLLSource_->append(words) != 0){
+			return -1;
+		}
+	}
+	numMiniLLs += startIdx.size();
+	miniLLStartIdx.clear();
+	miniLLLengths.clear();
+	return 0;
+}
+
+bool LLBank::operator==(const LLBank & other) const{
+	//Two banks stream the same words to the device if their packed data match
+	//Disk backed banks are only the same if they share the spool file
+	if (diskBacked || other.diskBacked){
+		return diskSource_ == other.diskSource_;
+	}
+	return (IQMode == other.IQMode) && (segStartIdx_ == other.segStartIdx_) &&
+			(segBlock_ == other.segBlock_) && (blocks_ == other.blocks_);
+}
+
+inline size_t gcd(size_t a, size_t b){
+	while (b != 0){
+		size_t tmp = a % b;
+		a = b;
+		b = tmp;
+	}
+	return a;
+}
+
+size_t LLBank::miniLL_repeat_factor() const{
+	/*
+	 * Find the largest k such that every run of identical consecutive miniLLs has a length
+	 * divisible by k. The LL can then be shortened k times by playing each miniLL k times
+	 * more with the miniLL repeat register. Returns 1 if the LL can't be folded.
+	 */
+	if (diskBacked || segBlock_.empty()){
+		return 1;
+	}
+	size_t factor = 0;
+	size_t runLength = 0;
+	for (size_t segct = 0; segct < segBlock_.size(); segct++){
+		//Entries outside of miniLLs can't be repeated by the hardware
+		if (!segIsMiniLL_[segct]){
+			return 1;
+		}
+		runLength++;
+		if (segct+1 == segBlock_.size() || segBlock_[segct+1] != segBlock_[segct]){
+			factor = gcd(factor, runLength);
+			runLength = 0;
+		}
+	}
+	return factor;
+}
+
+int LLBank::fold_miniLL_repeats(const size_t & factor){
+	//Keep only 1/factor of each run of identical miniLLs
+	if (factor <= 1){
+		return 0;
+	}
+	if (miniLL_repeat_factor() % factor != 0){
+		FILE_LOG(logERROR) << "Can't fold LL bank by " << factor << "; runs of repeated miniLLs are not a multiple of it";
+		return -1;
+	}
+
+	WordVec addr, count, trigger1, trigger2, repeat;
+	auto keep_entries = [&](const size_t & startIdx, const size_t & stopIdx){
+		addr.insert(addr.end(), addr_.begin()+startIdx, addr_.begin()+stopIdx);
+		count.insert(count.end(), count_.begin()+startIdx, count_.begin()+stopIdx);
+		trigger1.insert(trigger1.end(), trigger1_.begin()+startIdx, trigger1_.begin()+stopIdx);
+		if (IQMode){
+			trigger2.insert(trigger2.end(), trigger2_.begin()+startIdx, trigger2_.begin()+stopIdx);
+		}
+		repeat.insert(repeat.end(), repeat_.begin()+startIdx, repeat_.begin()+stopIdx);
+	};
+
+	size_t runLength = 0;
+	size_t runStart = 0;
+	for (size_t segct = 0; segct < segBlock_.size(); segct++){
+		if (runLength == 0){
+			runStart = segct;
+		}
+		runLength++;
+		if (segct+1 == segBlock_.size() || segBlock_[segct+1] != segBlock_[segct]){
+			//Copies in a run are contiguous so keep the first runLength/factor of them
+			size_t keepStop = segStartIdx_[runStart + runLength/factor - 1] + miniLLLengths[runStart + runLength/factor - 1];
+			keep_entries(segStartIdx_[runStart], keepStop);
+			runLength = 0;
+		}
+	}
+
+	FILE_LOG(logINFO) << "Folded LL from " << length << " to " << addr.size() << " entries (miniLL repeat factor " << factor << ")";
+	addr_ = std::move(addr);
+	count_ = std::move(count);
+	trigger1_ = std::move(trigger1);
+	trigger2_ = std::move(trigger2);
+	repeat_ = std::move(repeat);
+	length = addr_.size();
+	init_data();
+	return 0;
+}
+
+int LLBank::rebase_addresses(const int & offset){
+	//Shift every waveform address by offset (in units of WF_MODULUS samples), e.g. to point at the other half of waveform memory
+	if (diskBacked){
+		FILE_LOG(logERROR) << "Cannot rebase the addresses of a disk backed LL";
+		return -1;
+	}
+	for (auto & addr : addr_){
+		addr = static_cast<USHORT>(addr + offset);
+	}
+	init_data();
+	return 0;
+}
+
+WordVec LLBank::raw_data() const{
+	//The addr, count, trigger1, trigger2 and repeat arrays back to back; trigger2 is zero outside IQ mode
+	WordVec rawData;
+	rawData.reserve(5*length);
+	rawData.insert(rawData.end(), addr_.begin(), addr_.end());
+	rawData.insert(rawData.end(), count_.begin(), count_.end());
+	rawData.insert(rawData.end(), trigger1_.begin(), trigger1_.end());
+	if (IQMode){
+		rawData.insert(rawData.end(), trigger2_.begin(), trigger2_.end());
+	}
+	else{
+		rawData.resize(rawData.size() + length, 0);
+	}
+	rawData.insert(rawData.end(), repeat_.begin(), repeat_.end());
+	return rawData;
+}
+
+int LLBank::init_precomputed(const size_t & numEntries, const USHORT * rawData, const USHORT * packedData, const uint64_t * miniLLData, const size_t & miniLLCount){
+	/*
+	 * Set up the bank from a compiled sequence without rescanning or repacking
+	 * rawData is laid out as from raw_data(); miniLLData holds the miniLL start indices followed by their lengths
+	 * IQMode must be set beforehand
+	 */
+	clear();
+	length = numEntries;
+	addr_.assign(rawData, rawData + length);
+	count_.assign(rawData + length, rawData + 2*length);
+	trigger1_.assign(rawData + 2*length, rawData + 3*length);
+	if (IQMode){
+		trigger2_.assign(rawData + 3*length, rawData + 4*length);
+	}
+	repeat_.assign(rawData + 4*length, rawData + 5*length);
+
+	numMiniLLs = miniLLCount;
+	miniLLStartIdx.assign(miniLLData, miniLLData + numMiniLLs);
+	miniLLLengths.assign(miniLLData + numMiniLLs, miniLLData + 2*numMiniLLs);
+	size_t lastStart = length;
+	track_miniLL_spans(miniLLStartIdx.begin(), miniLLStartIdx.end(), lastStart);
+	close_miniLL_spans(lastStart);
+
+	//The whole bank is a single packed block
+	blocks_.assign(1, WordVec(packedData, packedData + (IQMode ? 5 : 4)*length));
+	segStartIdx_.assign(1, 0);
+	segBlock_.assign(1, 0);
+	segIsMiniLL_.assign(1, false);
+	return 0;
+}
+
 int LLBank::write_state_to_hdf5(H5::H5File & H5StateFile, const string & rootStr){
 	H5::Group chanGroup = H5StateFile.openGroup(rootStr);
 	H5::DataType dt = H5::PredType::NATIVE_UINT16;
-	USHORT tmpLength = static_cast<USHORT>(length);
-	element2h5attribute<USHORT>("length", tmpLength, &chanGroup, dt);
+	uint64_t tmpLength = length;
+	element2h5attribute<uint64_t>("length", tmpLength, &chanGroup, H5::PredType::NATIVE_UINT64);
 	chanGroup.close();
-	vector2h5array<USHORT>(addr_,  &H5StateFile, "addr",  rootStr + "/addr",  dt);
-	vector2h5array<USHORT>(count_,   &H5StateFile, "count",   rootStr + "/count",   dt);
-	vector2h5array<USHORT>(repeat_,  &H5StateFile, "repeat",  rootStr + "/repeat",  dt);
-	vector2h5array<USHORT>(trigger1_, &H5StateFile, "trigger1", rootStr + "/trigger1", dt);
+	if (diskBacked){
+		return write_chunked_to_hdf5(H5StateFile, rootStr);
+	}
+	vector2h5array<USHORT>(addr_,  &H5StateFile, rootStr + "/addr",  rootStr + "/addr",  dt);
+	vector2h5array<USHORT>(count_,   &H5StateFile, rootStr + "/count",   rootStr + "/count",   dt);
+	vector2h5array<USHORT>(repeat_,  &H5StateFile, rootStr + "/repeat",  rootStr + "/repeat",  dt);
+	vector2h5array<USHORT>(trigger1_, &H5StateFile, rootStr + "/trigger1", rootStr + "/trigger1", dt);
 	if (IQMode){
-		vector2h5array<USHORT>(trigger2_, &H5StateFile, "trigger2", rootStr + "/trigger2", dt);
+		vector2h5array<USHORT>(trigger2_, &H5StateFile, rootStr + "/trigger2", rootStr + "/trigger2", dt);
 	}
 	return 0;
 }
@@ -73,8 +346,22 @@ int LLBank::write_state_to_hdf5(H5::H5File & H5StateFile, const string & rootStr
 int LLBank::read_state_from_hdf5(H5::H5File & H5StateFile, const string & rootStr){
 	H5::Group chanGroup = H5StateFile.openGroup(rootStr);
 	H5::DataType dt = H5::PredType::NATIVE_UINT16;
-	length = h5element2element<USHORT>("length", &chanGroup, dt);
+	length = h5element2element<uint64_t>("length", &chanGroup, H5::PredType::NATIVE_UINT64);
 	chanGroup.close();
+
+	//Sequence files store the length attribute as 16 bits so trust the dataset extent for long LLs
+	H5::DataSet addrSet = H5StateFile.openDataSet(rootStr + "/addr");
+	size_t numEntries = addrSet.getSpace().getSimpleExtentNpoints();
+	addrSet.close();
+	if (numEntries != length){
+		FILE_LOG(logWARNING) << "LL length attribute " << length << " does not match dataset length " << numEntries << "; using dataset length";
+		length = numEntries;
+	}
+
+	//Very long LLs don't fit in memory so spool them to disk a chunk at a time
+	if (length > MAX_LL_HOST_LENGTH){
+		return read_chunked_from_hdf5(H5StateFile, rootStr);
+	}
 	addr_  = h5array2vector<USHORT>(&H5StateFile, rootStr + "/addr",  dt);
 	count_   = h5array2vector<USHORT>(&H5StateFile, rootStr + "/count",   dt);
 	trigger1_ = h5array2vector<USHORT>(&H5StateFile, rootStr + "/trigger1", dt);
@@ -87,41 +374,268 @@ int LLBank::read_state_from_hdf5(H5::H5File & H5StateFile, const string & rootSt
 	return 0;
 }
 
-void LLBank::init_data(){
+int LLBank::read_chunked_from_hdf5(H5::H5File & H5StateFile, const string & rootStr){
+	/*
+	 * Stream the LL datasets through memory in chunks, packing each chunk and appending it to a
+	 * spool file. The miniLL index goes to a spool file of its own so host memory use doesn't
+	 * grow with the LL.
+	 */
+	H5::DataType dt = H5::PredType::NATIVE_UINT16;
+	FILE_LOG(logINFO) << "LL bank " << rootStr << " has " << length << " entries; streaming from disk";
 
-	//Sort out the length of the mini LL's and their start points
-	//Go through the LL entries and calculate lengths and start points of each miniLL
+	diskSource_ = std::make_shared<LLFileSource>(IQMode ? 5 : 4);
+	miniLLSource_ = std::make_shared<LLFileSource>(MINILL_INDEX_WIDTH);
+	miniLLWindow_ = std::make_shared<MiniLLIndexWindow>();
+	miniLLWindow_->first = 0;
 	miniLLLengths.clear();
 	miniLLStartIdx.clear();
+	numMiniLLs = 0;
+	maxMiniLLSpan_ = 0;
+	size_t lastStart = length;
+	size_t lengthCt = 0;
+	size_t numEntries = length;
+
+	//Keep the datasets open so chunked files only decompress each chunk once
+	H5::DataSet addrSet = H5StateFile.openDataSet(rootStr + "/addr");
+	H5::DataSet countSet = H5StateFile.openDataSet(rootStr + "/count");
+	H5::DataSet trigger1Set = H5StateFile.openDataSet(rootStr + "/trigger1");
+	H5::DataSet repeatSet = H5StateFile.openDataSet(rootStr + "/repeat");
+	H5::DataSet trigger2Set;
+	if(IQMode){
+		trigger2Set = H5StateFile.openDataSet(rootStr + "/trigger2");
+	}
+
+	for (size_t offset = 0; offset < numEntries; offset += LL_DISK_CHUNK_LENGTH){
+		size_t count = std::min(LL_DISK_CHUNK_LENGTH, numEntries - offset);
+		h5range2vector<USHORT>(addrSet, offset, count, addr_, dt);
+		h5range2vector<USHORT>(countSet, offset, count, count_, dt);
+		h5range2vector<USHORT>(trigger1Set, offset, count, trigger1_, dt);
+		h5range2vector<USHORT>(repeatSet, offset, count, repeat_, dt);
+		if(IQMode){
+			h5range2vector<USHORT>(trigger2Set, offset, count, trigger2_, dt);
+		}
+		find_miniLLs(repeat_, offset, lengthCt);
+		track_miniLL_spans(miniLLStartIdx.begin(), miniLLStartIdx.end(), lastStart);
+		if (diskSource_->append(pack_data(0, count)) != 0 || spool_miniLL_index() != 0){
+			return -1;
+		}
+	}
+
+	//Drop the staging buffers
+	addr_.clear();
+	count_.clear();
+	trigger1_.clear();
+	trigger2_.clear();
+	repeat_.clear();
+
+	close_miniLL_spans(lastStart);
+	diskBacked = true;
+	diskSource_->finalize();
+	miniLLSource_->finalize();
+	return 0;
+}
+
+int LLBank::write_chunked_to_hdf5(H5::H5File & H5StateFile, const string & rootStr){
+	/*
+	 * Disk backed banks only hold the packed entries so read them back from the spool a chunk at a time
+	 * and split them out into the same datasets write_state_to_hdf5 writes for a bank in memory
+	 */
+	H5::DataType dt = H5::PredType::NATIVE_UINT16;
+	const size_t entryWidth = IQMode ? 5 : 4;
+	hsize_t fdim[] = {length, 1};
+	H5::DataSpace fspace(2, fdim);
+	H5::DSetCreatPropList props = h5_create_props(length, H5_STATE_STORAGE);
+	vector<string> names = {"addr", "count", "trigger1"};
+	if (IQMode){
+		names.push_back("trigger2");
+	}
+	names.push_back("repeat");
+	vector<H5::DataSet> dataSets;
+	for (const string & name : names){
+		dataSets.push_back(H5StateFile.createDataSet(rootStr + "/" + name, dt, fspace, props));
+	}
+
+	vector<WordVec> fields(entryWidth);
+	for (size_t offset = 0; offset < length; offset += LL_DISK_CHUNK_LENGTH){
+		size_t count = std::min(LL_DISK_CHUNK_LENGTH, length - offset);
+		WordVec packed = diskSource_->get_packed_data(offset, offset + count);
+		if (packed.size() != entryWidth*count){
+			FILE_LOG(logERROR) << "Could not read back LL entries " << offset << " to " << offset + count << " from the spool file";
+			return -1;
+		}
+		for (size_t fieldct = 0; fieldct < entryWidth; fieldct++){
+			fields[fieldct].resize(count);
+			for (size_t ct = 0; ct < count; ct++){
+				fields[fieldct][ct] = packed[entryWidth*ct + fieldct];
+			}
+			vector2h5range<USHORT>(fields[fieldct], dataSets[fieldct], offset, dt);
+		}
+	}
+	for (auto & dataSet : dataSets){
+		dataSet.close();
+	}
+	return 0;
+}
+
+size_t LLBank::num_build_threads(const size_t & numEntries) const{
+	if (numEntries < parallelThreshold){
+		return 1;
+	}
+	return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void LLBank::find_miniLLs(const WordVec & repeat, const size_t & offset, size_t & lengthCt){
+	//Go through the LL entries and calculate lengths and start points of each miniLL
+	//offset is the LL index of repeat[0]; lengthCt carries a partial miniLL between calls
 	const USHORT startMiniLLMask = (1 << 15);
 	const USHORT endMiniLLMask = (1 << 14);
-	size_t lengthCt = 0;
-	for(size_t ct = 0; ct < length; ct++){
-		// flags are stored in repeat vector
-		USHORT curWord = repeat_[ct];
+
+	//First find the entries carrying either flag; this is the expensive pass so split it across threads
+	//and stitch the per-thread lists back together in order
+	size_t numThreads = num_build_threads(repeat.size());
+	vector<vector<size_t>> threadFlagged(numThreads);
+	parallel_for(repeat.size(), numThreads, [&](size_t threadct, size_t begin, size_t end){
+		for (size_t ct = begin; ct < end; ct++){
+			if (repeat[ct] & (startMiniLLMask | endMiniLLMask)){
+				threadFlagged[threadct].push_back(ct);
+			}
+		}
+	});
+	vector<size_t> flagged;
+	if (numThreads == 1){
+		flagged.swap(threadFlagged[0]);
+	}
+	else{
+		size_t numFlagged = 0;
+		for (auto & vec : threadFlagged) numFlagged += vec.size();
+		flagged.reserve(numFlagged);
+		for (auto & vec : threadFlagged) flagged.insert(flagged.end(), vec.begin(), vec.end());
+	}
+
+	//Then walk the flagged entries; a miniLL's length is the distance back to its start flag
+	bool haveStart = false;
+	size_t lastStart = 0;
+	for (size_t ct : flagged){
+		USHORT curWord = repeat[ct];
 		if (curWord & startMiniLLMask){
-			miniLLStartIdx.push_back(ct);
-			lengthCt = 0;
+			miniLLStartIdx.push_back(offset + ct);
+			haveStart = true;
+			lastStart = ct;
 		}
-		lengthCt++;
 		if (curWord & endMiniLLMask){
-			miniLLLengths.push_back(lengthCt);
+			miniLLLengths.push_back(haveStart ? ct - lastStart + 1 : lengthCt + ct + 1);
 		}
 	}
-	numMiniLLs = miniLLLengths.size();
+	lengthCt = haveStart ? repeat.size() - lastStart : lengthCt + repeat.size();
+}
 
-	//Now pack the data for writing to the device
-	packedData_.clear();
-	size_t expectedLength = IQMode ? 5*length : 4*length;
-	packedData_.reserve(expectedLength);
-
-	for(size_t ct=0; ct<length; ct++){
-		packedData_.push_back(addr_[ct]);
-		packedData_.push_back(count_[ct]);
-		packedData_.push_back(trigger1_[ct]);
+WordVec LLBank::pack_data(const size_t & startIdx, const size_t & stopIdx) const{
+	//Interleave the LL entries [startIdx, stopIdx) for writing to the device
+	WordVec packed((IQMode ? 5 : 4)*(stopIdx-startIdx));
+	WordVec::iterator packedIt = packed.begin();
+	for(size_t ct=startIdx; ct<stopIdx; ct++){
+		*packedIt++ = addr_[ct];
+		*packedIt++ = count_[ct];
+		*packedIt++ = trigger1_[ct];
 		if (IQMode){
-			packedData_.push_back(trigger2_[ct]);
+			*packedIt++ = trigger2_[ct];
+		}
+		*packedIt++ = repeat_[ct];
+	}
+	return packed;
+}
+
+bool LLBank::same_entries(const size_t & idxA, const size_t & idxB, const size_t & numEntries) const{
+	//Compare two ranges of raw LL entries
+	auto same_range = [&](const WordVec & vec){
+		return std::equal(vec.begin()+idxA, vec.begin()+idxA+numEntries, vec.begin()+idxB);
+	};
+	return same_range(addr_) && same_range(count_) && same_range(trigger1_) &&
+			(!IQMode || same_range(trigger2_)) && same_range(repeat_);
+}
+
+void LLBank::add_segment(const size_t & startIdx, const bool & isMiniLL){
+	//Segments are contiguous so each one runs up to the start of the next
+	segStartIdx_.push_back(startIdx);
+	segIsMiniLL_.push_back(isMiniLL);
+}
+
+void LLBank::add_gap_segments(const size_t & startIdx, const size_t & stopIdx){
+	//Break long runs outside any miniLL into fixed size chunks so no single block has to hold millions of entries
+	for (size_t idx = startIdx; idx < stopIdx; idx += LL_DISK_CHUNK_LENGTH){
+		add_segment(idx, false);
+	}
+}
+
+void LLBank::pack_segments(){
+	//Pack a block for each segment, sharing the previous block when a miniLL is an identical copy of the previous miniLL
+	size_t numSegs = segStartIdx_.size();
+	size_t numThreads = num_build_threads(length);
+	auto seg_stop = [&](size_t segct){ return (segct+1 < numSegs) ? segStartIdx_[segct+1] : length; };
+
+	//Comparing neighbours is independent for each segment
+	vector<char> sameAsPrev(numSegs, 0);
+	parallel_for(numSegs, numThreads, [&](size_t, size_t begin, size_t end){
+		for (size_t segct = std::max<size_t>(begin, 1); segct < end; segct++){
+			if (!segIsMiniLL_[segct] || !segIsMiniLL_[segct-1]) continue;
+			size_t startIdx = segStartIdx_[segct];
+			size_t prevStart = segStartIdx_[segct-1];
+			size_t segLength = seg_stop(segct) - startIdx;
+			sameAsPrev[segct] = ((startIdx - prevStart) == segLength) && same_entries(prevStart, startIdx, segLength);
+		}
+	});
+
+	//Number the unique blocks in order
+	segBlock_.resize(numSegs);
+	vector<size_t> blockSeg;
+	for (size_t segct = 0; segct < numSegs; segct++){
+		if (sameAsPrev[segct]){
+			segBlock_[segct] = segBlock_[segct-1];
 		}
-		packedData_.push_back(repeat_[ct]);
+		else{
+			segBlock_[segct] = blockSeg.size();
+			blockSeg.push_back(segct);
+		}
+	}
+
+	//And pack them into their slots
+	blocks_.resize(blockSeg.size());
+	parallel_for(blockSeg.size(), numThreads, [&](size_t, size_t begin, size_t end){
+		for (size_t blockct = begin; blockct < end; blockct++){
+			size_t segct = blockSeg[blockct];
+			blocks_[blockct] = pack_data(segStartIdx_[segct], seg_stop(segct));
+		}
+	});
+}
+
+void LLBank::init_data(){
+
+	//Sort out the length of the mini LL's and their start points
+	miniLLLengths.clear();
+	miniLLStartIdx.clear();
+	size_t lengthCt = 0;
+	find_miniLLs(repeat_, 0, lengthCt);
+	numMiniLLs = miniLLLengths.size();
+	maxMiniLLSpan_ = 0;
+	size_t lastStart = length;
+	track_miniLL_spans(miniLLStartIdx.begin(), miniLLStartIdx.begin() + std::min(numMiniLLs, miniLLStartIdx.size()), lastStart);
+	close_miniLL_spans(lastStart);
+
+	//Now pack the data for writing to the device
+	//Each miniLL gets a segment and any entries between miniLLs get their own segment
+	blocks_.clear();
+	segStartIdx_.clear();
+	segBlock_.clear();
+	segIsMiniLL_.clear();
+	size_t curIdx = 0;
+	for (size_t miniLLct = 0; miniLLct < numMiniLLs; miniLLct++){
+		size_t startIdx = miniLLStartIdx[miniLLct];
+		size_t stopIdx = std::min(length, startIdx + miniLLLengths[miniLLct]);
+		add_gap_segments(curIdx, startIdx);
+		add_segment(startIdx, true);
+		curIdx = stopIdx;
 	}
+	add_gap_segments(curIdx, length);
+	pack_segments();
+	FILE_LOG(logDEBUG) << "Packed " << length << " LL entries (" << numMiniLLs << " miniLLs) into " << blocks_.size() << " unique blocks";
 }
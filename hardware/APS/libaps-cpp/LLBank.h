@@ -11,24 +11,49 @@
 #define LLBANK_H_
 
 
+class LLFileSource;
+
 //An individual bank of a LL for a single channel
 class LLBank {
 public:
 	LLBank();
-	LLBank(const WordVec &, const WordVec &, const WordVec &, const WordVec &);
-	LLBank(const WordVec &, const WordVec &, const WordVec &, const WordVec &, const WordVec &);
+	LLBank(WordVec, WordVec, WordVec, WordVec);
+	LLBank(WordVec, WordVec, WordVec, WordVec, WordVec);
 	~LLBank();
+	LLBank(const LLBank &) = default;
+	LLBank(LLBank &&) = default;
+	LLBank & operator=(const LLBank &) = default;
+	LLBank & operator=(LLBank &&) = default;
 
 	void clear();
 
 	size_t length;
 	bool IQMode;
+	//Whether the packed data is spooled to disk instead of held in memory
+	bool diskBacked;
 	size_t numMiniLLs;
-	WordVec miniLLLengths;
-	WordVec miniLLStartIdx;
+	//Only held in memory for banks that aren't disk backed; use miniLL_start to look up either kind
+	IdxVec miniLLLengths;
+	IdxVec miniLLStartIdx;
+
+	size_t miniLL_start(const size_t &) const;
+	size_t max_miniLL_span() const;
 
 	WordVec get_packed_data(const size_t &, const size_t &);
 
+	size_t miniLL_repeat_factor() const;
+	int fold_miniLL_repeats(const size_t &);
+	int rebase_addresses(const int &);
+
+	//Raw and packed data for compiled sequence files
+	WordVec raw_data() const;
+	int init_precomputed(const size_t &, const USHORT *, const USHORT *, const uint64_t *, const size_t &);
+
+	bool operator==(const LLBank &) const;
+
+	//Banks with at least this many entries are built on multiple threads
+	static size_t parallelThreshold;
+
 	int write_state_to_hdf5(  H5::H5File & , const string & );
 	int read_state_from_hdf5( H5::H5File & , const string & );
 
@@ -39,8 +64,38 @@ private:
 	WordVec repeat_;
 	WordVec trigger1_;
 	WordVec trigger2_;
-	WordVec packedData_;
+	//Packed data is held as unique blocks; runs of identical consecutive miniLLs share a block
+	//The LL is a list of segments: segStartIdx_ is where each starts and segBlock_ the block it plays
+	vector<WordVec> blocks_;
+	vector<size_t> segStartIdx_;
+	vector<size_t> segBlock_;
+	vector<bool> segIsMiniLL_;
+	std::shared_ptr<LLFileSource> diskSource_;
+	//miniLL start indices of a disk backed bank, spooled as 64 bit values
+	std::shared_ptr<LLFileSource> miniLLSource_;
+	//The chunk of the spooled index miniLL_start last read; copies of the bank share it like the spool
+	struct MiniLLIndexWindow {
+		std::mutex mutex;
+		size_t first;
+		IdxVec startIdx;
+	};
+	std::shared_ptr<MiniLLIndexWindow> miniLLWindow_;
+	//Worked out as the miniLLs are found so checking a bank never goes back to the spool
+	size_t maxMiniLLSpan_;
 	void init_data();
+	void find_miniLLs(const WordVec &, const size_t &, size_t &);
+	WordVec pack_data(const size_t &, const size_t &) const;
+	bool same_entries(const size_t &, const size_t &, const size_t &) const;
+	void add_segment(const size_t &, const bool &);
+	void add_gap_segments(const size_t &, const size_t &);
+	void pack_segments();
+	size_t num_build_threads(const size_t &) const;
+	void copy_packed_data(const size_t &, const size_t &, WordVec &) const;
+	int read_chunked_from_hdf5( H5::H5File & , const string & );
+	int write_chunked_to_hdf5( H5::H5File & , const string & );
+	int spool_miniLL_index();
+	void track_miniLL_spans(IdxVec::const_iterator, IdxVec::const_iterator, size_t &);
+	void close_miniLL_spans(const size_t &);
 };
 
 #endif /* LLBANK_H_ */
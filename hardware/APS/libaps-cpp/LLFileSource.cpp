@@ -0,0 +1,154 @@
+/*
+ * LLFileSource.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "LLFileSource.h"
+
+//Seek with 64 bit offsets so spool files can grow past 2GB
+inline int spool_seek(FILE * pFile, const unsigned long long & offset){
+#ifdef _WIN32
+	return _fseeki64(pFile, offset, SEEK_SET);
+#else
+	return fseeko(pFile, offset, SEEK_SET);
+#endif
+}
+
+LLFileSource::LLFileSource(const size_t & entryWidth) : length{0}, entryWidth_{entryWidth}, spool_{nullptr}, cursorChunk_{0} {
+	spool_ = tmpfile();
+	if (!spool_){
+		FILE_LOG(logERROR) << "Unable to create LL spool file";
+		throw runtime_error("Unable to create LL spool file.");
+	}
+}
+
+LLFileSource::~LLFileSource() {
+	//Make sure the prefetch thread is done before we tear down the file
+	stop();
+	if (spool_) fclose(spool_);
+}
+
+int LLFileSource::append(const WordVec & packedData){
+	//Add packed LL entries to the end of the spool file
+	std::lock_guard<std::mutex> lock(fileMutex_);
+	spool_seek(spool_, static_cast<unsigned long long>(length)*entryWidth_*sizeof(USHORT));
+	size_t wordsWritten = fwrite(&packedData[0], sizeof(USHORT), packedData.size(), spool_);
+	if (wordsWritten != packedData.size()){
+		FILE_LOG(logERROR) << "Failed writing LL spool file after " << wordsWritten << " words";
+		return -1;
+	}
+	length += packedData.size()/entryWidth_;
+	return 0;
+}
+
+int LLFileSource::finalize(){
+	//Done spooling so start prefetching from the top of the LL
+	fflush(spool_);
+	FILE_LOG(logDEBUG) << "Spooled " << length << " LL entries to disk in " << num_chunks() << " chunks";
+	start();
+	return 0;
+}
+
+size_t LLFileSource::num_chunks() const{
+	return (length + LL_DISK_CHUNK_LENGTH - 1)/LL_DISK_CHUNK_LENGTH;
+}
+
+WordVec LLFileSource::read_chunk(const size_t & chunkIdx){
+	size_t startIdx = chunkIdx*LL_DISK_CHUNK_LENGTH;
+	size_t numEntries = std::min(LL_DISK_CHUNK_LENGTH, length - startIdx);
+	WordVec chunk(numEntries*entryWidth_);
+
+	std::lock_guard<std::mutex> lock(fileMutex_);
+	spool_seek(spool_, static_cast<unsigned long long>(startIdx)*entryWidth_*sizeof(USHORT));
+	size_t wordsRead = fread(&chunk[0], sizeof(USHORT), chunk.size(), spool_);
+	if (wordsRead != chunk.size()){
+		FILE_LOG(logERROR) << "Short read from LL spool file for chunk " << chunkIdx;
+	}
+	return chunk;
+}
+
+void LLFileSource::copy_range(const size_t & startIdx, const size_t & stopIdx, WordVec & vecOut){
+	//Copy entries [startIdx, stopIdx) out of the cache, reading any chunk the prefetcher has not got to yet
+	std::lock_guard<std::mutex> lock(cacheMutex_);
+	size_t curIdx = startIdx;
+	while (curIdx < stopIdx){
+		size_t chunkIdx = curIdx/LL_DISK_CHUNK_LENGTH;
+		if (chunks_.count(chunkIdx) == 0){
+			FILE_LOG(logDEBUG1) << "LL prefetch miss on chunk " << chunkIdx;
+			chunks_[chunkIdx] = read_chunk(chunkIdx);
+		}
+		const WordVec & chunk = chunks_[chunkIdx];
+		size_t chunkStart = chunkIdx*LL_DISK_CHUNK_LENGTH;
+		size_t chunkStop = std::min(stopIdx, chunkStart + LL_DISK_CHUNK_LENGTH);
+		vecOut.insert(vecOut.end(), chunk.begin() + entryWidth_*(curIdx-chunkStart), chunk.begin() + entryWidth_*(chunkStop-chunkStart));
+		curIdx = chunkStop;
+	}
+}
+
+WordVec LLFileSource::get_packed_data(const size_t & startIdx, const size_t & stopIdx){
+	//Pull out packed data starting at startIdx but not inclusive of stopIdx
+	WordVec vecOut;
+	vecOut.reserve(entryWidth_*((stopIdx < startIdx) ? length - startIdx + stopIdx : stopIdx - startIdx));
+	//Handle wrapping around the top of the LL data
+	if (stopIdx < startIdx){
+		copy_range(startIdx, length, vecOut);
+		copy_range(0, stopIdx, vecOut);
+	}
+	else{
+		copy_range(startIdx, stopIdx, vecOut);
+	}
+
+	//Let the prefetcher know where we have got to
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex_);
+		cursorChunk_ = (stopIdx/LL_DISK_CHUNK_LENGTH) % num_chunks();
+	}
+	cursorMoved_.notify_one();
+	return vecOut;
+}
+
+void LLFileSource::run(){
+	/*
+	 * Keep the chunk the consumer is on and the next LL_PREFETCH_CHUNKS (cyclically) in memory
+	 * and drop everything else so host memory use is independent of the LL length.
+	 */
+	const size_t numChunks = num_chunks();
+	if (numChunks == 0) return;
+	while (running_) {
+		vector<size_t> wanted;
+		vector<size_t> missing;
+		{
+			std::unique_lock<std::mutex> lock(cacheMutex_);
+			for (size_t ct = 0; ct <= std::min(LL_PREFETCH_CHUNKS, numChunks-1); ct++){
+				wanted.push_back((cursorChunk_ + ct) % numChunks);
+			}
+			//Evict chunks that have been played out
+			for (auto it = chunks_.begin(); it != chunks_.end(); ){
+				if (std::find(wanted.begin(), wanted.end(), it->first) == wanted.end()){
+					it = chunks_.erase(it);
+				}
+				else{
+					++it;
+				}
+			}
+			for (size_t chunkIdx : wanted){
+				if (chunks_.count(chunkIdx) == 0) missing.push_back(chunkIdx);
+			}
+			//Nothing to do so wait for the consumer to move on
+			if (missing.empty()){
+				cursorMoved_.wait_for(lock, std::chrono::milliseconds(10));
+				continue;
+			}
+		}
+
+		//Read outside the cache lock so the consumer isn't blocked on disk I/O
+		for (size_t chunkIdx : missing){
+			WordVec chunk = read_chunk(chunkIdx);
+			std::lock_guard<std::mutex> lock(cacheMutex_);
+			if (chunks_.count(chunkIdx) == 0){
+				chunks_[chunkIdx] = std::move(chunk);
+			}
+		}
+	}
+}
@@ -0,0 +1,58 @@
+/*
+ * LLFileSource.h
+ *
+ * Disk-backed storage for link lists too large to keep in host memory.
+ * Packed LL entries are spooled to a temporary file at load time and read back in
+ * fixed size chunks, with a background thread prefetching the chunks ahead of the
+ * streaming consumer.
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "headings.h"
+
+#ifndef LLFILESOURCE_H_
+#define LLFILESOURCE_H_
+
+#include <condition_variable>
+
+class LLFileSource : public Runnable
+{
+public:
+	LLFileSource(const size_t &);
+	~LLFileSource();
+
+	//Number of LL entries spooled so far
+	size_t length;
+
+	int append(const WordVec &);
+	int finalize();
+
+	WordVec get_packed_data(const size_t &, const size_t &);
+
+protected:
+	void run();
+
+private:
+	LLFileSource(const LLFileSource&) = delete;
+	LLFileSource& operator=(const LLFileSource&) = delete;
+
+	//Number of packed words per LL entry
+	size_t entryWidth_;
+	FILE * spool_;
+	//Serializes access to the spool file
+	std::mutex fileMutex_;
+
+	//Chunks currently held in memory keyed by chunk index
+	map<size_t, WordVec> chunks_;
+	//The chunk the consumer is currently reading from
+	size_t cursorChunk_;
+	std::mutex cacheMutex_;
+	std::condition_variable cursorMoved_;
+
+	size_t num_chunks() const;
+	WordVec read_chunk(const size_t &);
+	void copy_range(const size_t &, const size_t &, WordVec &);
+};
+
+#endif /* LLFILESOURCE_H_ */
@@ -0,0 +1,140 @@
+/*
+ * PerfStats.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "PerfStats.h"
+
+namespace {
+//Zero initialized as a static so counting can start before anything else runs
+PerfStats::OpStats opStats[NUM_PERF_OPS];
+
+int most_significant_bit(uint64_t value){
+#ifdef __GNUC__
+	return 63 - __builtin_clzll(value);
+#else
+	int msb = 0;
+	while (value >>= 1) msb++;
+	return msb;
+#endif
+}
+}
+
+size_t PerfStats::bucket_index(const uint64_t & latency){
+	/*
+	 * Values below 2^SUB_BUCKET_BITS get a bucket each; above that each power of two
+	 * is split into 2^SUB_BUCKET_BITS equal buckets
+	 */
+	const uint64_t numSubBuckets = uint64_t(1) << SUB_BUCKET_BITS;
+	if (latency < numSubBuckets){
+		return latency;
+	}
+	int msb = most_significant_bit(latency);
+	if (msb >= MAX_LATENCY_BITS){
+		return NUM_BUCKETS - 1;
+	}
+	size_t subBucket = (latency >> (msb - SUB_BUCKET_BITS)) & (numSubBuckets - 1);
+	return ((msb - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS) + subBucket;
+}
+
+uint64_t PerfStats::bucket_upper_bound(const size_t & index){
+	//Largest latency that falls in a bucket
+	const size_t numSubBuckets = size_t(1) << SUB_BUCKET_BITS;
+	if (index < numSubBuckets){
+		return index;
+	}
+	int shift = (index >> SUB_BUCKET_BITS) - 1;
+	uint64_t subBucket = index & (numSubBuckets - 1);
+	return ((numSubBuckets + subBucket + 1) << shift) - 1;
+}
+
+void PerfStats::record(const PERF_OP & op, const uint64_t & latency, const uint64_t & bytes, const uint64_t & transfers, const uint64_t & roundTrips){
+	OpStats & stats = opStats[op];
+	stats.calls.fetch_add(1, std::memory_order_relaxed);
+	stats.bytes.fetch_add(bytes, std::memory_order_relaxed);
+	stats.transfers.fetch_add(transfers, std::memory_order_relaxed);
+	stats.roundTrips.fetch_add(roundTrips, std::memory_order_relaxed);
+	stats.totalNs.fetch_add(latency, std::memory_order_relaxed);
+	stats.histogram[bucket_index(latency)].fetch_add(1, std::memory_order_relaxed);
+	uint64_t curMax = stats.maxNs.load(std::memory_order_relaxed);
+	while (latency > curMax && !stats.maxNs.compare_exchange_weak(curMax, latency, std::memory_order_relaxed)) {}
+}
+
+void PerfStats::reset(){
+	for (OpStats & stats : opStats){
+		stats.calls.store(0, std::memory_order_relaxed);
+		stats.bytes.store(0, std::memory_order_relaxed);
+		stats.transfers.store(0, std::memory_order_relaxed);
+		stats.roundTrips.store(0, std::memory_order_relaxed);
+		stats.totalNs.store(0, std::memory_order_relaxed);
+		stats.maxNs.store(0, std::memory_order_relaxed);
+		for (auto & count : stats.histogram){
+			count.store(0, std::memory_order_relaxed);
+		}
+	}
+}
+
+const char * PerfStats::op_name(const PERF_OP & op){
+	static const char * const names[] = {"load_sequence_file", "load_compiled_sequence", "flush", "write_waveform",
+			"write_LL_data_IQ", "program_FPGA", "test_PLL_sync", "setup_DAC", "write_block", "write_image", "read_FPGA",
+			"write_SPI", "read_SPI"};
+	return names[op];
+}
+
+string PerfStats::to_json(){
+	/*
+	 * Snapshot of every operation that has been called:
+	 * {"ops": [{"name": ..., "calls": ..., "bytes": ..., "transfers": ..., "roundTrips": ...,
+	 *           "totalNs": ..., "maxNs": ..., "p50Ns": ..., "p90Ns": ..., "p99Ns": ..., "p999Ns": ...,
+	 *           "histogram": [[bucketUpperBoundNs, count], ...]}, ...]}
+	 * Percentiles are bucket upper bounds so are within the histogram resolution
+	 */
+	std::ostringstream json;
+	json << "{\"ops\": [";
+	bool firstOp = true;
+	for (int opct = 0; opct < NUM_PERF_OPS; opct++){
+		const OpStats & stats = opStats[opct];
+		vector<uint64_t> counts(NUM_BUCKETS);
+		uint64_t numSamples = 0;
+		for (size_t bucketct = 0; bucketct < NUM_BUCKETS; bucketct++){
+			counts[bucketct] = stats.histogram[bucketct].load(std::memory_order_relaxed);
+			numSamples += counts[bucketct];
+		}
+		if (numSamples == 0){
+			continue;
+		}
+		auto percentile = [&](const double & fraction){
+			uint64_t threshold = static_cast<uint64_t>(std::ceil(fraction*numSamples));
+			uint64_t runningCount = 0;
+			for (size_t bucketct = 0; bucketct < NUM_BUCKETS; bucketct++){
+				runningCount += counts[bucketct];
+				if (runningCount >= threshold) return bucket_upper_bound(bucketct);
+			}
+			return bucket_upper_bound(NUM_BUCKETS-1);
+		};
+
+		json << (firstOp ? "" : ", ") << "{\"name\": \"" << op_name(PERF_OP(opct)) << "\""
+			<< ", \"calls\": " << stats.calls.load(std::memory_order_relaxed)
+			<< ", \"bytes\": " << stats.bytes.load(std::memory_order_relaxed)
+			<< ", \"transfers\": " << stats.transfers.load(std::memory_order_relaxed)
+			<< ", \"roundTrips\": " << stats.roundTrips.load(std::memory_order_relaxed)
+			<< ", \"totalNs\": " << stats.totalNs.load(std::memory_order_relaxed)
+			<< ", \"maxNs\": " << stats.maxNs.load(std::memory_order_relaxed)
+			<< ", \"p50Ns\": " << percentile(0.5)
+			<< ", \"p90Ns\": " << percentile(0.9)
+			<< ", \"p99Ns\": " << percentile(0.99)
+			<< ", \"p999Ns\": " << percentile(0.999)
+			<< ", \"histogram\": [";
+		bool firstBucket = true;
+		for (size_t bucketct = 0; bucketct < NUM_BUCKETS; bucketct++){
+			if (counts[bucketct] == 0) continue;
+			json << (firstBucket ? "" : ", ") << "[" << bucket_upper_bound(bucketct) << ", " << counts[bucketct] << "]";
+			firstBucket = false;
+		}
+		json << "]}";
+		firstOp = false;
+	}
+	json << "]}";
+	return json.str();
+}
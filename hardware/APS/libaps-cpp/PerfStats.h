@@ -0,0 +1,85 @@
+/*
+ * PerfStats.h
+ *
+ * Always-on performance counters for the driver layers.
+ * Each instrumented operation keeps call, byte and USB transfer counts and a log-linear
+ * (HDR style) latency histogram. Recording is a couple of clock reads and relaxed atomic
+ * adds so it stays on in production; get_perf_stats in the C API reports them as JSON.
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "headings.h"
+
+#ifndef PERFSTATS_H_
+#define PERFSTATS_H_
+
+typedef enum {
+	PERF_LOAD_SEQUENCE = 0,
+	PERF_LOAD_COMPILED,
+	PERF_FLUSH,
+	PERF_WRITE_WAVEFORM,
+	PERF_WRITE_LL_DATA,
+	PERF_PROGRAM_FPGA,
+	PERF_TEST_PLL_SYNC,
+	PERF_SETUP_DAC,
+	PERF_WRITE_BLOCK,
+	PERF_WRITE_IMAGE,
+	PERF_READ_FPGA,
+	PERF_WRITE_SPI,
+	PERF_READ_SPI,
+	NUM_PERF_OPS
+} PERF_OP;
+
+namespace PerfStats {
+
+//Histogram buckets: 2^SUB_BUCKET_BITS linear sub-buckets per power of two (~6% resolution)
+//up to 2^MAX_LATENCY_BITS ns (about 18 minutes); longer latencies land in the last bucket
+static const int SUB_BUCKET_BITS = 4;
+static const int MAX_LATENCY_BITS = 40;
+static const size_t NUM_BUCKETS = (MAX_LATENCY_BITS - SUB_BUCKET_BITS + 2) << SUB_BUCKET_BITS;
+
+struct OpStats {
+	std::atomic<uint64_t> calls;
+	std::atomic<uint64_t> bytes;
+	//USB transfers (FT_Write/FT_Read calls) and round trips (reads that wait on the device)
+	std::atomic<uint64_t> transfers;
+	std::atomic<uint64_t> roundTrips;
+	std::atomic<uint64_t> totalNs;
+	std::atomic<uint64_t> maxNs;
+	std::atomic<uint64_t> histogram[NUM_BUCKETS];
+};
+
+size_t bucket_index(const uint64_t &);
+uint64_t bucket_upper_bound(const size_t &);
+
+void record(const PERF_OP &, const uint64_t &, const uint64_t &, const uint64_t &, const uint64_t &);
+void reset();
+string to_json();
+const char * op_name(const PERF_OP &);
+
+//Times its scope and records it against an operation along with whatever was added
+class Timer {
+public:
+	Timer(const PERF_OP & op) : op_(op), start_(std::chrono::steady_clock::now()), bytes_(0), transfers_(0), roundTrips_(0) {};
+	~Timer(){
+		uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count();
+		record(op_, elapsed, bytes_, transfers_, roundTrips_);
+	};
+
+	void add_bytes(const uint64_t & bytes) {bytes_ += bytes;};
+	void add_transfers(const uint64_t & transfers, const uint64_t & roundTrips = 0) {transfers_ += transfers; roundTrips_ += roundTrips;};
+
+private:
+	Timer(const Timer &) = delete;
+	Timer & operator=(const Timer &) = delete;
+	PERF_OP op_;
+	std::chrono::steady_clock::time_point start_;
+	uint64_t bytes_;
+	uint64_t transfers_;
+	uint64_t roundTrips_;
+};
+
+} //end namespace PerfStats
+
+#endif /* PERFSTATS_H_ */
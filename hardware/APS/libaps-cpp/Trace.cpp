@@ -0,0 +1,117 @@
+/*
+ * Trace.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "Trace.h"
+
+#include <set>
+
+namespace {
+
+struct ThreadBuffer {
+	int threadID;
+	//Only contended while exporting or clearing
+	std::mutex lock;
+	vector<Trace::Event> events;
+};
+
+std::atomic<bool> traceEnabled{false};
+//steady_clock time tracing was last enabled; trace timestamps are relative to it
+std::atomic<int64_t> traceStartNs{0};
+
+//Every thread that has recorded a span; buffers outlive their threads so they can still be exported
+std::mutex registryLock;
+vector<std::unique_ptr<ThreadBuffer>> threadBuffers;
+
+thread_local ThreadBuffer * myBuffer = nullptr;
+
+ThreadBuffer & thread_buffer(){
+	if (myBuffer == nullptr){
+		std::lock_guard<std::mutex> lock(registryLock);
+		threadBuffers.emplace_back(new ThreadBuffer());
+		myBuffer = threadBuffers.back().get();
+		myBuffer->threadID = threadBuffers.size();
+	}
+	return *myBuffer;
+}
+
+}
+
+bool Trace::enabled(){
+	return traceEnabled.load(std::memory_order_relaxed);
+}
+
+int64_t Trace::now_ns(){
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Trace::set_enabled(const bool & enable){
+	std::lock_guard<std::mutex> lock(registryLock);
+	if (enable){
+		for (auto & buffer : threadBuffers){
+			std::lock_guard<std::mutex> bufferLock(buffer->lock);
+			buffer->events.clear();
+		}
+		traceStartNs.store(now_ns());
+	}
+	traceEnabled.store(enable);
+	FILE_LOG(logINFO) << "Tracing " << (enable ? "enabled" : "disabled");
+}
+
+void Trace::record(const Event & event){
+	ThreadBuffer & buffer = thread_buffer();
+	std::lock_guard<std::mutex> lock(buffer.lock);
+	if (buffer.events.size() < MAX_EVENTS_PER_THREAD){
+		buffer.events.push_back(event);
+	}
+}
+
+int Trace::export_json(const string & fileName){
+	/*
+	 * Write every recorded span as a Chrome trace-event "complete" (ph = X) event
+	 * Devices map to processes (pid = deviceID + 1; pid 0 is work not tied to a device) and threads to tids
+	 * Returns 0 on success or -1 if the file couldn't be written
+	 */
+	std::ofstream out(fileName);
+	if (!out.is_open()){
+		FILE_LOG(logERROR) << "Unable to open trace file " << fileName;
+		return -1;
+	}
+	int64_t startNs = traceStartNs.load();
+	std::set<int> pids;
+	size_t numEvents = 0;
+	out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+	out << std::fixed << std::setprecision(3);
+	{
+		std::lock_guard<std::mutex> lock(registryLock);
+		for (auto & buffer : threadBuffers){
+			std::lock_guard<std::mutex> bufferLock(buffer->lock);
+			for (const Event & event : buffer->events){
+				int pid = event.deviceID + 1;
+				pids.insert(pid);
+				out << (numEvents++ ? ",\n" : "") << "{\"name\": \"" << event.name << "\", \"cat\": \"aps\", \"ph\": \"X\""
+					<< ", \"ts\": " << 1e-3*(event.startNs - startNs) << ", \"dur\": " << 1e-3*event.durationNs
+					<< ", \"pid\": " << pid << ", \"tid\": " << buffer->threadID;
+				if (event.argName != nullptr){
+					out << ", \"args\": {\"" << event.argName << "\": " << event.argValue << "}";
+				}
+				out << "}";
+			}
+		}
+	}
+	//Label the process rows
+	for (int pid : pids){
+		out << (numEvents++ ? ",\n" : "") << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << pid
+			<< ", \"args\": {\"name\": \"" << (pid == 0 ? string("host") : "APS " + std::to_string(pid-1)) << "\"}}";
+	}
+	out << "\n]}\n";
+	out.close();
+	if (out.fail()){
+		FILE_LOG(logERROR) << "Failed writing trace file " << fileName;
+		return -1;
+	}
+	FILE_LOG(logINFO) << "Wrote " << numEvents << " trace events to " << fileName;
+	return 0;
+}
@@ -0,0 +1,66 @@
+/*
+ * Trace.h
+ *
+ * Timeline tracing of device bring-up, sequence loading and streaming.
+ * Scoped spans are recorded into per-thread buffers while tracing is enabled and exported
+ * as Chrome trace-event JSON (load it in chrome://tracing or Perfetto). Each device gets
+ * its own process row and each thread its own track so overlapping phases across devices
+ * are visible. When tracing is off a span costs one atomic load.
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "headings.h"
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+namespace Trace {
+
+//Spans beyond this many per thread are dropped so a forgotten trace can't eat all the memory
+static const size_t MAX_EVENTS_PER_THREAD = 1 << 20;
+
+struct Event {
+	//Names are string literals so recording doesn't allocate
+	const char * name;
+	const char * argName;
+	int argValue;
+	int deviceID;
+	int64_t startNs;
+	int64_t durationNs;
+};
+
+bool enabled();
+//Enabling clears any spans recorded so far
+void set_enabled(const bool &);
+int64_t now_ns();
+void record(const Event &);
+int export_json(const string &);
+
+class Span {
+public:
+	Span(const char * name, const int & deviceID = -1, const char * argName = nullptr, const int & argValue = 0) :
+		active_(enabled()), event_{name, argName, argValue, deviceID, 0, 0} {
+		if (active_) event_.startNs = now_ns();
+	};
+	~Span() {finish();};
+
+	//End the span before it goes out of scope
+	void finish() {
+		if (active_) {
+			event_.durationNs = now_ns() - event_.startNs;
+			record(event_);
+			active_ = false;
+		}
+	};
+
+private:
+	Span(const Span &) = delete;
+	Span & operator=(const Span &) = delete;
+	bool active_;
+	Event event_;
+};
+
+} //end namespace Trace
+
+#endif /* TRACE_H_ */
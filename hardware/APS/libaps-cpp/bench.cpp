@@ -0,0 +1,297 @@
+/*
+ * bench.cpp
+ *
+ * Host side benchmarks for libaps; no APS needs to be attached.
+ *
+ * Usage: bench [numEntries] [all|kernels|LL|h5]
+ * The kernels suite prints CSV (kernel, elements, ns/element, GB/s) with nothing else on stdout
+ * so it can be piped straight into a comparison script. GB/s counts the bytes the kernel reads
+ * from its inputs plus the bytes it writes to its outputs.
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "headings.h"
+
+typedef std::chrono::steady_clock BenchClock;
+
+//Somewhere for kernel results to go so the work can't be optimized away
+static volatile size_t benchSink;
+
+template <typename F>
+static double time_kernel(F kernel){
+	/*
+	 * Best time of a single call in seconds
+	 * Calls are batched so each timed batch runs for at least a few ms
+	 */
+	const double minBatchTime = 5e-3;
+	const int numBatches = 5;
+	size_t batchSize = 1;
+	double bestTime = std::numeric_limits<double>::max();
+	for (int batchct = 0; batchct < numBatches; ){
+		BenchClock::time_point start = BenchClock::now();
+		for (size_t ct = 0; ct < batchSize; ct++){
+			kernel();
+		}
+		double elapsed = std::chrono::duration<double>(BenchClock::now() - start).count();
+		if (elapsed < minBatchTime && batchct == 0){
+			batchSize *= 2;
+			continue;
+		}
+		bestTime = std::min(bestTime, elapsed/batchSize);
+		batchct++;
+	}
+	return bestTime;
+}
+
+static void report_kernel(const string & kernel, const size_t & numElements, const size_t & numBytes, const double & seconds){
+	cout << kernel << ", " << numElements << ", " << 1e9*seconds/numElements << ", " << 1e-9*numBytes/seconds << endl;
+}
+
+//A full waveform library of gaussian pulses of a few widths and amplitudes
+static vector<float> make_waveform(){
+	vector<float> waveform(MAX_WF_LENGTH, 0);
+	for (size_t ct = 0; ct < waveform.size(); ct++){
+		size_t pulseIdx = ct / 256;
+		double sigma = 8.0 + 4.0*(pulseIdx % 4);
+		double t = static_cast<double>(ct % 256) - 128.0;
+		waveform[ct] = static_cast<float>(std::lround(MAX_WF_AMP * (1.0 - 0.1*(pulseIdx % 8)) * std::exp(-t*t/(2*sigma*sigma)))) / MAX_WF_AMP;
+	}
+	return waveform;
+}
+
+//Build a synthetic IQ mode LL of numEntries made up of miniLLs of varying length, with runs of repeated miniLLs
+static void make_LL(const size_t & numEntries, WordVec & addr, WordVec & count, WordVec & trigger1, WordVec & trigger2, WordVec & repeat){
+	srand(42);
+	while (addr.size() < numEntries){
+		size_t miniLLLength = std::min(numEntries - addr.size(), static_cast<size_t>(10 + rand() % 190));
+		size_t numCopies = 1 + rand() % 4;
+		USHORT baseAddr = static_cast<USHORT>(rand());
+		for (size_t copyct = 0; copyct < numCopies && addr.size() + miniLLLength <= numEntries; copyct++){
+			for (size_t ct = 0; ct < miniLLLength; ct++){
+				addr.push_back(baseAddr + ct);
+				count.push_back(static_cast<USHORT>(ct));
+				trigger1.push_back(0);
+				trigger2.push_back(0);
+				USHORT repeatWord = 0;
+				if (ct == 0) repeatWord |= (1 << 15);
+				if (ct == miniLLLength-1) repeatWord |= (1 << 14);
+				repeat.push_back(repeatWord);
+			}
+		}
+	}
+}
+
+static double time_LLBank_build(const WordVec & addr, const WordVec & count, const WordVec & trigger1, const WordVec & trigger2, const WordVec & repeat, const int & numReps, WordVec & packed){
+	double bestTime = std::numeric_limits<double>::max();
+	for (int repct = 0; repct < numReps; repct++){
+		BenchClock::time_point start = BenchClock::now();
+		LLBank bank(addr, count, trigger1, trigger2, repeat);
+		double elapsed = std::chrono::duration<double>(BenchClock::now() - start).count();
+		bestTime = std::min(bestTime, elapsed);
+		if (repct == 0){
+			packed = bank.get_packed_data(0, bank.length);
+		}
+	}
+	return bestTime;
+}
+
+int bench_LLBank_build(const size_t & numEntries){
+	WordVec addr, count, trigger1, trigger2, repeat;
+	make_LL(numEntries, addr, count, trigger1, trigger2, repeat);
+
+	const int numReps = 5;
+	WordVec serialPacked, parallelPacked;
+	LLBank::parallelThreshold = std::numeric_limits<size_t>::max();
+	double serialTime = time_LLBank_build(addr, count, trigger1, trigger2, repeat, numReps, serialPacked);
+	LLBank::parallelThreshold = LL_PARALLEL_THRESHOLD;
+	double parallelTime = time_LLBank_build(addr, count, trigger1, trigger2, repeat, numReps, parallelPacked);
+
+	if (serialPacked != parallelPacked){
+		cout << "LLBank build: serial and parallel packed data differ" << endl;
+		return -1;
+	}
+	cout << "LLBank build " << addr.size() << " entries, " << std::thread::hardware_concurrency() << " threads" << endl;
+	cout << "   serial:   " << 1e3*serialTime << " ms (" << 1e9*serialTime/addr.size() << " ns/entry)" << endl;
+	cout << "   parallel: " << 1e3*parallelTime << " ms (" << 1e9*parallelTime/addr.size() << " ns/entry)" << endl;
+	cout << "   speedup:  " << serialTime/parallelTime << endl;
+	return 0;
+}
+
+struct H5BenchResult {
+	double writeTime;
+	double readTime;
+	double rangeReadTime;
+	hsize_t fileSize;
+};
+
+static H5BenchResult time_h5_storage(const string & fileName, const H5Storage & storage, vector<WordVec> & LLArrays, vector<float> & waveform){
+	/*
+	 * Write a state-file-like layout (waveform library plus LL arrays) with the given storage,
+	 * then read it back whole and in LL_DISK_CHUNK_LENGTH ranges as the disk-backed LL loader does
+	 */
+	const char * LLNames[] = {"addr", "count", "trigger1", "trigger2", "repeat"};
+	H5::DataType dt = H5::PredType::NATIVE_UINT16;
+	H5BenchResult result;
+
+	BenchClock::time_point start = BenchClock::now();
+	{
+		H5::H5File H5StateFile(fileName, H5F_ACC_TRUNC);
+		H5StateFile.createGroup("/chan_1");
+		vector2h5array<float>(waveform, &H5StateFile, "/chan_1/waveformLib", "/chan_1/waveformLib", H5::PredType::NATIVE_FLOAT, storage);
+		for (size_t arrayct = 0; arrayct < LLArrays.size(); arrayct++){
+			string dataPath = string("/chan_1/") + LLNames[arrayct];
+			vector2h5array<USHORT>(LLArrays[arrayct], &H5StateFile, dataPath, dataPath, dt, storage);
+		}
+		result.fileSize = H5StateFile.getFileSize();
+	}
+	result.writeTime = std::chrono::duration<double>(BenchClock::now() - start).count();
+
+	H5::H5File H5StateFile(fileName, H5F_ACC_RDONLY);
+	start = BenchClock::now();
+	vector<float> waveformIn = h5array2vector<float>(&H5StateFile, "/chan_1/waveformLib", H5::PredType::NATIVE_FLOAT);
+	for (size_t arrayct = 0; arrayct < LLArrays.size(); arrayct++){
+		WordVec arrayIn = h5array2vector<USHORT>(&H5StateFile, string("/chan_1/") + LLNames[arrayct], dt);
+		if (arrayIn != LLArrays[arrayct]){
+			cout << "HDF5 storage: read back of " << LLNames[arrayct] << " differs" << endl;
+		}
+	}
+	result.readTime = std::chrono::duration<double>(BenchClock::now() - start).count();
+
+	start = BenchClock::now();
+	WordVec rangeBuffer;
+	for (size_t arrayct = 0; arrayct < LLArrays.size(); arrayct++){
+		H5::DataSet LLSet = H5StateFile.openDataSet(string("/chan_1/") + LLNames[arrayct]);
+		for (size_t offset = 0; offset < LLArrays[arrayct].size(); offset += LL_DISK_CHUNK_LENGTH){
+			size_t count = std::min(LL_DISK_CHUNK_LENGTH, LLArrays[arrayct].size() - offset);
+			h5range2vector<USHORT>(LLSet, offset, count, rangeBuffer, dt);
+		}
+	}
+	result.rangeReadTime = std::chrono::duration<double>(BenchClock::now() - start).count();
+	H5StateFile.close();
+	std::remove(fileName.c_str());
+	return result;
+}
+
+int bench_h5_storage(const size_t & numEntries){
+	vector<WordVec> LLArrays(5);
+	make_LL(numEntries, LLArrays[0], LLArrays[1], LLArrays[2], LLArrays[3], LLArrays[4]);
+
+	vector<float> waveform = make_waveform();
+
+	const std::pair<const char *, H5Storage> layouts[] = {
+			{"contiguous", H5_CONTIGUOUS},
+			{"chunked", H5Storage{H5_STATE_CHUNK_LENGTH, 0, false}},
+			{"deflate", H5Storage{H5_STATE_CHUNK_LENGTH, H5_STATE_DEFLATE_LEVEL, false}},
+			{"shuffle+deflate", H5_STATE_STORAGE}
+	};
+	cout << "HDF5 storage " << numEntries << " LL entries + " << waveform.size() << " samples" << endl;
+	cout << "   layout, write ms, read ms, range read ms, file bytes" << endl;
+	for (auto layout : layouts){
+		H5BenchResult result = time_h5_storage("bench_storage.h5", layout.second, LLArrays, waveform);
+		cout << "   " << layout.first << ", " << 1e3*result.writeTime << ", " << 1e3*result.readTime << ", "
+				<< 1e3*result.rangeReadTime << ", " << result.fileSize << endl;
+	}
+	return 0;
+}
+
+int bench_kernels(){
+	/*
+	 * Microbenchmarks of the host side hot paths on sequence sized data:
+	 * a full waveform library (MAX_WF_LENGTH samples) and LLs from one device bank up to the host limit
+	 */
+	cout << "kernel, elements, ns/element, GB/s" << endl;
+
+	vector<float> waveform = make_waveform();
+	const size_t numPts = waveform.size();
+	WordVec wfWords(numPts);
+	std::transform(waveform.begin(), waveform.end(), wfWords.begin(), [](const float & val){return static_cast<USHORT>(static_cast<short>(MAX_WF_AMP*val));});
+
+	double time = time_kernel([&](){benchSink = FPGA::format(FPGA1, FPGA_BANKSEL_WF_CHA, wfWords).size();});
+	size_t packetSize = FPGA::format(FPGA1, FPGA_BANKSEL_WF_CHA, wfWords).size();
+	report_kernel("FPGA::format", numPts, sizeof(USHORT)*numPts + packetSize, time);
+
+	time = time_kernel([&](){benchSink = FPGA::computeCmdByteOffsets(numPts).size();});
+	report_kernel("FPGA::computeCmdByteOffsets", numPts, sizeof(size_t)*FPGA::computeCmdByteOffsets(numPts).size(), time);
+
+	Channel channel(0);
+	time = time_kernel([&](){benchSink = channel.set_waveform(waveform);});
+	report_kernel("Channel::set_waveform_float", numPts, 2*sizeof(float)*numPts, time);
+
+	time = time_kernel([&](){benchSink = channel.prep_waveform().size();});
+	report_kernel("Channel::prep_waveform", numPts, (sizeof(float) + sizeof(short))*numPts, time);
+
+	vector<short> prepVec;
+	time = time_kernel([&](){benchSink = channel.set_waveform(waveform.data(), numPts, 1, ELEMENT_FLOAT32, prepVec);});
+	report_kernel("Channel::set_waveform_strided_float", numPts, (2*sizeof(float) + sizeof(short))*numPts, time);
+
+	//Interleaved IQ int16 data as MATLAB or numpy hand it over
+	vector<short> IQData(2*numPts);
+	for (size_t ct = 0; ct < numPts; ct++){
+		IQData[2*ct] = static_cast<short>(MAX_WF_AMP*waveform[ct]);
+	}
+	time = time_kernel([&](){benchSink = channel.set_waveform(IQData.data(), numPts, 2, ELEMENT_INT16, prepVec);});
+	report_kernel("Channel::set_waveform_strided_int16", numPts, (sizeof(short) + sizeof(float) + sizeof(short))*numPts, time);
+
+	for (size_t numEntries : {MAX_LL_LENGTH, LL_PARALLEL_THRESHOLD, MAX_LL_HOST_LENGTH}){
+		WordVec addr, count, trigger1, trigger2, repeat;
+		make_LL(numEntries, addr, count, trigger1, trigger2, repeat);
+		const size_t LLLength = addr.size();
+		const size_t LLBytes = 5*sizeof(USHORT)*LLLength;
+
+		//The constructor takes the arrays by value so copy them outside the timed region and time init_data
+		double bestTime = std::numeric_limits<double>::max();
+		const int numReps = (LLLength < LL_PARALLEL_THRESHOLD) ? 50 : 5;
+		for (int repct = 0; repct < numReps; repct++){
+			WordVec addrCopy(addr), countCopy(count), trigger1Copy(trigger1), trigger2Copy(trigger2), repeatCopy(repeat);
+			BenchClock::time_point start = BenchClock::now();
+			LLBank bank(std::move(addrCopy), std::move(countCopy), std::move(trigger1Copy), std::move(trigger2Copy), std::move(repeatCopy));
+			bestTime = std::min(bestTime, std::chrono::duration<double>(BenchClock::now() - start).count());
+			benchSink = bank.length;
+		}
+		report_kernel("LLBank::init_data", LLLength, 2*LLBytes, bestTime);
+
+		LLBank bank(addr, count, trigger1, trigger2, repeat);
+		time = time_kernel([&](){benchSink = bank.get_packed_data(0, bank.length).size();});
+		report_kernel("LLBank::get_packed_data", LLLength, 2*LLBytes, time);
+	}
+
+	//The SPI writes of a PLL, VCXO and DAC setup: PLL and DAC writes are 3 and 2 bytes; VCXO writes are 4 bytes
+	vector<vector<UCHAR>> SPIWords;
+	for (int ct = 0; ct < 64; ct++){
+		SPIWords.push_back({UCHAR((ct >> 8) & 0x1F), UCHAR(ct & 0xFF), UCHAR(3*ct)});
+		SPIWords.push_back({UCHAR(ct & 0x1F), UCHAR(5*ct)});
+	}
+	SPIWords.push_back({0x8C, 0xF7, 0x00, 0x00});
+	SPIWords.push_back({0x8C, 0xF7, 0x00, 0x01});
+	size_t SPIBytes = 0;
+	for (auto & word : SPIWords){
+		SPIBytes += word.size() + FPGA::serialize_SPI(APS_PLL_SPI, word).size();
+	}
+	time = time_kernel([&](){
+		for (auto & word : SPIWords){
+			benchSink = FPGA::serialize_SPI(APS_PLL_SPI, word).size();
+		}
+	});
+	report_kernel("FPGA::serialize_SPI", SPIWords.size(), SPIBytes, time);
+
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	FILELog::ReportingLevel() = logWARNING;
+
+	size_t numEntries = (argc > 1) ? atol(argv[1]) : (1 << 20);
+	string suite = (argc > 2) ? argv[2] : "all";
+	int status = 0;
+	if (suite == "all" || suite == "kernels"){
+		status |= bench_kernels();
+	}
+	if (suite == "all" || suite == "LL"){
+		status |= bench_LLBank_build(numEntries);
+	}
+	if (suite == "all" || suite == "h5"){
+		status |= bench_h5_storage(numEntries);
+	}
+	return status;
+}
@@ -15,11 +15,33 @@ static const int  APS_WAVEFORM_UNIT_LENGTH = 4;
 
 static const int  MAX_APS_DEVICES = 10;
 
+//Async operation results kept for op_result before the oldest finished ones are dropped
+static const size_t MAX_ASYNC_OPS = 1024;
+
 static const int MAX_WF_LENGTH = 32768;
 static const int MAX_WF_AMP = 8191;
 static const int WF_MODULUS = 4;
 static const size_t MAX_LL_LENGTH = 8192;
 
+//LL banks longer than this are kept on disk and streamed through a prefetch cache
+static const size_t MAX_LL_HOST_LENGTH = (1 << 20);
+static const size_t LL_DISK_CHUNK_LENGTH = MAX_LL_LENGTH;
+static const size_t LL_PREFETCH_CHUNKS = 8;
+
+//In double buffered mode a sequence switch leaves the already queued miniLLs the device could start on before
+//the new LL is written to play out, so it never reads an entry while it is being overwritten. The streaming thread
+//works that number out from the miniLL rate and its poll to write latency (see BankBouncerThread::run) and keeps
+//this many more on top: the miniLL after the one the poll saw playing may already be underway when the poll returns
+static const size_t SWITCH_GUARD_MINILLS = 1;
+static const int SWITCH_TIMEOUT_MS = 1000;
+
+//State datasets are chunked along the LL so a disk chunk of entries is one HDF5 chunk
+static const size_t H5_STATE_CHUNK_LENGTH = LL_DISK_CHUNK_LENGTH;
+static const int H5_STATE_DEFLATE_LEVEL = 4;
+
+//LL banks at least this long are scanned and packed on all cores
+static const size_t LL_PARALLEL_THRESHOLD = (1 << 16);
+
 static const int APS_READTIMEOUT = 1000;
 static const int APS_WRITETIMEOUT = 500;
 
@@ -141,5 +163,8 @@ typedef enum {LED_PLL_SYNC=1, LED_RUNNING} LED_MODE;
 
 typedef enum {RUN_WAVEFORM=0, RUN_SEQUENCE} RUN_MODE;
 
+//Element types accepted by the strided C API entry points
+typedef enum {ELEMENT_INT16=0, ELEMENT_FLOAT32, ELEMENT_FLOAT64} ELEMENT_TYPE;
+
 
 #endif /* CONSTANTS_H_ */
@@ -0,0 +1,437 @@
+/*
+ * ftd2xx_sim.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "headings.h"
+#include "ftd2xx_sim.h"
+
+#include <array>
+#include <cstring>
+
+namespace {
+
+typedef std::chrono::steady_clock SimClock;
+
+double env_double(const char * name, const double & defaultValue){
+	const char * value = getenv(name);
+	return (value != nullptr) ? atof(value) : defaultValue;
+}
+
+struct SimParams {
+	int numDevices;
+	double bandwidth;
+	double writeLatency;
+	double readLatency;
+};
+
+const SimParams & sim_params(){
+	static const SimParams params = {static_cast<int>(env_double("APS_SIM_DEVICES", 1)), env_double("APS_SIM_BANDWIDTH", 30e6),
+			env_double("APS_SIM_WRITE_LATENCY", 125e-6), env_double("APS_SIM_READ_LATENCY", 1e-3)};
+	return params;
+}
+
+std::atomic<uint64_t> bytesWritten{0}, bytesRead{0}, numWrites{0}, numReads{0}, busyNs{0};
+
+//State machine clock when running at 1200 MS/s
+const double SM_CLOCK = 300e6;
+const USHORT END_MINILL_BIT = (1 << 14);
+//Words per IQ mode LL entry; the repeat word is last
+const size_t LL_ENTRY_WORDS = 5;
+
+struct SimFPGA {
+	SimFPGA() : configured{false}, readAddr{0}, writeAddr{0}, wordCt{0}, expectCount{false}, LLRepeat(MAX_LL_LENGTH, 0),
+		running{false}, triggersPlayed{0}, triggerInMiniLL{0}, curMiniLLStart{0} {};
+
+	bool configured;
+	//CSR bank registers
+	map<uint32_t, USHORT> registers;
+
+	//Block write in progress: an address, then a word count, then data to consecutive addresses
+	uint32_t readAddr;
+	uint32_t writeAddr;
+	size_t wordCt;
+	bool expectCount;
+
+	//Only the repeat words of the LL are needed to play it back
+	WordVec LLRepeat;
+	bool running;
+	SimClock::time_point playStart;
+	uint64_t triggersPlayed;
+	uint64_t triggerInMiniLL;
+	size_t curMiniLLStart;
+
+	void write_word(const USHORT & word, const SimClock::time_point & now){
+		if (expectCount){
+			expectCount = false;
+			return;
+		}
+		uint32_t bank = writeAddr & 0x70000000;
+		uint32_t offset = writeAddr & 0x0FFFFFFF;
+		if (bank == FPGA_BANKSEL_CSR){
+			uint32_t regAddr = offset + wordCt;
+			if (regAddr == FPGA_ADDR_CSR){
+				bool release = (word & CSRMSK_CHA_SMRSTN) != 0;
+				if (release && !running){
+					playStart = now;
+					triggersPlayed = 0;
+					triggerInMiniLL = 0;
+					curMiniLLStart = 0;
+				}
+				running = release;
+			}
+			registers[regAddr] = word;
+		}
+		else if (bank == FPGA_BANKSEL_LL_CHA && (wordCt % LL_ENTRY_WORDS) == LL_ENTRY_WORDS-1){
+			LLRepeat[(offset + wordCt/LL_ENTRY_WORDS) % MAX_LL_LENGTH] = word;
+		}
+		wordCt++;
+	}
+
+	void advance_playback(const SimClock::time_point & now){
+		/*
+		 * Each trigger plays a miniLL (miniLLRepeat+1 times) from the LL memory, wrapping at the LL length register
+		 * Triggers come at the trigger interval register rate
+		 */
+		if (!running) return;
+		uint64_t cycles = (static_cast<uint64_t>(registers[FPGA_ADDR_TRIG_INTERVAL]) << 16) + registers[FPGA_ADDR_TRIG_INTERVAL+1] + 2;
+		uint64_t numTriggers = std::chrono::duration<double>(now - playStart).count()*SM_CLOCK/cycles;
+		triggerInMiniLL += numTriggers - triggersPlayed;
+		triggersPlayed = numTriggers;
+		uint64_t triggersPerMiniLL = static_cast<uint64_t>(registers[FPGA_ADDR_LL_REPEAT]) + 1;
+		//Playing more than a memory's worth between polls looks the same to the host so cap the work
+		uint64_t numMiniLLs = std::min<uint64_t>(triggerInMiniLL / triggersPerMiniLL, MAX_LL_LENGTH);
+		triggerInMiniLL %= triggersPerMiniLL;
+		size_t LLLength = std::min<size_t>(registers[FPGA_ADDR_CHA_LL_LENGTH] + 1, MAX_LL_LENGTH);
+		for (uint64_t miniLLct = 0; miniLLct < numMiniLLs; miniLLct++){
+			size_t entry = curMiniLLStart;
+			for (size_t ct = 0; ct < LLLength && !(LLRepeat[entry] & END_MINILL_BIT); ct++){
+				entry = (entry + 1) % LLLength;
+			}
+			curMiniLLStart = (entry + 1) % LLLength;
+		}
+	}
+
+	USHORT read_register(const SimClock::time_point & now){
+		switch (readAddr){
+		case FPGA_ADDR_VERSION:
+			return configured ? FIRMWARE_VERSION : 0;
+		case FPGA_ADDR_PLL_STATUS:
+			//Everything locked and the XORs low
+			return (1 << PLL_02_LOCK_BIT) | (1 << PLL_13_LOCK_BIT) | (1 << REFERENCE_PLL_LOCK_BIT);
+		case FPGA_ADDR_A_PHASE:
+		case FPGA_ADDR_B_PHASE:
+			return 0;
+		case FPGA_ADDR_CHA_LL_CURADDR:
+		case FPGA_ADDR_CHB_LL_CURADDR:
+		case FPGA_ADDR_CHA_MINILLSTART:
+			advance_playback(now);
+			return static_cast<USHORT>(curMiniLLStart);
+		default:
+			return registers[readAddr];
+		}
+	}
+};
+
+class SimDevice {
+public:
+	SimDevice(const int & deviceID) : isOpen{false}, confStat_{0xF}, statusCtrl_{0}, SPIReadData_{0}, busyUntil_(SimClock::now()) {
+		char serial[16];
+		snprintf(serial, sizeof(serial), "SIM%04d", deviceID);
+		serial_ = serial;
+		PLLRegisters_.fill(0);
+		for (auto & regs : DACRegisters_) regs.fill(0);
+	};
+
+	bool isOpen;
+	const string & serial() const {return serial_;};
+
+	DWORD write(const UCHAR * data, const DWORD & numBytes){
+		std::lock_guard<std::mutex> guard(lock_);
+		wait_for_bus(sim_params().writeLatency, numBytes);
+		pending_.insert(pending_.end(), data, data + numBytes);
+		parse();
+		return numBytes;
+	}
+
+	DWORD read(UCHAR * data, const DWORD & numBytes){
+		std::lock_guard<std::mutex> guard(lock_);
+		wait_for_bus(sim_params().readLatency, numBytes);
+		//A real read would wait for the timeout if the device had less to say
+		DWORD numRead = std::min<size_t>(numBytes, readBuffer_.size());
+		std::copy(readBuffer_.begin(), readBuffer_.begin() + numRead, data);
+		readBuffer_.erase(readBuffer_.begin(), readBuffer_.begin() + numRead);
+		return numRead;
+	}
+
+private:
+	std::mutex lock_;
+	string serial_;
+	SimFPGA fpgas_[2];
+	UCHAR confStat_;
+	UCHAR statusCtrl_;
+	std::array<UCHAR, 0x300> PLLRegisters_;
+	std::array<std::array<UCHAR, 32>, 4> DACRegisters_;
+	UCHAR SPIReadData_;
+	//Host to device bytes not yet making up a whole command
+	vector<UCHAR> pending_;
+	std::deque<UCHAR> readBuffer_;
+	SimClock::time_point busyUntil_;
+
+	void wait_for_bus(const double & latency, const DWORD & numBytes){
+		//Transfers queue up behind each other on the bus
+		double cost = latency + numBytes / sim_params().bandwidth;
+		SimClock::time_point start = std::max(SimClock::now(), busyUntil_);
+		busyUntil_ = start + std::chrono::duration_cast<SimClock::duration>(std::chrono::duration<double>(cost));
+		busyNs.fetch_add(static_cast<uint64_t>(1e9*cost), std::memory_order_relaxed);
+		std::this_thread::sleep_until(busyUntil_);
+	}
+
+	template <typename F>
+	void for_each_fpga(const int & chipSelect, F op){
+		if (chipSelect & FPGA1) op(fpgas_[0]);
+		if (chipSelect & FPGA2) op(fpgas_[1]);
+	}
+
+	static size_t packet_length(const UCHAR & command){
+		//Command byte plus what follows it for each command type
+		if (command & 0x80) return 1;
+		switch (command & APS_CMD){
+		case APS_FPGA_IO: return 1 + (1 << (command & 0x3));
+		case APS_FPGA_ADDR: return 1 + 4;
+		case APS_DAC_SPI: return 1 + 8*2;
+		case APS_PLL_SPI: return 1 + 8*3;
+		case APS_VCXO_SPI: return 1 + 8*4;
+		case APS_CONF_DATA: return 1 + 61;
+		default: return 1 + 1;
+		}
+	}
+
+	void parse(){
+		size_t idx = 0;
+		SimClock::time_point now = SimClock::now();
+		while (idx < pending_.size()){
+			size_t packetLength = packet_length(pending_[idx]);
+			if (idx + packetLength > pending_.size()) break;
+			execute(&pending_[idx], now);
+			idx += packetLength;
+		}
+		pending_.erase(pending_.begin(), pending_.begin() + idx);
+	}
+
+	void execute(const UCHAR * packet, const SimClock::time_point & now){
+		const UCHAR command = packet[0];
+		const int chipSelect = (command >> 2) & 0x3;
+		if (command & 0x80){
+			execute_read(command, chipSelect, now);
+			return;
+		}
+		switch (command & APS_CMD){
+		case APS_FPGA_ADDR: {
+			uint32_t addr = (packet[1] << 24) | (packet[2] << 16) | (packet[3] << 8) | packet[4];
+			for_each_fpga(chipSelect, [&](SimFPGA & fpga){
+				if (addr & FPGA_ADDR_REGREAD){
+					fpga.readAddr = addr & ~FPGA_ADDR_REGREAD;
+				}
+				else {
+					fpga.writeAddr = addr;
+					fpga.wordCt = 0;
+					fpga.expectCount = true;
+				}
+			});
+			break;
+		}
+		case APS_FPGA_IO:
+			for (size_t ct = 1; ct < packet_length(command); ct += 2){
+				USHORT word = (packet[ct] << 8) | packet[ct+1];
+				for_each_fpga(chipSelect, [&](SimFPGA & fpga){ fpga.write_word(word, now); });
+			}
+			break;
+		case APS_DAC_SPI:
+		case APS_PLL_SPI:
+			execute_SPI(packet, command, chipSelect);
+			break;
+		case APS_CONF_DATA:
+			for_each_fpga(chipSelect, [](SimFPGA & fpga){ fpga.configured = true; });
+			break;
+		case APS_CONF_STAT: {
+			UCHAR value = packet[1] & 0xF;
+			//Pulling PGM low clears the configuration
+			if (!(value & APS_PGM01_BIT)) fpgas_[0].configured = false;
+			if (!(value & APS_PGM23_BIT)) fpgas_[1].configured = false;
+			confStat_ = value;
+			break;
+		}
+		case APS_STATUS_CTRL:
+			statusCtrl_ = packet[1];
+			break;
+		default:
+			//The VCXO isn't modelled
+			break;
+		}
+	}
+
+	void execute_SPI(const UCHAR * packet, const UCHAR & command, const int & chipSelect){
+		//Deserialize the bits from bit 0 of each byte
+		UCHAR bytes[3] = {0, 0, 0};
+		size_t numBytes = (packet_length(command) - 1) / 8;
+		for (size_t ct = 0; ct < 8*numBytes; ct++){
+			bytes[ct/8] = (bytes[ct/8] << 1) | (packet[1+ct] & 1);
+		}
+		bool isRead = bytes[0] & 0x80;
+		UCHAR * reg;
+		if ((command & APS_CMD) == APS_DAC_SPI){
+			reg = &DACRegisters_[chipSelect][bytes[0] & 0x1F];
+		}
+		else {
+			reg = &PLLRegisters_[(((bytes[0] & 0x1F) << 8) | bytes[1]) % PLLRegisters_.size()];
+		}
+		if (isRead){
+			SPIReadData_ = *reg;
+		}
+		else {
+			*reg = bytes[numBytes-1];
+		}
+	}
+
+	void execute_read(const UCHAR & command, const int & chipSelect, const SimClock::time_point & now){
+		switch (command & APS_CMD){
+		case APS_FPGA_IO: {
+			USHORT value = fpgas_[(chipSelect == FPGA2) ? 1 : 0].read_register(now);
+			readBuffer_.push_back(value >> 8);
+			readBuffer_.push_back(value & 0xFF);
+			break;
+		}
+		case APS_CONF_STAT: {
+			UCHAR status = confStat_;
+			if (confStat_ & APS_PGM01_BIT) status |= APS_INIT01_BIT | (fpgas_[0].configured ? APS_DONE01_BIT : 0);
+			if (confStat_ & APS_PGM23_BIT) status |= APS_INIT23_BIT | (fpgas_[1].configured ? APS_DONE23_BIT : 0);
+			readBuffer_.push_back(status);
+			break;
+		}
+		case APS_STATUS_CTRL:
+			readBuffer_.push_back(statusCtrl_);
+			break;
+		case APS_DAC_SPI:
+		case APS_PLL_SPI:
+			readBuffer_.push_back(SPIReadData_);
+			break;
+		default:
+			readBuffer_.push_back(0);
+			break;
+		}
+	}
+};
+
+vector<std::unique_ptr<SimDevice>> & sim_devices(){
+	static vector<std::unique_ptr<SimDevice>> devices = [](){
+		vector<std::unique_ptr<SimDevice>> devices;
+		for (int ct = 0; ct < sim_params().numDevices; ct++){
+			devices.emplace_back(new SimDevice(ct));
+		}
+		return devices;
+	}();
+	return devices;
+}
+
+} //end anonymous namespace
+
+extern "C" {
+
+FT_STATUS WINAPI FT_Open(int deviceNumber, FT_HANDLE * pHandle){
+	if (deviceNumber < 0 || deviceNumber >= static_cast<int>(sim_devices().size())){
+		return FT_DEVICE_NOT_FOUND;
+	}
+	SimDevice * device = sim_devices()[deviceNumber].get();
+	device->isOpen = true;
+	*pHandle = device;
+	return FT_OK;
+}
+
+FT_STATUS WINAPI FT_Close(FT_HANDLE ftHandle){
+	if (ftHandle == nullptr) return FT_INVALID_HANDLE;
+	static_cast<SimDevice *>(ftHandle)->isOpen = false;
+	return FT_OK;
+}
+
+FT_STATUS WINAPI FT_Write(FT_HANDLE ftHandle, LPVOID lpBuffer, DWORD nBufferSize, LPDWORD lpBytesWritten){
+	if (ftHandle == nullptr) return FT_INVALID_HANDLE;
+	*lpBytesWritten = static_cast<SimDevice *>(ftHandle)->write(static_cast<const UCHAR *>(lpBuffer), nBufferSize);
+	bytesWritten.fetch_add(*lpBytesWritten, std::memory_order_relaxed);
+	numWrites.fetch_add(1, std::memory_order_relaxed);
+	return FT_OK;
+}
+
+FT_STATUS WINAPI FT_Read(FT_HANDLE ftHandle, LPVOID lpBuffer, DWORD nBufferSize, LPDWORD lpBytesReturned){
+	if (ftHandle == nullptr) return FT_INVALID_HANDLE;
+	*lpBytesReturned = static_cast<SimDevice *>(ftHandle)->read(static_cast<UCHAR *>(lpBuffer), nBufferSize);
+	bytesRead.fetch_add(*lpBytesReturned, std::memory_order_relaxed);
+	numReads.fetch_add(1, std::memory_order_relaxed);
+	return FT_OK;
+}
+
+FT_STATUS WINAPI FT_ListDevices(PVOID pArg1, PVOID pArg2, DWORD Flags){
+	if (!(Flags & FT_LIST_NUMBER_ONLY)) return FT_NOT_SUPPORTED;
+	*static_cast<DWORD *>(pArg1) = sim_devices().size();
+	return FT_OK;
+}
+
+FT_STATUS WINAPI FT_CreateDeviceInfoList(LPDWORD lpdwNumDevs){
+	*lpdwNumDevs = sim_devices().size();
+	return FT_OK;
+}
+
+FT_STATUS WINAPI FT_GetDeviceInfoList(FT_DEVICE_LIST_INFO_NODE * pDest, LPDWORD lpdwNumDevs){
+	*lpdwNumDevs = sim_devices().size();
+	for (size_t ct = 0; ct < sim_devices().size(); ct++){
+		SimDevice * device = sim_devices()[ct].get();
+		memset(&pDest[ct], 0, sizeof(FT_DEVICE_LIST_INFO_NODE));
+		pDest[ct].Flags = device->isOpen ? FT_FLAGS_OPENED : 0;
+		pDest[ct].LocId = ct;
+		strncpy(pDest[ct].SerialNumber, device->serial().c_str(), sizeof(pDest[ct].SerialNumber)-1);
+		strncpy(pDest[ct].Description, "APS simulator", sizeof(pDest[ct].Description)-1);
+		pDest[ct].ftHandle = device->isOpen ? device : nullptr;
+	}
+	return FT_OK;
+}
+
+FT_STATUS WINAPI FT_GetDeviceInfoDetail(DWORD dwIndex, LPDWORD lpdwFlags, LPDWORD lpdwType, LPDWORD lpdwID, LPDWORD lpdwLocId,
+		LPVOID lpSerialNumber, LPVOID lpDescription, FT_HANDLE * pftHandle){
+	if (dwIndex >= sim_devices().size()) return FT_DEVICE_NOT_FOUND;
+	SimDevice * device = sim_devices()[dwIndex].get();
+	*lpdwFlags = device->isOpen ? FT_FLAGS_OPENED : 0;
+	*lpdwType = 0;
+	*lpdwID = 0;
+	*lpdwLocId = dwIndex;
+	strncpy(static_cast<char *>(lpSerialNumber), device->serial().c_str(), 16);
+	strncpy(static_cast<char *>(lpDescription), "APS simulator", 64);
+	*pftHandle = device->isOpen ? device : nullptr;
+	return FT_OK;
+}
+
+FT_STATUS WINAPI FT_SetTimeouts(FT_HANDLE ftHandle, ULONG ReadTimeout, ULONG WriteTimeout){
+	return (ftHandle == nullptr) ? FT_INVALID_HANDLE : FT_OK;
+}
+
+FT_STATUS WINAPI FT_SetLatencyTimer(FT_HANDLE ftHandle, UCHAR ucLatency){
+	return (ftHandle == nullptr) ? FT_INVALID_HANDLE : FT_OK;
+}
+
+void FT_SimGetCounters(FTSimCounters * counters){
+	counters->bytesWritten = bytesWritten.load();
+	counters->bytesRead = bytesRead.load();
+	counters->writes = numWrites.load();
+	counters->reads = numReads.load();
+	counters->busyTime = 1e-9*busyNs.load();
+}
+
+void FT_SimResetCounters(){
+	bytesWritten = 0;
+	bytesRead = 0;
+	numWrites = 0;
+	numReads = 0;
+	busyNs = 0;
+}
+
+} //end extern "C"
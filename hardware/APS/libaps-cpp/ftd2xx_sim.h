@@ -0,0 +1,45 @@
+/*
+ * ftd2xx_sim.h
+ *
+ * A simulated FTDI driver for running libaps with no APS attached.
+ * ftd2xx_sim.cpp implements the FT_* calls libaps uses on top of a model of the APS: the
+ * FPGA configuration port, the FPGA registers, the PLL/DAC/VCXO SPI registers and LL playback.
+ * Every transfer is delayed by a per-transfer latency plus its size over the USB bandwidth so
+ * timings look like a real device. Link it in place of -lftd2xx.
+ *
+ * The model is configured from the environment before the first FT_* call:
+ *   APS_SIM_DEVICES        number of simulated devices (default 1)
+ *   APS_SIM_BANDWIDTH      USB bandwidth in bytes/s (default 30e6)
+ *   APS_SIM_WRITE_LATENCY  latency of each FT_Write in s (default 125e-6)
+ *   APS_SIM_READ_LATENCY   latency of each FT_Read in s, i.e. a round trip (default 1e-3)
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef FTD2XX_SIM_H_
+#define FTD2XX_SIM_H_
+
+#include <cstdint>
+
+struct FTSimCounters {
+	uint64_t bytesWritten;
+	uint64_t bytesRead;
+	uint64_t writes;
+	uint64_t reads;
+	//Time the simulated bus was busy in s
+	double busyTime;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//Totals over all simulated devices
+void FT_SimGetCounters(FTSimCounters *);
+void FT_SimResetCounters();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FTD2XX_SIM_H_ */
@@ -19,12 +19,17 @@
 #include <fstream>
 #include <iomanip>
 #include <stdio.h>
+#include <cstdint>
 #include <map>
 //#include <math.h>
 #include <cmath>
 #include <stdexcept>
 #include <algorithm>
+#include <functional>
+#include <limits>
+#include <numeric>
 #include <queue>
+#include <deque>
 using std::vector;
 using std::string;
 using std::cout;
@@ -34,9 +39,11 @@ using std::runtime_error;
 
 #include <thread>
 #include <mutex>
+#include <future>
 #include <atomic>
 #include <utility>
 #include <chrono>
+#include <memory>
 
 
 /*boost thread
@@ -48,6 +55,15 @@ using boost::thread;
 //HDF5 library
 #include "H5Cpp.h"
 
+//The HDF5 C++ library is not thread safe so anything that opens, reads, writes or closes an H5 object holds this
+//process wide lock; recursive so the file level calls can hold it across the channel and LL bank readers.
+//Take it after any device lock and never hold it while waiting on another thread that wants it.
+inline std::recursive_mutex & hdf5_mutex(){
+	static std::recursive_mutex mutex;
+	return mutex;
+}
+typedef std::lock_guard<std::recursive_mutex> HDF5Lock;
+
 //Needed for usleep on gcc 4.7
 #include <unistd.h>
 
@@ -86,17 +102,24 @@ typedef std::pair<ULONG, UCHAR> PLLAddrData;
 
 //some vectors
 typedef vector<unsigned short> WordVec;
+typedef vector<size_t> IdxVec;
 
 //Load all the constants
 #include "constants.h"
 
+#include "PerfStats.h"
+#include "Trace.h"
+
 #include "FTDI.h"
 #include "FPGA.h"
 
 #include "LLBank.h"
 #include "Channel.h"
 #include "BankBouncerThread.h"
+#include "LLFileSource.h"
+#include "CompiledSequence.h"
 #include "APS.h"
+#include "AsyncWorker.h"
 #include "APSRack.h"
 
 
@@ -110,6 +133,39 @@ myhex(std::ios_base& __base)
 }
 
 
+//Storage layout for datasets written with vector2h5array
+//A chunkLength of 0 gives a contiguous dataset; deflate and shuffle need a chunked one
+struct H5Storage {
+	hsize_t chunkLength;
+	int deflateLevel;
+	bool shuffle;
+};
+static const H5Storage H5_CONTIGUOUS = {0, 0, false};
+static const H5Storage H5_STATE_STORAGE = {H5_STATE_CHUNK_LENGTH, H5_STATE_DEFLATE_LEVEL, true};
+
+//Dataset creation properties for a numRows x 1 dataset
+inline H5::DSetCreatPropList h5_create_props(const hsize_t & numRows, const H5Storage & storage){
+	H5::DSetCreatPropList props;
+	//Chunks can't be empty or bigger than a fixed size dataset
+	if (storage.chunkLength == 0 || numRows == 0){
+		return props;
+	}
+	hsize_t chunkDims[] = {std::min(storage.chunkLength, numRows), 1};
+	props.setChunk(2, chunkDims);
+	if (storage.shuffle){
+		props.setShuffle();
+	}
+	if (storage.deflateLevel > 0){
+		if (H5Zfilter_avail(H5Z_FILTER_DEFLATE) > 0){
+			props.setDeflate(storage.deflateLevel);
+		}
+		else{
+			FILE_LOG(logWARNING) << "HDF5 library has no deflate filter; writing uncompressed";
+		}
+	}
+	return props;
+}
+
 //Helper function for loading 1D dataset from H5 files
 template <typename T>
 vector<T> h5array2vector(const H5::H5File * h5File, const string & dataPath, const H5::DataType & dt = H5::PredType::NATIVE_DOUBLE)
@@ -122,7 +178,9 @@ vector<T> h5array2vector(const H5::H5File * h5File, const string & dataPath, con
    vector<T> vecOut(arraySpace.getSimpleExtentNpoints());
 
   // Read in data from file to memory
-   h5Array.read(&vecOut.front(), dt);
+   if (!vecOut.empty()){
+	   h5Array.read(&vecOut.front(), dt);
+   }
 
    arraySpace.close();
    h5Array.close();
@@ -130,9 +188,51 @@ vector<T> h5array2vector(const H5::H5File * h5File, const string & dataPath, con
    return vecOut;
  };
 
+//Read count elements starting at offset from an open dataset into vecOut
+//Lets callers walking through a dataset keep it open and reuse their buffers
+template <typename T>
+void h5range2vector(const H5::DataSet & h5Array, const hsize_t & offset, const hsize_t & count, vector<T> & vecOut, const H5::DataType & dt = H5::PredType::NATIVE_DOUBLE)
+ {
+   H5::DataSpace arraySpace = h5Array.getSpace();
+
+   // Select the hyperslab; datasets may be stored as N x 1 so keep any trailing dimensions whole
+   int rank = arraySpace.getSimpleExtentNdims();
+   vector<hsize_t> dims(rank), start(rank, 0), block(rank);
+   arraySpace.getSimpleExtentDims(&dims[0]);
+   block = dims;
+   start[0] = offset;
+   block[0] = count;
+   arraySpace.selectHyperslab(H5S_SELECT_SET, &block[0], &start[0]);
+
+   vecOut.resize(arraySpace.getSelectNpoints());
+   if (vecOut.empty()){
+	   arraySpace.close();
+	   return;
+   }
+   H5::DataSpace memSpace(rank, &block[0]);
+
+   h5Array.read(&vecOut.front(), dt, memSpace, arraySpace);
+
+   memSpace.close();
+   arraySpace.close();
+ };
+
+//Helper function for loading part of a 1D dataset from H5 files
+//Reads count elements starting at offset along the first dimension
+template <typename T>
+vector<T> h5array2vector(const H5::H5File * h5File, const string & dataPath, const hsize_t & offset, const hsize_t & count, const H5::DataType & dt = H5::PredType::NATIVE_DOUBLE)
+ {
+   H5::DataSet h5Array = h5File->openDataSet(dataPath);
+   vector<T> vecOut;
+   h5range2vector<T>(h5Array, offset, count, vecOut, dt);
+   h5Array.close();
+   return vecOut;
+ };
+
 //Helper function for saving 1D dataset from H5 files
 template <typename T>
-int vector2h5array(vector<T> & vectIn, const H5::H5File * h5File, const string & name, const string & dataPath, const H5::DataType & dt = H5::PredType::NATIVE_DOUBLE)
+int vector2h5array(vector<T> & vectIn, const H5::H5File * h5File, const string & name, const string & dataPath, const H5::DataType & dt = H5::PredType::NATIVE_DOUBLE,
+		const H5Storage & storage = H5_STATE_STORAGE)
  {
 
 	const int VECTOR_RANK = 2;
@@ -151,15 +251,37 @@ int vector2h5array(vector<T> & vectIn, const H5::H5File * h5File, const string &
 	// DataSpace on disk
 	H5::DataSpace fspace( VECTOR_RANK, fdim );
 
-	H5::DataSet h5Array = h5File->createDataSet(dataset_name,dt, fspace);
+	H5::DataSet h5Array = h5File->createDataSet(dataset_name,dt, fspace, h5_create_props(vectIn.size(), storage));
 
-	h5Array.write(&vectIn[0], dt);
+	if (!vectIn.empty()){
+		h5Array.write(&vectIn[0], dt);
+	}
 
 	h5Array.close();
 
 	return 0;
  };
 
+//Write vecIn to the rows starting at offset of an open numRows x 1 dataset
+//The counterpart of h5range2vector for callers writing a dataset a piece at a time
+template <typename T>
+void vector2h5range(const vector<T> & vecIn, const H5::DataSet & h5Array, const hsize_t & offset, const H5::DataType & dt = H5::PredType::NATIVE_DOUBLE)
+ {
+   if (vecIn.empty()){
+	   return;
+   }
+   H5::DataSpace arraySpace = h5Array.getSpace();
+   hsize_t start[] = {offset, 0};
+   hsize_t block[] = {vecIn.size(), 1};
+   arraySpace.selectHyperslab(H5S_SELECT_SET, block, start);
+   H5::DataSpace memSpace(2, block);
+
+   h5Array.write(&vecIn.front(), dt, memSpace, arraySpace);
+
+   memSpace.close();
+   arraySpace.close();
+ };
+
 template <typename T>
 int element2h5attribute(const string & name, T & element, const H5::Group * group, const H5::DataType & dt = H5::PredType::NATIVE_DOUBLE) {
 	hsize_t fdim[] = {1}; // dim sizes of ds (on disk)
@@ -190,6 +312,39 @@ inline int mymod(int a, int b) {
 	return c;
 }
 
+//Forward distance from b to a modulo n for unsigned indices (a, b < n)
+//LL indices can run well past 16 bits so avoid casting through int
+inline size_t moddiff(const size_t & a, const size_t & b, const size_t & n) {
+	return (a + n - b) % n;
+}
+
+//Walk a strided array of any ELEMENT_TYPE calling op(index, value) on each element
+//stride is in elements and may be negative; elements are indexed from data so no pointer is formed past the last one
+//returns -1 for an unknown type
+template <typename F>
+int for_each_strided(const void * data, const size_t & numPts, const ptrdiff_t & stride, const ELEMENT_TYPE & type, F op) {
+	switch (type) {
+	case ELEMENT_INT16: {
+		const short * src = static_cast<const short *>(data);
+		for (size_t ct = 0; ct < numPts; ct++) op(ct, static_cast<float>(src[static_cast<ptrdiff_t>(ct)*stride]));
+		return 0;
+	}
+	case ELEMENT_FLOAT32: {
+		const float * src = static_cast<const float *>(data);
+		for (size_t ct = 0; ct < numPts; ct++) op(ct, src[static_cast<ptrdiff_t>(ct)*stride]);
+		return 0;
+	}
+	case ELEMENT_FLOAT64: {
+		const double * src = static_cast<const double *>(data);
+		for (size_t ct = 0; ct < numPts; ct++) op(ct, static_cast<float>(src[static_cast<ptrdiff_t>(ct)*stride]));
+		return 0;
+	}
+	default:
+		FILE_LOG(logERROR) << "Unknown element type " << type;
+		return -1;
+	}
+}
+
 #endif /* HEADINGS_H_ */
 
 
@@ -12,6 +12,17 @@
 
 APSRack APSRack_;
 
+//Split the concatenated waveforms of several channels
+template <typename T>
+static vector<vector<T>> split_waveforms(const int & numChannels, const T * data, const int * numPts){
+	vector<vector<T>> waveforms;
+	for (int ct = 0; ct < numChannels; ct++){
+		waveforms.push_back(vector<T>(data, data+numPts[ct]));
+		data += numPts[ct];
+	}
+	return waveforms;
+}
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -23,6 +34,10 @@ int init(){
 	return APS_OK;
 }
 
+int cleanup(){
+	return APSRack_.cleanup();
+}
+
 int get_numDevices(){
 	return APSRack_.get_num_devices();
 }
@@ -55,12 +70,14 @@ int disconnect_by_serial(char * deviceSerial){
 }
 
 int serial2ID(char * deviceSerial){
-	if ( !APSRack_.serial2dev.count(deviceSerial)) {
-		// serial number not in map of known devices
-		return -1;
-	} 
+	// -1 if the serial number is not in the map of known devices
+	return APSRack_.serial2dev(string(deviceSerial));
+}
 
-	return APSRack_.serial2dev[string(deviceSerial)];
+//initAPS reports a missing bitfile separately from other failures
+static int init_error_code(const std::exception & e){
+	string error = e.what();
+	return (error.compare("Unable to open bitfile.") == 0) ? APS_FILE_ERROR : APS_UNKNOWN_ERROR;
 }
 
 //Initialize an APS unit
@@ -69,16 +86,67 @@ int initAPS(int deviceID, char * bitFile, int forceReload){
 	try {
 		return APSRack_.initAPS(deviceID, string(bitFile), forceReload);
 	} catch (std::exception& e) {
-		string error = e.what();
-		if (error.compare("Unable to open bitfile.") == 0) {
-			return APS_FILE_ERROR;
-		} else {
-			return APS_UNKNOWN_ERROR;
-		}
+		return init_error_code(e);
 	}
 
 }
 
+//The async versions run the blocking call on the device's worker with the device locked; arguments are copied before returning
+int init_async(int deviceID, char * bitFile, int forceReload){
+	string bitFileStr(bitFile);
+	return APSRack_.submit_async(deviceID, [=](APS & aps){
+		try {
+			return aps.init(bitFileStr, forceReload);
+		} catch (std::exception& e) {
+			return init_error_code(e);
+		}
+	});
+}
+
+int load_sequence_file_async(int deviceID, const char * seqFile){
+	string seqFileStr(seqFile);
+	return APSRack_.submit_async(deviceID, [=](APS & aps){ return aps.load_sequence_file(seqFileStr); });
+}
+
+int load_compiled_sequence_async(int deviceID, const char * compiledFile){
+	string compiledFileStr(compiledFile);
+	return APSRack_.submit_async(deviceID, [=](APS & aps){ return aps.load_compiled_sequence(compiledFileStr); });
+}
+
+int restore_to_device_async(int deviceID, const char * stateFile){
+	string stateFileStr(stateFile);
+	return APSRack_.submit_async(deviceID, [=](APS & aps){
+		string fileName(stateFileStr);
+		return aps.restore_to_device(fileName);
+	});
+}
+
+int set_waveform_float_async(int deviceID, int channelNum, float* data, int numPts){
+	vector<float> wf(data, data+numPts);
+	return APSRack_.submit_async(deviceID, [=](APS & aps){ return aps.set_waveform(channelNum, wf); });
+}
+
+int set_waveform_int_async(int deviceID, int channelNum, short* data, int numPts){
+	vector<short> wf(data, data+numPts);
+	return APSRack_.submit_async(deviceID, [=](APS & aps){ return aps.set_waveform(channelNum, wf); });
+}
+
+int op_poll(int opID){
+	return APSRack_.op_poll(opID);
+}
+
+int op_wait(int opID, int timeoutMS){
+	return APSRack_.op_wait(opID, timeoutMS);
+}
+
+int op_result(int opID){
+	return APSRack_.op_result(opID);
+}
+
+int op_discard(int opID){
+	return APSRack_.op_discard(opID);
+}
+
 int read_bitfile_version(int deviceID) {
 	return APSRack_.read_bitfile_version(deviceID);
 }
@@ -101,6 +169,18 @@ int set_waveform_int(int deviceID, int channelNum, short* data, int numPts){
 	return APSRack_.set_waveform(deviceID, channelNum, vector<short>(data, data+numPts));
 }
 
+int set_waveform_strided(int deviceID, int channelNum, const void * data, int numPts, int stride, int elementType){
+	return APSRack_.set_waveform_strided(deviceID, channelNum, data, numPts, stride, ELEMENT_TYPE(elementType));
+}
+
+int set_waveforms_float(int deviceID, int numChannels, int* channelNums, float* data, int* numPts){
+	return APSRack_.set_waveforms(deviceID, vector<int>(channelNums, channelNums+numChannels), split_waveforms(numChannels, data, numPts));
+}
+
+int set_waveforms_int(int deviceID, int numChannels, int* channelNums, short* data, int* numPts){
+	return APSRack_.set_waveforms(deviceID, vector<int>(channelNums, channelNums+numChannels), split_waveforms(numChannels, data, numPts));
+}
+
 int load_sequence_file(int deviceID, const char * seqFile){
 	try {
 		return APSRack_.load_sequence_file(deviceID, string(seqFile));
@@ -111,6 +191,45 @@ int load_sequence_file(int deviceID, const char * seqFile){
 	return APS_UNKNOWN_ERROR;
 }
 
+//Convert an H5 sequence file to the memory mappable compiled format
+int compile_sequence_file(const char * seqFile, const char * compiledFile){
+	try {
+		return APSRack_.compile_sequence_file(string(seqFile), string(compiledFile));
+	} catch (...) {
+		return APS_UNKNOWN_ERROR;
+	}
+	// should not reach this point
+	return APS_UNKNOWN_ERROR;
+}
+
+int load_compiled_sequence(int deviceID, const char * compiledFile){
+	try {
+		return APSRack_.load_compiled_sequence(deviceID, string(compiledFile));
+	} catch (...) {
+		return APS_UNKNOWN_ERROR;
+	}
+	// should not reach this point
+	return APS_UNKNOWN_ERROR;
+}
+
+int set_double_buffered(int deviceID, int enable){
+	return APSRack_.set_double_buffered(deviceID, enable);
+}
+
+int stage_sequence_file(int deviceID, const char * seqFile){
+	try {
+		return APSRack_.stage_sequence_file(deviceID, string(seqFile));
+	} catch (...) {
+		return APS_UNKNOWN_ERROR;
+	}
+	// should not reach this point
+	return APS_UNKNOWN_ERROR;
+}
+
+int switch_sequence(int deviceID){
+	return APSRack_.switch_sequence(deviceID);
+}
+
 int clear_channel_data(int deviceID) {
 	return APSRack_.clear_channel_data(deviceID);
 }
@@ -152,6 +271,27 @@ int set_logging_level(int logLevel){
 	return APSRack_.set_logging_level(logLevel);
 }
 
+int get_perf_stats(char * buffer, int bufferLength){
+	string stats = APSRack_.get_perf_stats();
+	if (buffer != nullptr && bufferLength > 0){
+		size_t strLen = stats.copy(buffer, bufferLength-1);
+		buffer[strLen] = '\0';
+	}
+	return stats.size();
+}
+
+int reset_perf_stats(){
+	return APSRack_.reset_perf_stats();
+}
+
+int enable_trace(int enable){
+	return APSRack_.enable_trace(enable != 0);
+}
+
+int export_trace(const char * traceFile){
+	return (APSRack_.export_trace(string(traceFile)) == 0) ? APS_OK : APS_FILE_ERROR;
+}
+
 int set_trigger_source(int deviceID, int triggerSource) {
 	return APSRack_.set_trigger_source(deviceID, TRIGGERSOURCE(triggerSource));
 }
@@ -178,6 +318,16 @@ int set_channel_offset(int deviceID, int channelNum, float offset){
 int set_channel_scale(int deviceID, int channelNum, float scale){
 	return APSRack_.set_channel_scale(deviceID, channelNum, scale);
 }
+int set_channel_params(int deviceID, int numChannels, int* channelNums, float* offsets, float* scales, int* enables){
+	vector<bool> enableVec;
+	if (enables != nullptr){
+		enableVec.assign(enables, enables+numChannels);
+	}
+	return APSRack_.set_channel_params(deviceID, vector<int>(channelNums, channelNums+numChannels),
+			(offsets != nullptr) ? vector<float>(offsets, offsets+numChannels) : vector<float>(),
+			(scales != nullptr) ? vector<float>(scales, scales+numChannels) : vector<float>(), enableVec);
+}
+
 int set_channel_enabled(int deviceID, int channelNum, int enable){
 	return APSRack_.set_channel_enabled(deviceID, channelNum, enable);
 }
@@ -199,6 +349,22 @@ int set_LL_data_IQ(int deviceID, int channelNum, int length, unsigned short* add
 			WordVec(trigger1, trigger1+length), WordVec(trigger2, trigger2+length), WordVec(repeat, repeat+length));
 }
 
+int set_LL_data_IQ_strided(int deviceID, int channelNum, int length, int stride, int elementType,
+		const void * addr, const void * count, const void * trigger1, const void * trigger2, const void * repeat){
+	//Convert each array straight into the vectors the LL bank keeps
+	vector<WordVec> LLData(5, WordVec(length));
+	const void * sources[] = {addr, count, trigger1, trigger2, repeat};
+	for (int arrayct = 0; arrayct < 5; arrayct++){
+		WordVec & dest = LLData[arrayct];
+		if (for_each_strided(sources[arrayct], length, stride, ELEMENT_TYPE(elementType),
+				[&dest](const size_t & ct, const float & val){ dest[ct] = static_cast<USHORT>(static_cast<int>(val)); }) != 0){
+			return APS_UNKNOWN_ERROR;
+		}
+	}
+	return APSRack_.set_LL_data(deviceID, channelNum, std::move(LLData[0]), std::move(LLData[1]),
+			std::move(LLData[2]), std::move(LLData[3]), std::move(LLData[4]));
+}
+
 int set_run_mode(int deviceID, int channelNum, int mode) {
 	return APSRack_.set_run_mode(deviceID, channelNum, RUN_MODE(mode));
 }
@@ -224,6 +390,28 @@ int read_bulk_state_file() {
 	return APSRack_.read_bulk_state_file(fileName);
 }
 
+int save_state_file(int deviceID, const char * stateFile){
+	try {
+		string fileName(stateFile);
+		return APSRack_.save_state_file(deviceID, fileName);
+	} catch (...) {
+		return APS_UNKNOWN_ERROR;
+	}
+	// should not reach this point
+	return APS_UNKNOWN_ERROR;
+}
+
+int restore_to_device(int deviceID, const char * stateFile){
+	try {
+		string fileName(stateFile);
+		return APSRack_.restore_to_device(deviceID, fileName);
+	} catch (...) {
+		return APS_UNKNOWN_ERROR;
+	}
+	// should not reach this point
+	return APS_UNKNOWN_ERROR;
+}
+
 int raw_write(int deviceID, int numBytes, UCHAR* data){
 	return APSRack_.raw_write(deviceID, numBytes, data);
 }
@@ -22,11 +22,17 @@ extern "C" {
 enum APSErrorCode {
 	APS_OK,
 	APS_UNKNOWN_ERROR = -1,
-	APS_FILE_ERROR = -2
+	APS_FILE_ERROR = -2,
+	APS_INVALID_OP = -3,
+	APS_OP_PENDING = -4,
+	APS_INVALID_DEVICE = -5
 };
 
 
 EXPORT int init();
+/* cleanup - stops every thread the library runs (async workers, streaming, logging); call it before
+ * unloading the library since they can't be stopped safely while it unloads. init starts things up again */
+EXPORT int cleanup();
 
 EXPORT int get_numDevices();
 EXPORT void get_deviceSerial(int, char *);
@@ -51,6 +57,8 @@ EXPORT int set_channel_scale(int, int, float);
 EXPORT float get_channel_scale(int, int);
 EXPORT int set_channel_enabled(int, int, int);
 EXPORT int get_channel_enabled(int, int);
+/* batch versions: NULL offsets, scales or enabled leave that setting alone */
+EXPORT int set_channel_params(int, int, int*, float*, float*, int*);
 
 EXPORT int set_trigger_source(int, int);
 EXPORT int get_trigger_source(int);
@@ -61,6 +69,13 @@ EXPORT int set_miniLL_repeat(int, unsigned short);
 
 EXPORT int set_waveform_float(int, int, float*, int);
 EXPORT int set_waveform_int(int, int, short*, int);
+/* strided, typed arrays: stride is in elements; elementType 0 = int16, 1 = float32, 2 = float64
+ * int16 waveforms are in DAC units, float waveforms are normalized to (-1, 1) */
+EXPORT int set_waveform_strided(int, int, const void*, int, int, int);
+EXPORT int set_LL_data_IQ_strided(int, int, int, int, int, const void*, const void*, const void*, const void*, const void*);
+/* waveforms for several channels concatenated in data with numPts points each */
+EXPORT int set_waveforms_float(int, int, int*, float*, int*);
+EXPORT int set_waveforms_int(int, int, int*, short*, int*);
 
 EXPORT int set_LL_data_IQ(int, int, int, unsigned short*, unsigned short*, unsigned short*, unsigned short*, unsigned short*);
 
@@ -68,6 +83,28 @@ EXPORT int set_run_mode(int, int, int);
 EXPORT int set_repeat_mode(int, int, int);
 
 EXPORT int load_sequence_file(int, const char*);
+EXPORT int compile_sequence_file(const char*, const char*);
+EXPORT int load_compiled_sequence(int, const char*);
+
+EXPORT int set_double_buffered(int, int);
+EXPORT int stage_sequence_file(int, const char*);
+EXPORT int switch_sequence(int);
+
+/* async versions return an operation ID (or a negative error code) straight away
+ * op_poll - 1 if finished, 0 if not; op_wait(opID, timeout ms; < 0 waits forever) - same after waiting
+ * op_result - the return code of the finished call and releases the ID; APS_OP_PENDING if not done
+ * op_discard - releases the ID without the result (the call still runs); only the newest MAX_ASYNC_OPS
+ * uncollected results are kept */
+EXPORT int init_async(int, char*, int);
+EXPORT int load_sequence_file_async(int, const char*);
+EXPORT int load_compiled_sequence_async(int, const char*);
+EXPORT int restore_to_device_async(int, const char*);
+EXPORT int set_waveform_float_async(int, int, float*, int);
+EXPORT int set_waveform_int_async(int, int, short*, int);
+EXPORT int op_poll(int);
+EXPORT int op_wait(int, int);
+EXPORT int op_result(int);
+EXPORT int op_discard(int);
 
 EXPORT int clear_channel_data(int);
 
@@ -79,12 +116,27 @@ EXPORT int get_running(int);
 EXPORT int set_log(char *);
 EXPORT int set_logging_level(int);
 
+/* performance counters for every device, as JSON (see PerfStats::to_json)
+ * get_perf_stats copies at most bufferLength-1 characters and returns the full length so a
+ * larger buffer can be passed if the result was truncated */
+EXPORT int get_perf_stats(char *, int);
+EXPORT int reset_perf_stats();
+
+/* timeline tracing of init, sequence loading and streaming
+ * enable_trace(1) clears old spans and starts recording; export_trace writes Chrome trace-event JSON */
+EXPORT int enable_trace(int);
+EXPORT int export_trace(const char *);
+
 /* more debug methods */
 EXPORT int save_state_files();
 EXPORT int read_state_files();
 EXPORT int save_bulk_state_file();
 EXPORT int read_bulk_state_file();
 
+/* full device snapshot; an empty file name uses cache_<serial>.h5 */
+EXPORT int save_state_file(int, const char*);
+EXPORT int restore_to_device(int, const char*);
+
 EXPORT int raw_write(int, int, unsigned char*);
 EXPORT int raw_read(int, int);
 EXPORT int read_register(int, int, int);
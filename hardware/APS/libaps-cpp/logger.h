@@ -14,48 +14,81 @@
 #include <sstream>
 #include <string>
 #include <stdio.h>
+#include <ctime>
+#include <cstddef>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
 
-inline std::string NowTime();
+/*
+ * Messages are formatted into a fixed buffer on the calling thread and pushed onto a
+ * preallocated lock-free ring. A background thread adds the wall clock time and writes them
+ * out in batches, so logging only waits on the file if the ring fills up; then the logging
+ * thread drains the ring itself rather than lose messages.
+ * The writer is never destroyed: joining its thread from a static destructor deadlocks when the
+ * library is unloaded, so Shutdown stops it explicitly and later messages are written synchronously.
+ * Levels above FILELOG_MAX_LEVEL are compiled out.
+ */
 
 enum TLogLevel {logERROR, logWARNING, logINFO, logDEBUG, logDEBUG1, logDEBUG2, logDEBUG3, logDEBUG4};
 
+//Longest message kept; longer ones are truncated
+static const size_t LOG_MESSAGE_LENGTH = 496;
+//Number of messages the ring holds; must be a power of two
+static const size_t LOG_RING_LENGTH = 2048;
+
+//Fixed size stream buffer so formatting a message doesn't allocate
+class LogBuffer : public std::streambuf
+{
+public:
+    LogBuffer() {setp(buffer_, buffer_ + LOG_MESSAGE_LENGTH);};
+    const char* data() const {return pbase();};
+    size_t length() const {return pptr() - pbase();};
+private:
+    char buffer_[LOG_MESSAGE_LENGTH];
+};
+
 template <typename T>
 class Log
 {
 public:
     Log();
     virtual ~Log();
-    std::ostringstream& Get(TLogLevel level = logINFO);
+    std::ostream& Get(TLogLevel level = logINFO);
 public:
     static TLogLevel& ReportingLevel();
     static std::string ToString(TLogLevel level);
     static TLogLevel FromString(const std::string& level);
 protected:
-    std::ostringstream os;
+    LogBuffer buffer;
+    std::ostream os;
+    TLogLevel messageLevel;
+    std::chrono::steady_clock::rep ticks;
 private:
     Log(const Log&);
     Log& operator =(const Log&);
 };
 
 template <typename T>
-Log<T>::Log()
+Log<T>::Log() : os(&buffer), messageLevel(logINFO), ticks(0)
 {
 }
 
 template <typename T>
-std::ostringstream& Log<T>::Get(TLogLevel level)
+std::ostream& Log<T>::Get(TLogLevel level)
 {
-    os << "- " << NowTime();
-    os << " " << ToString(level) << ": ";
-    os << std::string(level > logDEBUG ? level - logDEBUG : 0, '\t');
+    //Only the timestamp is taken here; the writer thread formats it
+    messageLevel = level;
+    ticks = std::chrono::steady_clock::now().time_since_epoch().count();
     return os;
 }
 
 template <typename T>
 Log<T>::~Log()
 {
-    os << std::endl;
-    T::Output(os.str());
+    T::Output(messageLevel, ticks, buffer.data(), buffer.length());
 }
 
 template <typename T>
@@ -95,26 +128,225 @@ TLogLevel Log<T>::FromString(const std::string& level)
     return logINFO;
 }
 
+//Bounded multi-producer single-consumer ring of messages (Vyukov's bounded queue)
+class LogRing
+{
+public:
+    struct Record {
+        std::atomic<size_t> sequence;
+        std::chrono::steady_clock::rep ticks;
+        TLogLevel level;
+        size_t length;
+        char text[LOG_MESSAGE_LENGTH];
+    };
+
+    LogRing() : head_(0), tail_(0)
+    {
+        for (size_t ct = 0; ct < LOG_RING_LENGTH; ct++)
+            records_[ct].sequence.store(ct, std::memory_order_relaxed);
+    }
+
+    bool push(TLogLevel level, std::chrono::steady_clock::rep ticks, const char* text, size_t length)
+    {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        Record* record;
+        for (;;) {
+            record = &records_[pos & (LOG_RING_LENGTH - 1)];
+            size_t sequence = record->sequence.load(std::memory_order_acquire);
+            ptrdiff_t diff = static_cast<ptrdiff_t>(sequence) - static_cast<ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+        record->ticks = ticks;
+        record->level = level;
+        record->length = length;
+        std::copy(text, text + length, record->text);
+        record->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    //Oldest message or nullptr if there is none; only the writer calls this
+    const Record* front() const
+    {
+        const Record* record = &records_[tail_ & (LOG_RING_LENGTH - 1)];
+        return (record->sequence.load(std::memory_order_acquire) == tail_ + 1) ? record : nullptr;
+    }
+
+    void pop()
+    {
+        records_[tail_ & (LOG_RING_LENGTH - 1)].sequence.store(tail_ + LOG_RING_LENGTH, std::memory_order_release);
+        tail_++;
+    }
+
+
+private:
+    Record records_[LOG_RING_LENGTH];
+    std::atomic<size_t> head_;
+    size_t tail_;
+};
+
 class Output2FILE
 {
 public:
-    static FILE*& Stream();
-    static void Output(const std::string& msg);
+    //Atomic since loggers check it without a lock while Redirect changes it
+    static std::atomic<FILE*>& Stream();
+    static void Output(TLogLevel level, std::chrono::steady_clock::rep ticks, const char* text, size_t length);
+    //Write out everything queued so far
+    static void Flush();
+    //Flush, close the current stream (unless it is stderr) and switch to a new one
+    static void Redirect(FILE* pFile);
+    //Start the background writer if it has been shut down
+    static void Start();
+    //Stop and join the background writer and write out what is left
+    static void Shutdown();
+
+private:
+    struct Writer;
+    static Writer& GetWriter();
+};
+
+//Drains the ring on a background thread
+struct Output2FILE::Writer
+{
+    LogRing ring;
+    //Held while writing so Flush and Redirect can't interleave with the thread
+    std::mutex writeMutex;
+    std::atomic<bool> running;
+    std::thread thread;
+    //Maps steady clock ticks to wall clock time
+    std::chrono::system_clock::time_point wallStart;
+    std::chrono::steady_clock::time_point steadyStart;
+    //Cache of the formatted wall clock second
+    time_t lastSecond;
+    char secondStr[16];
+
+    Writer() : running(false), wallStart(std::chrono::system_clock::now()),
+        steadyStart(std::chrono::steady_clock::now()), lastSecond(-1)
+    {
+        start();
+    }
+
+    //Only called by Start and Shutdown, never concurrently
+    void start()
+    {
+        if (thread.joinable())
+            return;
+        running.store(true);
+        thread = std::thread([this](){
+            while (running.load()) {
+                if (!drain())
+                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+        });
+    }
+
+    void stop()
+    {
+        running.store(false);
+        if (thread.joinable())
+            thread.join();
+        drain();
+    }
+
+    //Write out all queued messages; returns whether there were any
+    bool drain()
+    {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        FILE* pStream = Output2FILE::Stream().load();
+        bool wroteSome = false;
+        const LogRing::Record* record;
+        while ((record = ring.front()) != nullptr) {
+            if (pStream)
+                write_record(pStream, *record);
+            ring.pop();
+            wroteSome = true;
+        }
+        if (pStream && wroteSome)
+            fflush(pStream);
+        return wroteSome;
+    }
+
+    void write_record(FILE* pStream, const LogRing::Record& record)
+    {
+        using namespace std::chrono;
+        system_clock::time_point wallTime = wallStart +
+            duration_cast<system_clock::duration>(steady_clock::duration(record.ticks) - steadyStart.time_since_epoch());
+        time_t second = system_clock::to_time_t(wallTime);
+        if (second != lastSecond) {
+            tm r = tm();
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__)
+            r = *localtime(&second);
+#else
+            localtime_r(&second, &r);
+#endif
+            strftime(secondStr, sizeof(secondStr), "%H:%M:%S", &r);
+            lastSecond = second;
+        }
+        long micros = static_cast<long>(duration_cast<microseconds>(wallTime.time_since_epoch()).count() % 1000000);
+        int indent = record.level > logDEBUG ? record.level - logDEBUG : 0;
+        fprintf(pStream, "- %s.%06ld %s: %.*s%.*s\n", secondStr, micros, Log<Output2FILE>::ToString(record.level).c_str(),
+            indent, "\t\t\t\t", static_cast<int>(record.length), record.text);
+    }
 };
 
-inline FILE*& Output2FILE::Stream()
+inline std::atomic<FILE*>& Output2FILE::Stream()
 {
-    static FILE* pStream = stderr;
+    static std::atomic<FILE*> pStream(stderr);
     return pStream;
 }
 
-inline void Output2FILE::Output(const std::string& msg)
+inline Output2FILE::Writer& Output2FILE::GetWriter()
 {
-    FILE* pStream = Stream();
-    if (!pStream)
-        return;
-    fprintf(pStream, "%s", msg.c_str());
-    fflush(pStream);
+    //Deliberately leaked; see the note at the top
+    static Writer* writer = new Writer();
+    return *writer;
+}
+
+inline void Output2FILE::Output(TLogLevel level, std::chrono::steady_clock::rep ticks, const char* text, size_t length)
+{
+    Writer& writer = GetWriter();
+    if (!writer.ring.push(level, ticks, text, length)) {
+        //The writer has fallen behind so help it out rather than lose the message
+        do {
+            writer.drain();
+        } while (!writer.ring.push(level, ticks, text, length));
+    }
+    //With no writer thread the message goes out straight away
+    if (!writer.running.load())
+        writer.drain();
+}
+
+inline void Output2FILE::Flush()
+{
+    GetWriter().drain();
+}
+
+inline void Output2FILE::Redirect(FILE* pFile)
+{
+    Writer& writer = GetWriter();
+    writer.drain();
+    std::lock_guard<std::mutex> lock(writer.writeMutex);
+    FILE* pStream = Stream().exchange(pFile);
+    if (pStream && pStream != stderr)
+        fclose(pStream);
+}
+
+inline void Output2FILE::Start()
+{
+    GetWriter().start();
+}
+
+inline void Output2FILE::Shutdown()
+{
+    GetWriter().stop();
 }
 
 #if defined(WIN32) || defined(_WIN32) || defined(__WIN32__)
@@ -136,48 +368,12 @@ class FILELOG_DECLSPEC FILELog : public Log<Output2FILE> {};
 #define FILELOG_MAX_LEVEL logDEBUG4
 #endif
 
+//Whether a level would be logged; use to guard work done only for logging
+#define FILE_LOG_ENABLED(level) \
+    ((level) <= FILELOG_MAX_LEVEL && (level) <= FILELog::ReportingLevel() && Output2FILE::Stream().load(std::memory_order_relaxed))
+
 #define FILE_LOG(level) \
-    if (level > FILELOG_MAX_LEVEL) ;\
-    else if (level > FILELog::ReportingLevel() || !Output2FILE::Stream()) ; \
+    if (!FILE_LOG_ENABLED(level)) ; \
     else FILELog().Get(level)
 
-#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__)
-
-#include <windows.h>
-
-inline std::string NowTime()
-{
-    const int MAX_LEN = 200;
-    char buffer[MAX_LEN];
-    if (GetTimeFormatA(LOCALE_USER_DEFAULT, 0, 0,
-            "HH':'mm':'ss", buffer, MAX_LEN) == 0)
-        return "Error in NowTime()";
-
-    char result[100] = {0};
-    static DWORD first = GetTickCount();
-    std::sprintf(result, "%s.%03ld", buffer, (long)(GetTickCount() - first) % 1000);
-    return result;
-}
-
-#else
-
-#include <sys/time.h>
-
-inline std::string NowTime()
-{
-    char buffer[11];
-    time_t t;
-    time(&t);
-    tm r = {0};
-    strftime(buffer, sizeof(buffer), "%X", localtime_r(&t, &r));
-    struct timeval tv;
-    gettimeofday(&tv, 0);
-    char result[100] = {0};
-    sprintf(result, "%s.%03ld", buffer, (long)tv.tv_usec / 1000);
-    return result;
-}
-
-#endif //WIN32
-
-
 #endif /* LOGGER_H_ */
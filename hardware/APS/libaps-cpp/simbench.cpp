@@ -0,0 +1,139 @@
+/*
+ * simbench.cpp
+ *
+ * End to end benchmarks of libaps against the simulated FTDI driver (see ftd2xx_sim.h).
+ * Everything goes through the C API so the timings cover the same code paths MATLAB and
+ * Python use. No APS needs to be attached.
+ *
+ * Usage: simbench [sequenceDir] [streamSeconds]
+ * sequenceDir holds Ramsey.h5 (defaults to the examples directory)
+ * UnitTest.h5 isn't loaded since it predates the isIQMode and miniLLRepeat attributes libaps needs
+ * Prints CSV: scenario, status, wall ms, CPU ms, USB bytes out, USB bytes in, USB writes, round trips, bus busy ms
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "headings.h"
+#include "libaps.h"
+#include "ftd2xx_sim.h"
+
+#include <ctime>
+
+typedef std::chrono::steady_clock BenchClock;
+
+//Synthetic bitfiles about the size of the APS ones
+static const size_t BITFILE_SIZE = 1 << 20;
+static const char * BITFILE_BASE = "simbench";
+
+template <typename F>
+static int run_scenario(const string & scenario, F op){
+	FT_SimResetCounters();
+	BenchClock::time_point start = BenchClock::now();
+	std::clock_t cpuStart = std::clock();
+	int status = op();
+	double CPUTime = static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+	double wallTime = std::chrono::duration<double>(BenchClock::now() - start).count();
+	FTSimCounters counters;
+	FT_SimGetCounters(&counters);
+	cout << scenario << ", " << status << ", " << 1e3*wallTime << ", " << 1e3*CPUTime << ", " << counters.bytesWritten << ", "
+			<< counters.bytesRead << ", " << counters.writes << ", " << counters.reads << ", " << 1e3*counters.busyTime << endl;
+	return status;
+}
+
+static int write_bitfiles(){
+	srand(42);
+	for (const char * fpga : {"_FPGA1.bit", "_FPGA2.bit"}){
+		std::ofstream bitFile(string(BITFILE_BASE) + fpga, std::ios::binary);
+		for (size_t ct = 0; ct < BITFILE_SIZE; ct++){
+			bitFile.put(static_cast<char>(rand()));
+		}
+		if (!bitFile.good()) return -1;
+	}
+	return 0;
+}
+
+//IQ mode LL of miniLLs 10 to 200 entries long
+static void make_LL(const size_t & numEntries, WordVec & addr, WordVec & count, WordVec & trigger1, WordVec & trigger2, WordVec & repeat){
+	srand(42);
+	while (addr.size() < numEntries){
+		size_t miniLLLength = std::min(numEntries - addr.size(), static_cast<size_t>(10 + rand() % 190));
+		for (size_t ct = 0; ct < miniLLLength; ct++){
+			addr.push_back(static_cast<USHORT>(ct % 64));
+			count.push_back(3);
+			trigger1.push_back(0);
+			trigger2.push_back(0);
+			USHORT repeatWord = 0;
+			if (ct == 0) repeatWord |= (1 << 15);
+			if (ct == miniLLLength-1) repeatWord |= (1 << 14);
+			repeat.push_back(repeatWord);
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	string sequenceDir = (argc > 1) ? string(argv[1]) + "/" : "";
+	double streamTime = (argc > 2) ? atof(argv[2]) : 2.0;
+	string ramseyFile = sequenceDir.empty() ? "../examples/Ramsey.h5" : sequenceDir + "Ramsey.h5";
+
+	if (write_bitfiles() != 0){
+		cout << "Unable to write the synthetic bitfiles" << endl;
+		return -1;
+	}
+
+	cout << "scenario, status, wall ms, CPU ms, USB bytes out, USB bytes in, USB writes, round trips, bus busy ms" << endl;
+	int status = 0;
+	status |= run_scenario("connect", [](){
+		init();
+		set_logging_level(logWARNING);
+		return connect_by_ID(0);
+	});
+	status |= run_scenario("init", [](){
+		char bitFile[64];
+		snprintf(bitFile, sizeof(bitFile), "%s", BITFILE_BASE);
+		return initAPS(0, bitFile, 1);
+	});
+	status |= run_scenario("load_sequence_file Ramsey.h5", [&](){ return load_sequence_file(0, ramseyFile.c_str()); });
+
+	//Waveforms of every size on all four channels
+	for (int numPts = 1024; numPts <= MAX_WF_LENGTH; numPts *= 2){
+		vector<float> waveform(numPts);
+		for (int ct = 0; ct < numPts; ct++){
+			waveform[ct] = 0.9f*std::sin(2*M_PI*ct/256.0);
+		}
+		status |= run_scenario("waveform_sweep " + std::to_string(numPts), [&](){
+			int sweepStatus = 0;
+			for (int chan = 0; chan < 4; chan++){
+				sweepStatus |= set_waveform_float(0, chan, waveform.data(), numPts);
+			}
+			return sweepStatus;
+		});
+	}
+
+	//Stream an LL too long for the device memory with a trigger every 100us
+	WordVec addr, count, trigger1, trigger2, repeat;
+	make_LL(8*MAX_LL_LENGTH, addr, count, trigger1, trigger2, repeat);
+	status |= run_scenario("set_LL_data_IQ " + std::to_string(addr.size()), [&](){
+		int LLStatus = 0;
+		for (int chan : {0, 2}){
+			LLStatus |= set_LL_data_IQ(0, chan, addr.size(), addr.data(), count.data(), trigger1.data(), trigger2.data(), repeat.data());
+		}
+		return LLStatus;
+	});
+	status |= run_scenario("stream " + std::to_string(streamTime) + " s", [&](){
+		int streamStatus = set_trigger_interval(0, 100e-6);
+		for (int chan = 0; chan < 4; chan++){
+			streamStatus |= set_channel_enabled(0, chan, 1);
+			streamStatus |= set_run_mode(0, chan, RUN_SEQUENCE);
+		}
+		streamStatus |= run(0);
+		std::this_thread::sleep_for(std::chrono::duration<double>(streamTime));
+		streamStatus |= stop(0);
+		return streamStatus;
+	});
+	status |= run_scenario("disconnect", [](){ return disconnect_by_ID(0); });
+
+	for (const char * fpga : {"_FPGA1.bit", "_FPGA2.bit"}){
+		std::remove((string(BITFILE_BASE) + fpga).c_str());
+	}
+	return status;
+}
@@ -203,6 +203,56 @@ void test::getSetTriggerInterval(){
 	printf("Set trigger interval to 10e-3. Read back: %f\n", interval);
 }
 
+int test::longLLIndexing(){
+	//Host side check that LL indices past 16 bits survive miniLL bookkeeping and wrap-around
+	const size_t numMiniLLs = 100;
+	const size_t miniLLLength = 1000;
+	WordVec addr, count, trigger, repeat;
+	for (size_t miniLLct = 0; miniLLct < numMiniLLs; miniLLct++){
+		for (size_t ct = 0; ct < miniLLLength; ct++){
+			addr.push_back(static_cast<USHORT>(miniLLct));
+			count.push_back(static_cast<USHORT>(ct));
+			trigger.push_back(0);
+			USHORT repeatWord = 0;
+			if (ct == 0) repeatWord |= (1 << 15);
+			if (ct == miniLLLength-1) repeatWord |= (1 << 14);
+			repeat.push_back(repeatWord);
+		}
+	}
+	LLBank bank(addr, count, trigger, repeat);
+
+	int failures = 0;
+	if (bank.length != numMiniLLs*miniLLLength || bank.numMiniLLs != numMiniLLs){
+		cout << "Wrong LL length or miniLL count: " << bank.length << " " << bank.numMiniLLs << endl;
+		failures++;
+	}
+	for (size_t miniLLct = 0; miniLLct < bank.numMiniLLs; miniLLct++){
+		if (bank.miniLLStartIdx[miniLLct] != miniLLct*miniLLLength){
+			cout << "Wrong start index for miniLL " << miniLLct << ": " << bank.miniLLStartIdx[miniLLct] << endl;
+			failures++;
+		}
+	}
+
+	//A read across the end of the bank should equal the two halves stitched together
+	size_t startIdx = bank.length - 10;
+	WordVec wrapped = bank.get_packed_data(startIdx, 10);
+	WordVec tail = bank.get_packed_data(startIdx, bank.length);
+	WordVec head = bank.get_packed_data(0, 10);
+	tail.insert(tail.end(), head.begin(), head.end());
+	if (wrapped != tail || wrapped.size() != 20*4){
+		cout << "Wrapped read does not match" << endl;
+		failures++;
+	}
+
+	if (moddiff(10, startIdx, bank.length) != 20 || moddiff(1, 0, 3) != 1 || moddiff(0, 1, 3) != 2){
+		cout << "Modular distance is wrong" << endl;
+		failures++;
+	}
+
+	cout << "Long LL indexing test: " << (failures ? "FAILED" : "passed") << endl;
+	return failures;
+}
+
 void test::printHelp(){
 	string spacing = "   ";
 	cout << "BBN APS C++ Test Bench" << endl;
@@ -220,6 +270,7 @@ void test::printHelp(){
 	cout << spacing << "-trig Get/Set trigger interval" << endl;
 	cout << spacing << "-seq Load sequence file" << endl;
 	cout << spacing << "-offset Set offset and scale" << endl;
+	cout << spacing << "-llidx Long LL indexing test (no device needed)" << endl;
 }
 
 // command options functions taken from:
@@ -251,6 +302,10 @@ int main(int argc, char** argv) {
 		return 0;
 	}
 
+	if (cmdOptionExists(argv, argv + argc, "-llidx")) {
+		return test::longLLIndexing();
+	}
+
 	int device_id = atoi(argv[1]);
 
 	string bitFile = getCmdOption(argv, argv + argc, "-b");
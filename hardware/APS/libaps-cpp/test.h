@@ -15,6 +15,7 @@ namespace test {
 	void doBulkStateFileTest();
 	void doStateFilesTest();
 	void getSetTriggerInterval();
+	int longLLIndexing();
 
 	void printHelp();
 
@@ -18,6 +18,7 @@ import ctypes
 import platform
 import sys
 import os
+import json
 
 import numpy as np
 import h5py
@@ -169,20 +170,14 @@ class APS (object):
             print 'APS unit is not open'
             return -1
             
-        if waveform.dtype == np.dtype('int16') or waveform.dtype == np.dtype('int32'):
+        # int16, float32 and float64 arrays (including strided views) are read in place by the library
+        elementTypes = {np.dtype('int16'): 0, np.dtype('float32'): 1, np.dtype('float64'): 2}
+        if waveform.dtype == np.dtype('int32'):
             waveform = waveform.astype('int16')
-            c_int_p = ctypes.POINTER(ctypes.c_int16)
-            waveform_p = waveform.ctypes.data_as(c_int_p) 
-            val = self.librarycall('set_waveform_int', ch-1, waveform_p, waveform.size)
-            
-        elif waveform.dtype == np.dtype('float32') or waveform.dtype == np.dtype('float64'):
-            # libaps-cpp expects float rather than double
-            waveform = waveform.astype('float32')
-            c_float_p = ctypes.POINTER(ctypes.c_float)
-            waveform_p = waveform.ctypes.data_as(c_float_p)
-            val = self.librarycall('set_waveform_float', ch-1, waveform_p, waveform.size)
-        else:
-            raise NameError('Unhandled waveform data type. Use int16 or float64')
+        if waveform.ndim != 1 or waveform.dtype not in elementTypes:
+            raise NameError('Unhandled waveform data type. Use a 1D int16 or float64 array')
+        stride = waveform.strides[0] // waveform.itemsize
+        val = self.librarycall('set_waveform_strided', ch-1, ctypes.c_void_p(waveform.ctypes.data), waveform.size, stride, elementTypes[waveform.dtype])
 
         self.set_enabled(ch, True)
 
@@ -297,6 +292,23 @@ class APS (object):
     def set_enabled(self, ch, enabled):
         return self.librarycall('set_channel_enabled', ch-1, enabled)
         
+    def set_channel_params(self, chs, offsets=None, amplitudes=None, enables=None):
+        '''
+        Set offset, amplitude and enabled for several channels in one call and one USB transaction.
+        Any of offsets, amplitudes or enables can be None to leave that setting alone.
+        '''
+        chs = np.ascontiguousarray(chs, dtype=np.int32) - 1
+        def as_pointer(values, dtype, ctype):
+            if values is None:
+                return None, None
+            values = np.ascontiguousarray(values, dtype=dtype)
+            return values, values.ctypes.data_as(ctypes.POINTER(ctype))
+        offsets, offsets_p = as_pointer(offsets, np.float32, ctypes.c_float)
+        amplitudes, amplitudes_p = as_pointer(amplitudes, np.float32, ctypes.c_float)
+        enables, enables_p = as_pointer(enables, np.int32, ctypes.c_int)
+        chs_p = chs.ctypes.data_as(ctypes.POINTER(ctypes.c_int))
+        return self.librarycall('set_channel_params', chs.size, chs_p, offsets_p, amplitudes_p, enables_p)
+
     def set_trigger_delay(self, ch, delay):
         return self.librarycall('set_channel_trigDelay', ch-1, delay)
 
@@ -315,10 +327,11 @@ class APS (object):
         
         #First load all the channel offsets, scalings, enabled
         CHANNELNAMES = ('chan_1','chan_2','chan_3','chan_4')
+        self.set_channel_params(range(1,5),
+                                offsets=[settings[channelName]['offset'] for channelName in CHANNELNAMES],
+                                amplitudes=[settings[channelName]['amplitude'] for channelName in CHANNELNAMES],
+                                enables=[settings[channelName]['enabled'] for channelName in CHANNELNAMES])
         for ch, channelName in enumerate(CHANNELNAMES):
-            self.set_amplitude(ch+1, settings[channelName]['amplitude'])
-            self.set_offset(ch+1, settings[channelName]['offset'])
-            self.set_enabled(ch+1, settings[channelName]['enabled'])
             self.setRunMode(ch+1, settings['runMode'])
             if 'seqfile' in settings[channelName] and settings[channelName]['seqfile']:
                 self.load_waveform_from_file(ch+1, settings[channelName]['seqfile'])
@@ -335,6 +348,30 @@ class APS (object):
         set logging level (info = 2, debug = 3, debug1 = 4, debug2 = 5)
         '''
         self.lib.set_logging_level(level)
+
+    def get_perf_stats(self):
+        '''
+        per operation call counts, bytes, USB transfers and latency percentiles (ns) for all units
+        '''
+        length = self.lib.get_perf_stats(None, 0)
+        statsBuffer = ctypes.create_string_buffer(length + 1)
+        self.lib.get_perf_stats(statsBuffer, length + 1)
+        return json.loads(statsBuffer.value)
+
+    def reset_perf_stats(self):
+        self.lib.reset_perf_stats()
+
+    def enable_trace(self, enable=True):
+        '''
+        record a timeline of init, sequence loading and streaming for all units
+        '''
+        self.lib.enable_trace(int(enable))
+
+    def export_trace(self, filename):
+        '''
+        write the recorded timeline as Chrome trace-event JSON (open in chrome://tracing)
+        '''
+        return self.lib.export_trace(filename)
     
     def librarycall(self, functionName,  *args):
         if not self.is_open: